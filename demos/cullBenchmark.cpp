@@ -0,0 +1,159 @@
+#include "vrb/CameraSimple.h"
+#include "vrb/CompiledScene.h"
+#include "vrb/CreationContext.h"
+#include "vrb/CullVisitor.h"
+#include "vrb/CullWorkerPool.h"
+#include "vrb/DrawableList.h"
+#include "vrb/Geometry.h"
+#include "vrb/Group.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/RenderContext.h"
+#include "vrb/Toggle.h"
+#include "vrb/Transform.h"
+#include "vrb/Vector.h"
+#include "vrb/VertexArray.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+// Compares culling a scene graph through Group::Cull with CompiledScene::Cull, and
+// a full CompiledScene compile with an incremental one. Group::Cull has no frustum
+// culling, so it is compared with a CompiledScene without a frustum camera; the
+// frustum culled and animated timings are listed on their own. CullWorkerPool::Cull
+// is timed for each power of two thread count up to the number of online cores, or
+// the second argument. No GL context is needed.
+
+static double
+Milliseconds(const std::chrono::steady_clock::time_point& aStart) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+static vrb::GeometryPtr
+CreateCube(vrb::CreationContextPtr& aContext) {
+  vrb::VertexArrayPtr array = vrb::VertexArray::Create(aContext);
+  for (int ix = 0; ix < 8; ix++) {
+    array->AppendVertex(vrb::Vector(ix & 1 ? 0.5f : -0.5f, ix & 2 ? 0.5f : -0.5f, ix & 4 ? 0.5f : -0.5f));
+  }
+  vrb::GeometryPtr geometry = vrb::Geometry::Create(aContext);
+  geometry->SetVertexArray(array);
+  const int faces[6][4] = {{1, 2, 4, 3}, {5, 7, 8, 6}, {1, 5, 6, 2}, {3, 4, 8, 7}, {1, 3, 7, 5}, {2, 6, 8, 4}};
+  for (const auto& face: faces) {
+    std::vector<int> vertices(face, face + 4);
+    std::vector<int> empty;
+    geometry->AddFace(vertices, empty, empty);
+  }
+  return geometry;
+}
+
+int
+main(int argc, char* argv[]) {
+  const int kRows = argc > 1 ? atoi(argv[1]) : 100;
+  const int kFrames = 100;
+  vrb::RenderContextPtr render = vrb::RenderContext::Create();
+  vrb::CreationContextPtr create = render->GetRenderThreadCreationContext();
+
+  // A grid of rows of transformed cubes in front of the camera, half of it outside
+  // of the frustum.
+  vrb::TogglePtr root = vrb::Toggle::Create(create);
+  std::vector<vrb::TransformPtr> rows;
+  for (int row = 0; row < kRows; row++) {
+    vrb::TransformPtr rowTransform = vrb::Transform::Create(create);
+    rowTransform->SetTransform(vrb::Matrix::Translation(vrb::Vector(0.0f, (float)(row - (kRows / 2)), -50.0f)));
+    for (int column = 0; column < kRows; column++) {
+      vrb::TransformPtr transform = vrb::Transform::Create(create);
+      transform->SetTransform(vrb::Matrix::Translation(vrb::Vector((float)column * 2.0f, 0.0f, 0.0f)));
+      transform->AddNode(CreateCube(create));
+      rowTransform->AddNode(transform);
+    }
+    root->AddNode(rowTransform);
+    rows.push_back(rowTransform);
+  }
+
+  vrb::CameraSimplePtr camera = vrb::CameraSimple::Create(create);
+  camera->SetViewport(1000, 1000);
+  camera->SetFieldOfView(60.0f, 60.0f);
+  camera->SetClipRange(0.1f, 1000.0f);
+  vrb::CullVisitorPtr visitor = vrb::CullVisitor::Create(create);
+  vrb::DrawableListPtr drawables = vrb::DrawableList::Create(create);
+  vrb::CompiledScenePtr scene = vrb::CompiledScene::Create(create);
+  scene->SetRoot(root);
+  vrb::CompiledScenePtr frustumScene = vrb::CompiledScene::Create(create);
+  frustumScene->SetRoot(root);
+  frustumScene->SetFrustumCamera(camera);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    drawables->Reset();
+    root->Cull(*visitor, *drawables);
+  }
+  const double kGroupCull = Milliseconds(start) / kFrames;
+  const uint32_t kGroupDrawables = drawables->GetStats().drawables;
+
+  // The calling thread culls too, so a pool of N - 1 workers uses N threads.
+  std::vector<int> threadCounts;
+  std::vector<double> poolCulls;
+  const int kMaxThreads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for (int threads = 2; threads <= kMaxThreads; threads *= 2) {
+    vrb::CullWorkerPoolPtr pool = vrb::CullWorkerPool::Create(create, threads - 1);
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; frame++) {
+      drawables->Reset();
+      pool->Cull(*root, *visitor, *drawables);
+    }
+    threadCounts.push_back(threads);
+    poolCulls.push_back(Milliseconds(start) / kFrames);
+  }
+
+  start = std::chrono::steady_clock::now();
+  scene->Compile();
+  const double kFullCompile = Milliseconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    drawables->Reset();
+    scene->Cull(*visitor, *drawables);
+  }
+  const double kSceneCull = Milliseconds(start) / kFrames;
+  const uint32_t kSceneDrawables = drawables->GetStats().drawables;
+
+  frustumScene->Compile();
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    drawables->Reset();
+    frustumScene->Cull(*visitor, *drawables);
+  }
+  const double kFrustumCull = Milliseconds(start) / kFrames;
+  const uint32_t kFrustumDrawables = drawables->GetStats().drawables;
+
+  // One row moves every frame, the world transforms of the other rows stay valid.
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    const int kRow = frame % kRows;
+    rows[kRow]->SetTransform(vrb::Matrix::Translation(vrb::Vector((float)(frame % 3), (float)(kRow - (kRows / 2)), -50.0f)));
+    drawables->Reset();
+    frustumScene->Cull(*visitor, *drawables);
+  }
+  const double kAnimatedCull = Milliseconds(start) / kFrames;
+
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    root->ToggleChild(*rows[frame % kRows], (frame % 2) != 0);
+    scene->Compile();
+  }
+  const double kIncrementalCompile = Milliseconds(start) / kFrames;
+
+  VRB_LOG("%d nodes, %d frames", scene->GetNodeCount(), kFrames);
+  VRB_LOG("Group::Cull          %8.3f ms %u drawables", kGroupCull, kGroupDrawables);
+  for (size_t ix = 0; ix < threadCounts.size(); ix++) {
+    VRB_LOG("CullWorkerPool %2d    %8.3f ms %.2fx", threadCounts[ix], poolCulls[ix], kGroupCull / poolCulls[ix]);
+  }
+  VRB_LOG("CompiledScene::Cull  %8.3f ms %u drawables", kSceneCull, kSceneDrawables);
+  VRB_LOG("With frustum culling %8.3f ms %u drawables", kFrustumCull, kFrustumDrawables);
+  VRB_LOG("One row moving       %8.3f ms", kAnimatedCull);
+  VRB_LOG("Full compile         %8.3f ms", kFullCompile);
+  VRB_LOG("Incremental compile  %8.3f ms after toggling one row", kIncrementalCompile);
+  return 0;
+}
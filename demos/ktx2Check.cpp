@@ -0,0 +1,217 @@
+#include "vrb/DataBuffer.h"
+#include "vrb/FileReaderBasic.h"
+#include "vrb/ImageTranscoderZlib.h"
+#include "vrb/Logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+// Checks that FileReaderBasic loads KTX2 files with the level sizes their dimensions
+// require, that ImageTranscoderZlib inflates zlib supercompressed files and that the
+// default FileHandler::ProcessImageLevels() passes the pixel format of uncompressed
+// images. No GL context is needed. Returns non-zero when a check fails.
+
+static int sFailures = 0;
+
+static void
+Check(const bool aCondition, const char* aMessage) {
+  if (!aCondition) {
+    VRB_ERROR("FAILED: %s", aMessage);
+    sFailures++;
+  }
+}
+
+static void
+Put32(std::vector<uint8_t>& aFile, const size_t aOffset, const uint32_t aValue) {
+  memcpy(&aFile[aOffset], &aValue, sizeof(aValue));
+}
+
+static void
+Put64(std::vector<uint8_t>& aFile, const size_t aOffset, const uint64_t aValue) {
+  memcpy(&aFile[aOffset], &aValue, sizeof(aValue));
+}
+
+// Pixels of every level of a aWidth by aHeight image, each level one after another.
+static std::vector<std::vector<uint8_t>>
+CreateLevels(const uint32_t aWidth, const uint32_t aHeight, const uint32_t aLevels, const uint32_t aBytesPerPixel) {
+  std::vector<std::vector<uint8_t>> result;
+  for (uint32_t level = 0; level < aLevels; level++) {
+    const uint32_t kWidth = std::max(aWidth >> level, 1u);
+    const uint32_t kHeight = std::max(aHeight >> level, 1u);
+    std::vector<uint8_t> pixels(kWidth * kHeight * aBytesPerPixel);
+    for (size_t ix = 0; ix < pixels.size(); ix++) {
+      pixels[ix] = (uint8_t)((level * 50) + ix);
+    }
+    result.push_back(pixels);
+  }
+  return result;
+}
+
+// Writes a 2D KTX2 file, compressing each level with zlib when aZlib is set.
+static std::string
+WriteKTX2(const std::string& aPath, const uint32_t aVkFormat, const uint32_t aWidth, const uint32_t aHeight,
+          const std::vector<std::vector<uint8_t>>& aLevels, const bool aZlib) {
+  const uint8_t kIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+  std::vector<uint8_t> file(80 + (aLevels.size() * 24), 0);
+  memcpy(file.data(), kIdentifier, sizeof(kIdentifier));
+  Put32(file, 12, aVkFormat);
+  Put32(file, 20, aWidth);
+  Put32(file, 24, aHeight);
+  Put32(file, 36, 1);
+  Put32(file, 40, (uint32_t)aLevels.size());
+  Put32(file, 44, aZlib ? 3 : 0);
+  for (size_t level = 0; level < aLevels.size(); level++) {
+    std::vector<uint8_t> data = aLevels[level];
+    if (aZlib) {
+      uLongf length = compressBound((uLong)data.size());
+      std::vector<uint8_t> compressed(length);
+      compress(compressed.data(), &length, data.data(), (uLong)data.size());
+      compressed.resize(length);
+      data.swap(compressed);
+    }
+    Put64(file, 80 + (level * 24), file.size());
+    Put64(file, 80 + (level * 24) + 8, data.size());
+    Put64(file, 80 + (level * 24) + 16, aLevels[level].size());
+    file.insert(file.end(), data.begin(), data.end());
+  }
+  FILE* output = fopen(aPath.c_str(), "wb");
+  if (output) {
+    fwrite(file.data(), 1, file.size(), output);
+    fclose(output);
+  }
+  return aPath;
+}
+
+class Handler : public vrb::FileHandler {
+public:
+  // Forwards ProcessImageLevels() to the default implementation when set.
+  bool useDefault = false;
+  bool failed = false;
+  vrb::DataBufferPtr image;
+  vrb::ImageLayout layout;
+  GLenum imageFormat = 0;
+  uint64_t imageLength = 0;
+
+  void Reset() {
+    failed = false;
+    image = nullptr;
+    layout = vrb::ImageLayout();
+    imageFormat = 0;
+    imageLength = 0;
+  }
+  void BindFileHandle(const std::string& aFileName, const int aFileHandle) override {}
+  void LoadFailed(const int aFileHandle, const std::string& aReason) override { failed = true; }
+  void ProcessRawFileChunk(const int aFileHandle, const char* aBuffer, const size_t aSize) override {}
+  void FinishRawFile(const int aFileHandle) override {}
+  void ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength,
+                        const int aWidth, const int aHeight, const GLenum aFormat) override {
+    imageFormat = aFormat;
+    imageLength = aImageLength;
+  }
+  void ProcessImageLevels(const int aFileHandle, const vrb::DataBufferPtr& aImage, const vrb::ImageLayout& aLayout) override {
+    if (useDefault) {
+      vrb::FileHandler::ProcessImageLevels(aFileHandle, aImage, aLayout);
+      return;
+    }
+    image = aImage;
+    layout = aLayout;
+  }
+  Handler() {}
+  ~Handler() {}
+};
+
+static bool
+SameLevels(const Handler& aHandler, const std::vector<std::vector<uint8_t>>& aLevels) {
+  if (!aHandler.image || (aHandler.layout.levels.size() != aLevels.size())) {
+    return false;
+  }
+  for (size_t ix = 0; ix < aLevels.size(); ix++) {
+    const vrb::ImageLayout::Level& level = aHandler.layout.levels[ix];
+    if ((level.size != aLevels[ix].size()) || (memcmp(aHandler.image->GetData() + level.offset, aLevels[ix].data(), level.size) != 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char* argv[]) {
+  char root[] = "/tmp/vrb_ktx2_XXXXXX";
+  if (!mkdtemp(root)) {
+    VRB_ERROR("Unable to create a temporary directory");
+    return 1;
+  }
+  const std::string kRoot = root;
+  vrb::FileReaderBasicPtr reader = vrb::FileReaderBasic::Create();
+  std::shared_ptr<Handler> handler = std::make_shared<Handler>();
+
+  // RGB8 rows of 5 pixels are not a multiple of four bytes.
+  const std::vector<std::vector<uint8_t>> kRGB = CreateLevels(5, 3, 3, 3);
+  const std::string kRGBPath = WriteKTX2(kRoot + "/rgb.ktx2", 23, 5, 3, kRGB, false);
+  reader->ReadImageFile(kRGBPath, handler);
+  Check(!handler->failed && SameLevels(*handler, kRGB), "RGB8 levels load");
+  Check(handler->layout.format == GL_RGB, "RGB8 levels are GL_RGB");
+
+  std::vector<std::vector<uint8_t>> truncated = kRGB;
+  truncated[1].pop_back();
+  handler->Reset();
+  reader->ReadImageFile(WriteKTX2(kRoot + "/short.ktx2", 23, 5, 3, truncated, false), handler);
+  Check(handler->failed && !handler->image, "a level smaller than its dimensions is rejected");
+
+  // zlib supercompressed levels need the transcoder.
+  const std::vector<std::vector<uint8_t>> kRGBA = CreateLevels(8, 4, 4, 4);
+  const std::string kZlibPath = WriteKTX2(kRoot + "/zlib.ktx2", 37, 8, 4, kRGBA, true);
+  handler->Reset();
+  reader->ReadImageFile(kZlibPath, handler);
+  Check(handler->failed, "zlib levels fail without a transcoder");
+  reader->SetTranscoder(vrb::ImageTranscoderZlib::Create());
+  handler->Reset();
+  reader->ReadImageFile(kZlibPath, handler);
+  Check(!handler->failed && SameLevels(*handler, kRGBA), "zlib levels are inflated");
+  Check(!handler->layout.compressed && (handler->layout.internalFormat == GL_RGBA), "zlib levels keep their format");
+
+  std::vector<std::vector<uint8_t>> wrongLength = kRGBA;
+  wrongLength[2].push_back(0);
+  handler->Reset();
+  reader->ReadImageFile(WriteKTX2(kRoot + "/zlibLength.ktx2", 37, 8, 4, wrongLength, true), handler);
+  Check(handler->failed && !handler->image, "zlib levels of the wrong size are rejected");
+
+  // Flipping the last byte breaks the checksum of the last level.
+  const std::string kCorruptPath = WriteKTX2(kRoot + "/corrupt.ktx2", 37, 8, 4, kRGBA, true);
+  FILE* corrupt = fopen(kCorruptPath.c_str(), "r+b");
+  if (corrupt) {
+    fseek(corrupt, -1, SEEK_END);
+    const int kLast = fgetc(corrupt);
+    fseek(corrupt, -1, SEEK_END);
+    fputc(kLast ^ 0xff, corrupt);
+    fclose(corrupt);
+  }
+  handler->Reset();
+  reader->ReadImageFile(kCorruptPath, handler);
+  Check(handler->failed && !handler->image, "corrupt zlib levels are rejected");
+
+  // The default ProcessImageLevels() hands the pixel format, not the sized format, to
+  // ProcessImageFile().
+  const std::string kSRGBPath = WriteKTX2(kRoot + "/srgb.ktx2", 43, 8, 4, kRGBA, false);
+  handler->useDefault = true;
+  handler->Reset();
+  reader->ReadImageFile(kSRGBPath, handler);
+  Check(!handler->failed && (handler->imageFormat == GL_RGBA) && (handler->imageLength == kRGBA[0].size()),
+        "default ProcessImageLevels passes GL_RGBA for sRGB levels");
+  handler->Reset();
+  reader->ReadImageFile(kRGBPath, handler);
+  Check(!handler->failed && (handler->imageFormat == GL_RGB), "default ProcessImageLevels passes GL_RGB");
+
+  for (const char* name: {"rgb", "short", "zlib", "zlibLength", "corrupt", "srgb"}) {
+    remove((kRoot + "/" + name + ".ktx2").c_str());
+  }
+  rmdir(root);
+  VRB_LOG("KTX2 checks %s", sFailures ? "FAILED" : "passed");
+  return sFailures ? 1 : 0;
+}
@@ -97,22 +97,13 @@ main(int argc, char* argv[]) {
 
   vrb::Vector min = vrb::Vector::Max();
   vrb::Vector max = vrb::Vector::Min();
-  vrb::NodePtr node = root;
-  vrb::Node::Traverse(node, [&min, &max](const vrb::NodePtr& aNode, const vrb::GroupPtr& aTraversingFrom) -> bool {
-    const vrb::GeometryPtr geo = std::dynamic_pointer_cast<vrb::Geometry>(aNode);
-    if (geo) {
-      vrb::VertexArrayPtr verts = geo->GetVertexArray();
-      if (verts) {
-        const int size = verts->GetVertexCount();
-        for (int index = 0; index < size; index++) {
-           const vrb::Vector& vertex = verts->GetVertex(index);
-           min.ContractInPlace(vertex);
-           max.ExpandInPlace(vertex);
-        }
-      }
+  vrb::Node::Visit(*root, vrb::Node::KindGeometry, [&min, &max](vrb::Node& aNode) -> vrb::Node::TraverseResult {
+    vrb::Vector geoMin, geoMax;
+    if (static_cast<vrb::Geometry&>(aNode).GetBounds(geoMin, geoMax)) {
+      min.ContractInPlace(geoMin);
+      max.ExpandInPlace(geoMax);
     }
-
-    return false;
+    return vrb::Node::TraverseResult::Continue;
   });
 
   static const float kNearClip = 0.1f;
@@ -0,0 +1,131 @@
+#include "vrb/CreationContext.h"
+#include "vrb/Geometry.h"
+#include "vrb/Group.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/PickResult.h"
+#include "vrb/RenderContext.h"
+#include "vrb/Transform.h"
+#include "vrb/Vector.h"
+#include "vrb/VertexArray.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Times Group::Pick with two rays, one per controller, against a terrain of about a
+// million triangles and against a grid of small meshes that the broad phase must
+// reject. Geometry indices are 16 bit, so the terrain is split in tiles. No GL context
+// is needed.
+
+static double
+Milliseconds(const std::chrono::steady_clock::time_point& aStart) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+// Tile aTileX, aTileY of a bumpy unit square in the XY plane, centered on the origin
+// and split in aTiles by aTiles tiles of aSize by aSize quads.
+static vrb::GeometryPtr
+CreateTerrain(vrb::CreationContextPtr& aContext, const int aSize, const int aTiles, const int aTileX, const int aTileY) {
+  vrb::VertexArrayPtr array = vrb::VertexArray::Create(aContext);
+  const float kTotal = (float)(aSize * aTiles);
+  for (int y = 0; y <= aSize; y++) {
+    for (int x = 0; x <= aSize; x++) {
+      const float kX = ((float)((aTileX * aSize) + x) / kTotal) - 0.5f;
+      const float kY = ((float)((aTileY * aSize) + y) / kTotal) - 0.5f;
+      array->AppendVertex(vrb::Vector(kX, kY, 0.01f * std::sin(kX * 40.0f) * std::cos(kY * 40.0f)));
+    }
+  }
+  vrb::GeometryPtr geometry = vrb::Geometry::Create(aContext);
+  geometry->SetVertexArray(array);
+  std::vector<int> vertices(4);
+  std::vector<int> empty;
+  for (int y = 0; y < aSize; y++) {
+    for (int x = 0; x < aSize; x++) {
+      const int kIndex = (y * (aSize + 1)) + x + 1;
+      vertices[0] = kIndex;
+      vertices[1] = kIndex + 1;
+      vertices[2] = kIndex + aSize + 2;
+      vertices[3] = kIndex + aSize + 1;
+      geometry->AddFace(vertices, empty, empty);
+    }
+  }
+  return geometry;
+}
+
+static void
+Sweep(vrb::Group& aRoot, const int aPicks, const float aDistance, double& aMilliseconds, int& aHits) {
+  std::vector<vrb::PickRay> rays(2);
+  std::vector<vrb::PickResult> results;
+  aHits = 0;
+  const auto kStart = std::chrono::steady_clock::now();
+  for (int ix = 0; ix < aPicks; ix++) {
+    const float kAngle = (float)ix / (float)aPicks;
+    rays[0] = vrb::PickRay(vrb::Vector(-0.1f, 0.0f, aDistance), vrb::Vector(0.3f * std::sin(kAngle * 6.0f), 0.3f * std::cos(kAngle * 5.0f), -1.0f));
+    rays[1] = vrb::PickRay(vrb::Vector(0.1f, 0.0f, aDistance), vrb::Vector(-0.3f * std::cos(kAngle * 4.0f), 0.3f * std::sin(kAngle * 7.0f), -1.0f));
+    aRoot.Pick(rays, results);
+    aHits += (results[0].IsHit() ? 1 : 0) + (results[1].IsHit() ? 1 : 0);
+  }
+  aMilliseconds = Milliseconds(kStart) / aPicks;
+}
+
+int
+main(int argc, char* argv[]) {
+  const int kTiles = argc > 1 ? atoi(argv[1]) : 16;
+  const int kSize = 45;
+  const int kRows = 100;
+  const int kPicks = 10000;
+  vrb::RenderContextPtr render = vrb::RenderContext::Create();
+  vrb::CreationContextPtr create = render->GetRenderThreadCreationContext();
+
+  vrb::GroupPtr terrainRoot = vrb::Group::Create(create);
+  int triangles = 0;
+  for (int y = 0; y < kTiles; y++) {
+    for (int x = 0; x < kTiles; x++) {
+      vrb::GeometryPtr tile = CreateTerrain(create, kSize, kTiles, x, y);
+      triangles += tile->GetFaceCount() * 2;
+      terrainRoot->AddNode(tile);
+    }
+  }
+
+  // A grid of small terrain patches, most of them away from the rays.
+  vrb::GroupPtr gridRoot = vrb::Group::Create(create);
+  vrb::GeometryPtr patch = CreateTerrain(create, 4, 1, 0, 0);
+  for (int row = 0; row < kRows; row++) {
+    vrb::TransformPtr rowTransform = vrb::Transform::Create(create);
+    rowTransform->SetTransform(vrb::Matrix::Translation(vrb::Vector(0.0f, (float)(row - (kRows / 2)) * 0.02f, 0.0f)));
+    for (int column = 0; column < kRows; column++) {
+      vrb::TransformPtr transform = vrb::Transform::Create(create);
+      transform->SetTransform(vrb::Matrix::Translation(vrb::Vector((float)(column - (kRows / 2)) * 0.02f, 0.0f, 0.0f))
+                              .Scale(vrb::Vector(0.015f, 0.015f, 1.0f)));
+      transform->AddNode(patch);
+      rowTransform->AddNode(transform);
+    }
+    gridRoot->AddNode(rowTransform);
+  }
+
+  std::vector<vrb::PickRay> rays(1, vrb::PickRay(vrb::Vector(0.0f, 0.0f, 1.0f), vrb::Vector(0.0f, 0.0f, -1.0f)));
+  std::vector<vrb::PickResult> results;
+  auto start = std::chrono::steady_clock::now();
+  terrainRoot->Pick(rays, results);
+  const double kBuild = Milliseconds(start);
+
+  double terrainPick = 0.0;
+  int terrainHits = 0;
+  Sweep(*terrainRoot, kPicks, 1.0f, terrainPick, terrainHits);
+
+  start = std::chrono::steady_clock::now();
+  gridRoot->Pick(rays, results);
+  const double kGridFirst = Milliseconds(start);
+  double gridPick = 0.0;
+  int gridHits = 0;
+  Sweep(*gridRoot, kPicks, 1.0f, gridPick, gridHits);
+
+  VRB_LOG("%d triangles in %d tiles, %d batches of 2 rays", triangles, kTiles * kTiles, kPicks);
+  VRB_LOG("First pick, BVH builds  %8.3f ms", kBuild);
+  VRB_LOG("Mesh pick               %8.4f ms %d hits", terrainPick, terrainHits);
+  VRB_LOG("%d meshes, first pick   %8.3f ms", kRows * kRows, kGridFirst);
+  VRB_LOG("Grid pick               %8.4f ms %d hits", gridPick, gridHits);
+  return 0;
+}
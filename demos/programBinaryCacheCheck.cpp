@@ -0,0 +1,139 @@
+#include "vrb/DataCache.h"
+#include "vrb/Logger.h"
+#include "vrb/ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Checks that ProgramBinaryCache only returns a binary stored with the same key and
+// driver, discards corrupt entries and never leaves a temporary file behind. The
+// cache does not make GL calls, so no GL context is needed. Returns non-zero when a
+// check fails.
+
+static int sFailures = 0;
+
+static void
+Check(const bool aCondition, const char* aMessage) {
+  if (!aCondition) {
+    VRB_ERROR("FAILED: %s", aMessage);
+    sFailures++;
+  }
+}
+
+static std::vector<std::string>
+ListFiles(const std::string& aPath) {
+  std::vector<std::string> result;
+  DIR* dir = opendir(aPath.c_str());
+  if (!dir) {
+    return result;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      result.push_back(aPath + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+  return result;
+}
+
+static std::string
+ReadFile(const std::string& aPath) {
+  std::ifstream input(aPath, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+static void
+WriteFile(const std::string& aPath, const std::string& aData) {
+  std::ofstream output(aPath, std::ios::binary | std::ios::trunc);
+  output.write(aData.data(), aData.size());
+}
+
+static bool
+Load(vrb::ProgramBinaryCache& aCache, const std::string& aKey, std::string& aResult) {
+  GLenum format = 0;
+  std::unique_ptr<uint8_t[]> binary;
+  size_t size = 0;
+  if (!aCache.Load(aKey, format, binary, size)) {
+    return false;
+  }
+  aResult.assign((const char*)binary.get(), size);
+  return format == 0x1234;
+}
+
+int
+main(int argc, char* argv[]) {
+  char root[] = "/tmp/vrb_program_cache_XXXXXX";
+  if (!mkdtemp(root)) {
+    VRB_ERROR("Unable to create a temporary directory");
+    return 1;
+  }
+  vrb::DataCachePtr dataCache = vrb::DataCache::Create();
+  dataCache->SetCachePath(root);
+  vrb::ProgramBinaryCachePtr cache = vrb::ProgramBinaryCache::Create(dataCache);
+  cache->SetDriverIdentity("driver 1");
+
+  const std::string kBinary = "program binary";
+  std::string loaded;
+  Check(!Load(*cache, "key a", loaded), "load of a missing key fails");
+  Check(cache->Store("key a", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "store succeeds");
+  std::vector<std::string> files = ListFiles(root);
+  Check(files.size() == 1, "store leaves a single file and no temporary file");
+  const std::string kPathA = files.empty() ? std::string() : files[0];
+  Check(Load(*cache, "key a", loaded) && (loaded == kBinary), "load returns the stored binary");
+
+  // An entry of another key copied to this key's file must not be returned.
+  Check(cache->Store("key b", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "second store succeeds");
+  std::string pathB;
+  for (const std::string& path: ListFiles(root)) {
+    if (path != kPathA) {
+      pathB = path;
+    }
+  }
+  WriteFile(pathB, ReadFile(kPathA));
+  Check(!Load(*cache, "key b", loaded), "load rejects a key mismatch");
+  Check(access(pathB.c_str(), F_OK) != 0, "a mismatched entry is removed");
+
+  // A header with a bad magic or a length larger than the file is rejected.
+  std::string data = ReadFile(kPathA);
+  data[0] ^= 0xff;
+  WriteFile(kPathA, data);
+  Check(!Load(*cache, "key a", loaded), "load rejects a corrupt magic");
+  Check(cache->Store("key a", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "store replaces an entry");
+  data = ReadFile(kPathA);
+  WriteFile(kPathA, data.substr(0, data.size() - 1));
+  Check(!Load(*cache, "key a", loaded), "load rejects a truncated binary");
+  Check(cache->Store("key a", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "store after truncation");
+  data = ReadFile(kPathA);
+  const size_t kLengthOffset = 24;
+  memset(&data[kLengthOffset], 0xff, sizeof(uint64_t));
+  WriteFile(kPathA, data);
+  Check(!Load(*cache, "key a", loaded), "load rejects a corrupt binary length");
+
+  // Binaries of another driver are ignored.
+  Check(cache->Store("key a", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "store for the driver change");
+  cache->SetDriverIdentity("driver 2");
+  Check(!Load(*cache, "key a", loaded), "load rejects a binary of another driver");
+
+  // When the rename fails the temporary file is removed and the store fails.
+  mkdir(kPathA.c_str(), 0770);
+  WriteFile(kPathA + "/entry", "keeps the directory from being replaced");
+  Check(!cache->Store("key a", 0x1234, (const uint8_t*)kBinary.data(), kBinary.size()), "store fails when the rename fails");
+  Check(access((kPathA + ".tmp").c_str(), F_OK) != 0, "a failed store removes the temporary file");
+  remove((kPathA + "/entry").c_str());
+  rmdir(kPathA.c_str());
+
+  for (const std::string& path: ListFiles(root)) {
+    remove(path.c_str());
+  }
+  rmdir(root);
+  VRB_LOG("ProgramBinaryCache checks %s", sFailures ? "FAILED" : "passed");
+  return sFailures ? 1 : 0;
+}
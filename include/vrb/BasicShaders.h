@@ -7,14 +7,29 @@
 #define VRB_BASIC_SHADERS_DOT_H
 
 #define VRB_MAX_LIGHTS 2
+// Binding points of the std140 uniform blocks used when GLES3 is available.
+#define VRB_CAMERA_BLOCK_BINDING 0
+#define VRB_LIGHTS_BLOCK_BINDING 1
+#define VRB_MATERIAL_BLOCK_BINDING 2
+#define VRB_MULTIVIEW_CAMERA_BLOCK_BINDING 3
 
 namespace vrb {
 
+// Shader bodies without a #version line, see ProgramFactory for how variants are assembled.
 const char* GetVertexShaderSource();
 const char* GetFragmentShaderSource();
 const char* GetFragmentTextureShaderSource();
 const char* GetFragmentSurfaceTextureShaderSource();
 const char* GetFragmentCubeMapTextureShaderSource();
+const char* GetFragmentTextureArrayShaderSource();
+// #version headers for GLSL ES 1.00 and 3.00.
+const char* GetShaderES2Header();
+const char* GetVertexShaderES3Header();
+const char* GetVertexShaderMultiviewHeader();
+const char* GetFragmentShaderES3Header();
+// GLSL ES 1.00 compatibility defines and output declaration of GLSL ES 3.00 fragment
+// shaders, placed after the #extension lines.
+const char* GetFragmentShaderES3Prologue();
 
 } // namespace vrb
 
@@ -0,0 +1,48 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_COMPILED_SCENE_DOT_H
+#define VRB_COMPILED_SCENE_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+namespace vrb {
+
+// Flattened depth first copy of a Group graph that can be culled without walking
+// the shared_ptr children. When the root's Node::GetVersion() changes, only the
+// subtrees whose version changed are compiled again. Geometry bounds are refreshed
+// when vertex positions change. World transforms are only updated below the
+// Transforms that changed since the last Cull().
+class CompiledScene {
+public:
+  static CompiledScenePtr Create(CreationContextPtr& aContext);
+  void SetRoot(const GroupPtr& aRoot);
+  // When set, Geometry outside of the camera frustum is not added to the DrawableList.
+  void SetFrustumCamera(const CameraPtr& aCamera);
+  // When set together with the frustum camera, the screen size of every visible
+  // Geometry is reported to the streamer for the texture of its RenderState.
+  void SetTextureStreamer(const TextureStreamerPtr& aStreamer);
+  bool IsCompiled() const;
+  void Compile();
+  int32_t GetNodeCount() const;
+  // aDrawables refers to the drawables of the scene without holding them, draw it
+  // before the next Cull().
+  void Cull(CullVisitor& aVisitor, DrawableList& aDrawables);
+
+protected:
+  struct State;
+  CompiledScene(State& aState, CreationContextPtr& aContext);
+  ~CompiledScene();
+
+private:
+  State& m;
+  CompiledScene() = delete;
+  VRB_NO_DEFAULTS(CompiledScene)
+};
+
+} // namespace vrb
+
+#endif // VRB_COMPILED_SCENE_DOT_H
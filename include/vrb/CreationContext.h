@@ -23,7 +23,11 @@ public:
   DataCachePtr GetDataCache();
   FileReaderPtr GetFileReader();
   ProgramFactoryPtr GetProgramFactory();
-  TextureGLPtr LoadTexture(const std::string& TextureName, const bool aUseCache = true);
+  TextureStreamerPtr GetTextureStreamer();
+  TextureUploadQueuePtr GetTextureUploadQueue();
+  // Loads a 2D texture. Cube map images are rejected unless aAllowCubeMap is set, in
+  // which case the texture needs FeatureCubeMapTexture to be sampled.
+  TextureGLPtr LoadTexture(const std::string& TextureName, const bool aUseCache = true, const bool aAllowCubeMap = false);
   void UpdateResourceGL();
   void AddResourceGL(ResourceGL* aResource);
   void AddUpdatable(Updatable* aUpdatable);
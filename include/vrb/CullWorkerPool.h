@@ -0,0 +1,43 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_CULL_WORKER_POOL_DOT_H
+#define VRB_CULL_WORKER_POOL_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+#include <cstdint>
+
+namespace vrb {
+
+// Culls the subtrees of a root Group in parallel. The root's children, with the
+// largest groups without lights or render lambdas replaced by their own children, are
+// split into a few jobs per thread. Each job is culled into its own DrawableList shard
+// with its own CullVisitor. The shards are merged in job order, so the resulting
+// DrawableList matches a single threaded Group::Cull.
+// Nodes must not be modified while Cull is running.
+class CullWorkerPool {
+public:
+  // A thread count of zero uses one thread less than the number of online cores.
+  static CullWorkerPoolPtr Create(CreationContextPtr& aContext, const int32_t aThreadCount = 0);
+  int32_t GetThreadCount() const;
+  void Cull(Group& aRoot, CullVisitor& aVisitor, DrawableList& aDrawables);
+
+protected:
+  struct State;
+  CullWorkerPool(State& aState, CreationContextPtr& aContext);
+  ~CullWorkerPool();
+
+private:
+  State& m;
+  static void* Run(void* aData);
+  CullWorkerPool() = delete;
+  VRB_NO_DEFAULTS(CullWorkerPool)
+};
+
+} // namespace vrb
+
+#endif // VRB_CULL_WORKER_POOL_DOT_H
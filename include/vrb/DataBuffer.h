@@ -0,0 +1,42 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_DATA_BUFFER_DOT_H
+#define VRB_DATA_BUFFER_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace vrb {
+
+// Read only block of memory shared between the file readers and the textures that
+// upload from it. Buffers created from a file are memory mapped when possible and
+// remember the file path so the data can be reloaded later instead of being cached.
+class DataBuffer {
+public:
+  static DataBufferPtr Create(std::unique_ptr<uint8_t[]>& aData, const size_t aSize);
+  static DataBufferPtr CreateFromFile(const std::string& aPath);
+  const uint8_t* GetData() const;
+  size_t GetSize() const;
+  bool IsMapped() const;
+  // Empty when the buffer is not backed by a file.
+  const std::string& GetFilePath() const;
+protected:
+  struct State;
+  DataBuffer(State& aState);
+  ~DataBuffer();
+private:
+  State& m;
+  DataBuffer() = delete;
+  VRB_NO_DEFAULTS(DataBuffer)
+};
+
+} // namespace vrb
+
+#endif // VRB_DATA_BUFFER_DOT_H
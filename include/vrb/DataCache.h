@@ -15,8 +15,13 @@ class DataCache {
 public:
   static DataCachePtr Create();
   void SetCachePath(const std::string& aPath);
+  std::string GetCachePath();
   uint32_t CacheData(std::unique_ptr<uint8_t[]>& aData, const size_t aDataSize);
+  // Writes a copy of the buffer, the buffer itself is left untouched.
+  uint32_t CacheData(const DataBufferPtr& aData);
   size_t LoadData(const uint32_t aHandle, std::unique_ptr<uint8_t[]>& aData);
+  // Maps the cached data instead of reading it into memory.
+  DataBufferPtr LoadBuffer(const uint32_t aHandle);
   void RemoveData(const uint32_t aHandle);
 protected:
   struct State;
@@ -18,6 +18,9 @@ public:
   virtual RenderStatePtr& GetRenderState() = 0;
   virtual void SetRenderState(const RenderStatePtr& aRenderState) = 0;
   virtual void Draw(const Camera& aCamera, const Matrix& aModelTransform) = 0;
+  // Single pass stereo draw used with multiview framebuffers. The default draws once
+  // per eye with the single camera Draw, drawables with a multiview program override it.
+  virtual void Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform);
 protected:
   struct State;
   Drawable(State& aState, CreationContextPtr& aContext);
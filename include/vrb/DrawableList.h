@@ -13,13 +13,46 @@ namespace vrb {
 
 class DrawableList {
 public:
+  // Counters for the drawables added since the last Reset().
+  struct Stats {
+    uint32_t drawables;
+    // Distinct light sets referenced by the drawables.
+    uint32_t lightSets;
+    // Times a RenderState was switched to a different light set.
+    uint32_t lightSetChanges;
+    // Light uniform or uniform buffer uploads made while drawing.
+    uint32_t lightUploads;
+    // Uniform group uploads made and skipped while drawing.
+    uint32_t uniformUploads;
+    uint32_t uniformUploadsSkipped;
+    Stats()
+        : drawables(0)
+        , lightSets(0)
+        , lightSetChanges(0)
+        , lightUploads(0)
+        , uniformUploads(0)
+        , uniformUploadsSkipped(0)
+    {}
+  };
   static DrawableListPtr Create(CreationContextPtr& aContext);
 
   void Reset();
   void PushLight(const Light& aLight);
   void PopLights(const int aCount);
   void AddDrawable(DrawablePtr&& aDrawable, const Matrix& aTransform);
+  // Adds aDrawable without holding a reference, the caller keeps it alive until the
+  // list is drawn or reset.
+  void AddDrawable(Drawable& aDrawable, const Matrix& aTransform);
+  // Moves every drawable in aSource in front of the drawables in this list, as if they
+  // had been added here. Lights at the root of aSource inherit the current light stack.
+  void TakeDrawables(DrawableList& aSource);
+  // Moves up to aCount unused nodes to aTarget. Lists that take drawables from each
+  // other every frame use it to hand the nodes back instead of allocating new ones.
+  void MoveFreeNodes(DrawableList& aTarget, const uint32_t aCount);
   void Draw(const Camera& aCamera);
+  // Draws each drawable once for both eyes into a multiview framebuffer.
+  void Draw(const Camera& aLeftCamera, const Camera& aRightCamera);
+  const Stats& GetStats() const;
 
 protected:
   struct State;
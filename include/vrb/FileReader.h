@@ -10,11 +10,41 @@
 #include "vrb/MacroUtils.h"
 #include "vrb/gl.h"
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace vrb {
 
+// Describes where each mip level of each cube face is stored inside a single image
+// buffer, so a whole container can be handed over without a copy per level.
+struct ImageLayout {
+  struct Level {
+    GLenum target;
+    GLint level;
+    GLsizei width;
+    GLsizei height;
+    size_t offset;
+    size_t size;
+  };
+
+  GLenum target;
+  GLenum internalFormat;
+  GLenum format;
+  GLenum type;
+  bool compressed;
+  std::vector<Level> levels;
+
+  ImageLayout()
+      : target(GL_TEXTURE_2D)
+      , internalFormat(GL_RGBA)
+      , format(GL_RGBA)
+      , type(GL_UNSIGNED_BYTE)
+      , compressed(false)
+  {}
+};
+
 class FileHandler {
 public:
   virtual void BindFileHandle(const std::string& aFileName, const int aFileHandle) = 0;
@@ -22,6 +52,10 @@ public:
   virtual void ProcessRawFileChunk(const int aFileHandle, const char* aBuffer, const size_t aSize) = 0;
   virtual void FinishRawFile(const int aFileHandle) = 0;
   virtual void ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) = 0;
+  // Receives a whole image container along with the location of every level and face
+  // inside it. The buffer may be a read only mapping of the source file. The default
+  // implementation copies the first level and forwards it to ProcessImageFile.
+  virtual void ProcessImageLevels(const int aFileHandle, const DataBufferPtr& aImage, const ImageLayout& aLayout);
 protected:
   FileHandler() {}
   virtual ~FileHandler() {}
@@ -33,6 +67,9 @@ class FileReader {
 public:
   virtual void ReadRawFile(const std::string& aFileName, FileHandlerPtr aHandler) = 0;
   virtual void ReadImageFile(const std::string& aFileName, FileHandlerPtr aHandler) = 0;
+  // Delivers the results of asynchronous reads requested from the calling thread.
+  // Called by CreationContext::Synchronize().
+  virtual void ProcessCompletions() {}
 protected:
   FileReader() {}
   virtual ~FileReader() {}
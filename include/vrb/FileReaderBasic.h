@@ -8,24 +8,48 @@
 
 #include "vrb/FileReader.h"
 #include "vrb/Forward.h"
+#include "vrb/ImageTranscoder.h"
 #include "vrb/MacroUtils.h"
 
 #include "vrb/gl.h"
+#include <cstdint>
 #include <memory>
 
 namespace vrb {
 
+// With workers, image files are read and parsed on a fixed pool of threads. The
+// handler receives BindFileHandle() right away and its results once the requesting
+// thread calls ProcessCompletions(), which CreationContext::Synchronize() does.
+// Without workers images are read synchronously. Raw files are always synchronous.
+// Images are KTX files. KTX2 files are handed over without a copy when their format
+// can be sampled as is, others go through the ImageTranscoder.
 class FileReaderBasic : public FileReader {
 public:
-  static FileReaderBasicPtr Create();
+  static FileReaderBasicPtr Create(const int32_t aWorkerCount = 0);
   void ReadRawFile(const std::string& aFileName, FileHandlerPtr aHandler) override;
   void ReadImageFile(const std::string& aFileName, FileHandlerPtr aHandler) override;
+  // Requests with a higher priority are read first, equal priorities in request order.
+  void ReadImageFile(const std::string& aFileName, FileHandlerPtr aHandler, const int32_t aPriority);
+  void ProcessCompletions() override;
+  int32_t GetWorkerCount() const;
+  // Number of image requests not yet delivered.
+  int32_t GetPendingCount() const;
+  // Returns false when the request already started or is unknown.
+  bool SetPriority(const int aFileHandle, const int32_t aPriority);
+  // The handler of a cancelled request receives no further calls. Returns false when
+  // the request was already delivered or is unknown.
+  bool Cancel(const int aFileHandle);
+  // Null, the default, fails to load KTX2 files that need transcoding.
+  void SetTranscoder(const ImageTranscoderPtr& aTranscoder);
+  // Set by RenderContext::InitializeGL() from the GLExtensions of the context.
+  void SetTranscodeTarget(const ImageTranscoder::Target aTarget);
 protected:
   struct State;
   FileReaderBasic(State& aState);
   ~FileReaderBasic();
 private:
   State& m;
+  static void* Run(void* aData);
   FileReaderBasic() = delete;
   VRB_NO_DEFAULTS(FileReaderBasic)
 };
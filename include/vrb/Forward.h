@@ -30,6 +30,9 @@ typedef std::shared_ptr<ClassLoaderAndroid> ClassLoaderAndroidPtr;
 
 class Color;
 
+class CompiledScene;
+typedef std::shared_ptr<CompiledScene> CompiledScenePtr;
+
 class ContextSynchronizer;
 typedef std::shared_ptr<ContextSynchronizer> ContextSynchronizerPtr;
 
@@ -44,8 +47,15 @@ typedef std::weak_ptr<CreationContext> CreationContextWeak;
 class CullVisitor;
 typedef std::shared_ptr<CullVisitor> CullVisitorPtr;
 
+class CullWorkerPool;
+typedef std::shared_ptr<CullWorkerPool> CullWorkerPoolPtr;
+
+class DataBuffer;
+typedef std::shared_ptr<DataBuffer> DataBufferPtr;
+
 class DataCache;
 typedef std::shared_ptr<DataCache> DataCachePtr;
+typedef std::weak_ptr<DataCache> DataCacheWeak;
 
 class Drawable;
 typedef std::shared_ptr<Drawable> DrawablePtr;
@@ -72,6 +82,7 @@ typedef std::shared_ptr<FileReaderBasic> FileReaderBasicPtr;
 
 class Geometry;
 typedef std::shared_ptr<Geometry> GeometryPtr;
+typedef std::weak_ptr<Geometry> GeometryWeak;
 
 class GeometryDrawable;
 typedef std::shared_ptr<GeometryDrawable> GeometryDrawablePtr;
@@ -83,9 +94,17 @@ class Group;
 typedef std::weak_ptr<Group> GroupWeak;
 typedef std::shared_ptr<Group> GroupPtr;
 
+class ImageTranscoder;
+typedef std::shared_ptr<ImageTranscoder> ImageTranscoderPtr;
+
+class ImageTranscoderZlib;
+typedef std::shared_ptr<ImageTranscoderZlib> ImageTranscoderZlibPtr;
+
 class Light;
 typedef std::shared_ptr<Light> LightPtr;
 
+struct LightSet;
+
 class LoaderThread;
 typedef std::shared_ptr<LoaderThread> LoaderThreadPtr;
 typedef std::weak_ptr<LoaderThread> LoaderThreadWeak;
@@ -117,9 +136,15 @@ typedef std::shared_ptr<PerformanceMonitor> PerformanceMonitorPtr;
 class PerformanceMonitorObserver;
 typedef std::shared_ptr<PerformanceMonitorObserver> PerformanceMonitorObserverPtr;
 
+struct PickRay;
+struct PickResult;
+
 class Program;
 typedef std::shared_ptr<Program> ProgramPtr;
 
+class ProgramBinaryCache;
+typedef std::shared_ptr<ProgramBinaryCache> ProgramBinaryCachePtr;
+
 class ProgramFactory;
 typedef std::shared_ptr<ProgramFactory> ProgramFactoryPtr;
 
@@ -158,6 +183,12 @@ typedef std::shared_ptr<SurfaceTextureObserver> SurfaceTextureObserverPtr;
 class Texture;
 typedef std::shared_ptr<Texture> TexturePtr;
 
+class TextureArray;
+typedef std::shared_ptr<TextureArray> TextureArrayPtr;
+
+class TextureAtlas;
+typedef std::shared_ptr<TextureAtlas> TextureAtlasPtr;
+
 class TextureCache;
 typedef std::shared_ptr<TextureCache> TextureCachePtr;
 
@@ -166,12 +197,19 @@ typedef std::shared_ptr<TextureCubeMap> TextureCubeMapPtr;
 
 class TextureGL;
 typedef std::shared_ptr<TextureGL> TextureGLPtr;
+typedef std::weak_ptr<TextureGL> TextureGLWeak;
 
 #if defined(ANDROID)
 class TextureSurface;
 typedef std::shared_ptr<TextureSurface> TextureSurfacePtr;
 #endif // defined(ANDROID)
 
+class TextureStreamer;
+typedef std::shared_ptr<TextureStreamer> TextureStreamerPtr;
+
+class TextureUploadQueue;
+typedef std::shared_ptr<TextureUploadQueue> TextureUploadQueuePtr;
+
 class ThreadIdentity;
 typedef std::shared_ptr<ThreadIdentity> ThreadIdentityPtr;
 
@@ -181,6 +219,9 @@ typedef std::shared_ptr<Toggle> TogglePtr;
 class Transform;
 typedef std::shared_ptr<Transform> TransformPtr;
 
+class UniformBuffer;
+typedef std::shared_ptr<UniformBuffer> UniformBufferPtr;
+
 class Updatable;
 class UpdatableList;
 
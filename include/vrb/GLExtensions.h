@@ -18,6 +18,8 @@ public:
   // Known GL extensions that can be queried by IsExtensionSupported.
   enum class Ext {
     EXT_multisampled_render_to_texture,
+    KHR_parallel_shader_compile,
+    KHR_texture_compression_astc_ldr,
     OVR_multiview,
     OVR_multiview2,
     OVR_multiview_multisampled_render_to_texture
@@ -29,11 +31,14 @@ public:
     PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
     PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR;
     PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC glFramebufferTextureMultisampleMultiviewOVR;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
   };
 
   static GLExtensionsPtr Create(RenderContextPtr& aContext);
   void Initialize();
   bool IsExtensionSupported(GLExtensions::Ext aExtension) const;
+  // True when the context is OpenGL ES 3.0 or later (GLSL ES 3.00, uniform blocks, PBOs).
+  bool IsGLES3Supported() const;
   const GLExtensions::Functions & GetFunctions() const;
 protected:
   struct State;
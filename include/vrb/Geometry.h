@@ -37,6 +37,15 @@ public:
 
   int32_t GetFaceCount() const;
   const Face& GetFace(int32_t aIndex) const;
+  // Axis aligned bounds in local space of the vertices the faces use. Returns false
+  // when there are none. The bounds are cached until the faces or positions change.
+  bool GetBounds(Vector& aMin, Vector& aMax) const;
+  // VertexArray::GetPositionVersion() of the vertex array, zero without one.
+  uint32_t GetBoundsVersion() const;
+  // Intersects a ray in local space with the faces of the Geometry using a triangle
+  // BVH built on first use. aResult.distance is the ray parameter in units of
+  // aDirection; a hit is only recorded when it is closer than the current value.
+  bool Pick(const Vector& aOrigin, const Vector& aDirection, PickResult& aResult) const;
 
 protected:
   struct State;
@@ -23,11 +23,20 @@ public:
   RenderStatePtr& GetRenderState() override;
   void SetRenderState(const RenderStatePtr& aRenderState) override;
   void Draw(const Camera& aCamera, const Matrix& aModelTransform) override;
+  void Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform) override;
 
   // GeometryDrawable interface
   RenderBufferPtr& GetRenderBuffer();
   void SetRenderBuffer(RenderBufferPtr& aRenderBuffer);
   void SetRenderRange(uint32_t aStartIndex, uint32_t aLength);
+  // A length of zero draws every index.
+  void GetRenderRange(uint32_t& aStartIndex, uint32_t& aLength) const;
+  // Replaces the RenderState's UV transform while this drawable is drawn, so drawables
+  // sharing a RenderState can draw different regions of one texture, for example an
+  // atlas page. Drawables sharing a RenderState should all set one or none.
+  void SetUVTransform(const Matrix& aMatrix);
+  // Returns false when the RenderState's UV transform is used.
+  bool GetUVTransform(Matrix& aMatrix) const;
 
 protected:
   struct State;
@@ -35,6 +44,7 @@ protected:
   ~GeometryDrawable() = default;
 
 private:
+  void DrawRenderBuffer();
   State& m;
   GeometryDrawable() = delete;
   VRB_NO_DEFAULTS(GeometryDrawable)
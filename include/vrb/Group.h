@@ -10,6 +10,8 @@
 #include "vrb/MacroUtils.h"
 #include "vrb/Node.h"
 
+#include <vector>
+
 namespace vrb {
 
 class Group : public Node {
@@ -31,14 +33,31 @@ public:
   void TakeChildren(GroupPtr& aGroup);
   void SetPreRenderLambda(CreationContextPtr& aContext, const RenderLambda& aLambda);
   void SetPostRenderLambda(CreationContextPtr& aContext, const RenderLambda& aLambda);
+  // Merges every Geometry below this Group that shares a RenderState into a single
+  // pre-transformed Geometry. Edits made below a baked Group are not rendered until
+  // Unbake() or another Bake() is called.
+  bool Bake(CreationContextPtr& aContext);
+  void Unbake();
+  bool IsBaked() const;
+  // Bounds of the enabled Geometry below this Group, in the same space as the Group.
+  // Cached until the subtree changes, moves, or a vertex position is edited.
+  bool GetBounds(Vector& aMin, Vector& aMax) const;
+  // Finds the nearest enabled Geometry hit by a ray. The ray is in the same space as
+  // this Group, so a Transform's own matrix is applied to its children.
+  bool Pick(const PickRay& aRay, PickResult& aResult);
+  // Picks several rays, such as one per controller, in a single traversal.
+  void Pick(const std::vector<PickRay>& aRays, std::vector<PickResult>& aResults);
 
 protected:
   bool Traverse(const GroupPtr& aParent, const Node::TraverseFunction& aTraverseFunction) override;
+  void InvalidateWorldTransform() override;
   struct State;
   Group(State& aState, CreationContextPtr& aContext);
   ~Group();
 
 private:
+  friend class CompiledScene;
+  friend class CullWorkerPool;
   State& m;
   Group() = delete;
   VRB_NO_DEFAULTS(Group)
@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_IMAGE_TRANSCODER_DOT_H
+#define VRB_IMAGE_TRANSCODER_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+#include <cstdint>
+
+namespace vrb {
+
+struct ImageLayout;
+
+// Decodes KTX2 images the GPU can not sample as stored, such as Basis Universal
+// ETC1S and UASTC or zstd supercompressed files. vrb only bundles ImageTranscoderZlib,
+// applications provide others through FileReaderBasic::SetTranscoder(). Transcode() is
+// called on the FileReaderBasic worker threads, so it must be thread safe.
+class ImageTranscoder {
+public:
+  enum class Target : uint8_t {
+    RGBA,
+    ETC2,
+    ASTC
+  };
+  // ASTC when supported, ETC2 on GLES3 and uncompressed RGBA otherwise.
+  static Target SelectTarget(const GLExtensions& aExtensions);
+
+  // aVkFormat is zero for Basis Universal images.
+  virtual bool CanTranscode(const uint32_t aVkFormat, const uint32_t aSupercompressionScheme) const = 0;
+  // Transcodes the whole KTX2 file in aFile into aImage, with every level described by aLayout.
+  virtual bool Transcode(const DataBufferPtr& aFile, const Target aTarget, DataBufferPtr& aImage, ImageLayout& aLayout) = 0;
+protected:
+  ImageTranscoder() {}
+  virtual ~ImageTranscoder() {}
+private:
+  VRB_NO_DEFAULTS(ImageTranscoder)
+};
+
+} // namespace vrb
+
+#endif // VRB_IMAGE_TRANSCODER_DOT_H
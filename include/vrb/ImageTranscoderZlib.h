@@ -0,0 +1,35 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_IMAGE_TRANSCODER_ZLIB_DOT_H
+#define VRB_IMAGE_TRANSCODER_ZLIB_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/ImageTranscoder.h"
+#include "vrb/MacroUtils.h"
+
+namespace vrb {
+
+// Reference ImageTranscoder for KTX2 files supercompressed with zlib whose VkFormat
+// GL samples as stored. Levels are only inflated, so the target is ignored. Basis
+// Universal and zstd files still need a transcoder from the application.
+class ImageTranscoderZlib : public ImageTranscoder {
+public:
+  static ImageTranscoderZlibPtr Create();
+  bool CanTranscode(const uint32_t aVkFormat, const uint32_t aSupercompressionScheme) const override;
+  bool Transcode(const DataBufferPtr& aFile, const Target aTarget, DataBufferPtr& aImage, ImageLayout& aLayout) override;
+protected:
+  struct State;
+  ImageTranscoderZlib(State& aState);
+  ~ImageTranscoderZlib();
+private:
+  State& m;
+  ImageTranscoderZlib() = delete;
+  VRB_NO_DEFAULTS(ImageTranscoderZlib)
+};
+
+} // namespace vrb
+
+#endif // VRB_IMAGE_TRANSCODER_ZLIB_DOT_H
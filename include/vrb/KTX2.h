@@ -0,0 +1,49 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_KTX2_DOT_H
+#define VRB_KTX2_DOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vrb {
+
+struct ImageLayout;
+
+// KTX2 container parsing shared by FileReaderBasic and the ImageTranscoders.
+struct KTX2Level {
+  uint64_t offset;
+  uint64_t length;
+  uint64_t uncompressedLength;
+};
+
+struct KTX2Header {
+  uint32_t vkFormat;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t layers;
+  uint32_t faces;
+  uint32_t supercompression;
+  std::vector<KTX2Level> levels;
+};
+
+bool IsKTX2(const uint8_t* aData, const size_t aSize);
+// Reads the header and level index of a KTX2 file. Fails when a level does not fit
+// in the file.
+bool ReadKTX2Header(const uint8_t* aData, const size_t aSize, KTX2Header& aHeader, std::string& aError);
+// True for the VkFormats that GL samples as stored.
+bool IsKTX2FormatSupported(const uint32_t aVkFormat);
+// Describes the levels of an image in the VkFormat of aHeader. aLevels hold where each
+// level is in the image, with the faces of a level packed together. Only 2D and cube
+// map textures are supported, and every level length must match its dimensions.
+bool CreateKTX2Layout(const KTX2Header& aHeader, const std::vector<KTX2Level>& aLevels, ImageLayout& aLayout, std::string& aError);
+
+} // namespace vrb
+
+#endif // VRB_KTX2_DOT_H
@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_LIGHT_SET_DOT_H
+#define VRB_LIGHT_SET_DOT_H
+
+#include "vrb/BasicShaders.h"
+#include "vrb/Forward.h"
+
+#include <cstdint>
+
+namespace vrb {
+
+// Packed copy of the lights that affect a drawable. The data uses the std140 layout
+// of the vrb_Lights uniform block so it can be uploaded without conversion. The id
+// is unique for every distinct set of lights and is used to skip redundant uploads.
+struct LightSet {
+  struct Light {
+    float direction[4];
+    float ambient[4];
+    float diffuse[4];
+    float specular[4];
+  };
+  struct Data {
+    int32_t count;
+    int32_t padding[3];
+    Light lights[VRB_MAX_LIGHTS];
+  };
+
+  uint32_t id;
+  Data data;
+
+  LightSet();
+  void Clear();
+  bool Add(const Vector& aDirection, const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular);
+  bool HasSameLights(const LightSet& aOther) const;
+  // Returns a new process wide unique id, never zero.
+  static uint32_t NextId();
+};
+
+} // namespace vrb
+
+#endif // VRB_LIGHT_SET_DOT_H
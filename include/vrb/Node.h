@@ -9,14 +9,34 @@
 #include "vrb/Forward.h"
 #include "vrb/MacroUtils.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace vrb {
 
 class Node {
 public:
+  // Kind bits are added by each subclass constructor so traversals can filter
+  // nodes without RTTI.
+  enum Kind : uint32_t {
+    KindGroup = 0x01 << 0,
+    KindTransform = 0x01 << 1,
+    KindToggle = 0x01 << 2,
+    KindDrawable = 0x01 << 3,
+    KindGeometry = 0x01 << 4
+  };
+  enum class TraverseResult {
+    Continue, // Visit the children of this node.
+    Prune,    // Skip the children of this node.
+    Stop      // End the traversal.
+  };
+  typedef TraverseResult (*VisitCallback)(Node& aNode, void* aData);
+
+  uint32_t GetKind() const;
+  bool IsKind(const uint32_t aKind) const { return (GetKind() & aKind) == aKind; }
   const std::string& GetName() const;
   void SetName(const std::string& aName);
   void GetParents(std::vector<GroupPtr>& aParents) const;
@@ -24,14 +44,37 @@ public:
   virtual void Cull(CullVisitor& aVisitor, DrawableList& aDrawables) = 0;
   using TraverseFunction = std::function<bool(const NodePtr& aNode, const GroupPtr& aTraversingFrom)>;
   static bool Traverse(const NodePtr& aRootNode, const TraverseFunction& aTraverseFunction);
+  // Non-recursive depth first traversal of the whole graph below and including
+  // aRootNode. aFunction is only called for nodes that have all of the aKindFilter
+  // bits, pass zero to visit every node. Returns true if the traversal was stopped.
+  template<typename Function>
+  static bool Visit(Node& aRootNode, const uint32_t aKindFilter, Function&& aFunction) {
+    typedef typename std::remove_reference<Function>::type FunctionType;
+    return Visit(aRootNode, aKindFilter, [](Node& aNode, void* aData) -> TraverseResult {
+      return (*static_cast<FunctionType*>(aData))(aNode);
+    }, &aFunction);
+  }
+  static bool Visit(Node& aRootNode, const uint32_t aKindFilter, VisitCallback aCallback, void* aData);
+  // Replaced with a new, process wide unique value whenever this node or any node
+  // below it changes structure. Used by CompiledScene to find the changed subtrees.
+  uint32_t GetVersion() const;
 protected:
   struct State;
   Node(State& aState, CreationContextPtr& aContext);
   virtual ~Node();
   static void AddToParents(GroupWeak& aParent, Node& aChild);
   static void RemoveFromParents(Group& aParent, Node& aChild);
+  static GroupPtr GetFirstParent(const Node& aNode);
+  void GraphChanged();
+  // Stamps this node and every ancestor with a new bounds version, for changes that
+  // move a subtree without changing its structure.
+  void BoundsChanged();
+  static void InvalidateWorldTransform(Node& aNode);
+  // Called when a transform above this node changes or the node is reparented.
+  virtual void InvalidateWorldTransform();
   virtual bool Traverse(const GroupPtr& aParent, const TraverseFunction& aTraverseFunction);
 private:
+  void StampAncestors(const bool aGraphChanged);
   State& m;
   Node() = delete;
   VRB_NO_DEFAULTS(Node)
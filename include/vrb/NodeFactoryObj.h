@@ -49,6 +49,9 @@ public:
   // NodeFactoryObj interface
   void SetModelRoot(GroupPtr aGroup);
   GroupPtr& GetModelRoot();
+  // Small uncompressed diffuse textures are packed into the atlas instead of being
+  // loaded as separate textures. Null, the default, disables atlasing.
+  void SetTextureAtlas(const TextureAtlasPtr& aAtlas);
 
 protected:
   struct State;
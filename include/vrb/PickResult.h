@@ -0,0 +1,43 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_PICK_RESULT_DOT_H
+#define VRB_PICK_RESULT_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/Vector.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace vrb {
+
+struct PickRay {
+  Vector origin;
+  Vector direction;
+  PickRay() {}
+  PickRay(const Vector& aOrigin, const Vector& aDirection) : origin(aOrigin), direction(aDirection) {}
+};
+
+struct PickResult {
+  // Geometry that was hit, null when the ray missed.
+  NodePtr node;
+  // Index of the hit face in Geometry::GetFace().
+  int32_t face;
+  // Zero based VertexArray indices of the triangle that was hit within the face.
+  int32_t vertices[3];
+  // Weights of vertices[0], vertices[1] and vertices[2] at the hit point.
+  Vector barycentric;
+  // Hit point and distance from the ray origin in the space of the picked Group.
+  Vector point;
+  float distance;
+
+  PickResult() : face(-1), vertices{-1, -1, -1}, distance(std::numeric_limits<float>::max()) {}
+  bool IsHit() const { return node != nullptr; }
+};
+
+} // namespace vrb
+
+#endif // VRB_PICK_RESULT_DOT_H
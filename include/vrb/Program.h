@@ -22,10 +22,34 @@ public:
   bool SupportsFeatures(const uint32_t aFeatures);
   void SetProgram(GLuint aProgram);
   GLuint GetProgram() const;
+  // False until the program has been compiled and linked. Programs compiled in
+  // parallel may take several frames to become ready.
+  bool IsReady() const;
+  ProgramPtr GetMultiviewVariant() const;
+  void SetMultiviewVariant(const ProgramPtr& aProgram);
+  // Versions and values of the uniforms last uploaded to this program. RenderState
+  // uses it to skip uploads the program already has. Reset by SetProgram().
+  struct UniformCache {
+    uint32_t lightSet = 0;
+    uint32_t material = 0;
+    uint32_t tint = 0;
+    uint32_t uvTransform = 0;
+    uint32_t textureLayer = 0;
+    bool texture = false;
+    bool perspective = false;
+    bool view = false;
+    bool model = false;
+    float perspectiveData[16];
+    float viewData[16];
+    float modelData[16];
+  };
+  UniformCache& GetUniformCache();
+  // Locations are looked up in a table of the active attributes and uniforms that is
+  // built once when the program is set, so no GL queries are made.
   GLint GetAttributeLocation(const char* aName);
-  GLint GetAttributeLocation(const std::string &aName) { return GetAttributeLocation(aName.c_str()); }
+  GLint GetAttributeLocation(const std::string &aName);
   GLint GetUniformLocation(const char* aName);
-  GLint GetUniformLocation(const std::string &aName) { return GetUniformLocation(aName.c_str()); }
+  GLint GetUniformLocation(const std::string &aName);
 protected:
   struct State;
   Program(State& aState);
@@ -0,0 +1,42 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_PROGRAM_BINARY_CACHE_DOT_H
+#define VRB_PROGRAM_BINARY_CACHE_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/gl.h"
+
+#include <memory>
+#include <string>
+
+namespace vrb {
+
+// Stores linked program binaries on disk under the DataCache path. Entries are keyed
+// by the final shader sources and are ignored and removed when they were written by
+// a different driver or cache version. The cache only does file I/O, the GL calls are
+// made by the caller. It is safe to use from multiple threads.
+class ProgramBinaryCache {
+public:
+  static ProgramBinaryCachePtr Create(const DataCachePtr& aDataCache);
+  // Identifies the driver that produced the binaries, e.g. GL vendor, renderer and version.
+  void SetDriverIdentity(const std::string& aIdentity);
+  bool Load(const std::string& aKey, GLenum& aFormat, std::unique_ptr<uint8_t[]>& aBinary, size_t& aSize);
+  bool Store(const std::string& aKey, const GLenum aFormat, const uint8_t* aBinary, const size_t aSize);
+  void Remove(const std::string& aKey);
+protected:
+  struct State;
+  ProgramBinaryCache(State& aState);
+  ~ProgramBinaryCache() = default;
+private:
+  State& m;
+  ProgramBinaryCache() = delete;
+  VRB_NO_DEFAULTS(ProgramBinaryCache)
+};
+
+} // namespace vrb
+
+#endif // VRB_PROGRAM_BINARY_CACHE_DOT_H
@@ -8,6 +8,10 @@
 
 #include "vrb/Forward.h"
 #include "vrb/MacroUtils.h"
+#include "vrb/gl.h"
+
+#include <string>
+#include <vector>
 
 namespace vrb {
 
@@ -19,6 +23,13 @@ const uint32_t FeatureVertexColor = 0x1 << 4;
 // Defaults to medium precision
 const uint32_t FeatureHighPrecision = 0x01 << 5;
 const uint32_t FeatureLowPrecision = 0x01 << 6;
+// Set by the ProgramFactory on programs built with std140 uniform blocks.
+const uint32_t FeatureUniformBlocks = 0x01 << 7;
+// OVR_multiview2 variant drawing both eyes at once. Requires GLES3.
+const uint32_t FeatureMultiview = 0x01 << 8;
+// Samples a TextureArray at the layer a_uv.z plus RenderState::SetTextureLayer().
+// Requires GLES3.
+const uint32_t FeatureTextureArray = 0x01 << 9;
 
 
 class ProgramFactory {
@@ -27,6 +38,25 @@ public:
   void SetLoaderThread(LoaderThreadPtr aLoader);
   ProgramPtr CreateProgram(CreationContextPtr& aContext, const uint32_t aFeatureMask);
   ProgramPtr CreateProgram(CreationContextPtr& aContext, const uint32_t aFeatureMask, const std::string& aCustomFragShader);
+  // Creates the programs for the given feature masks ahead of time so they are compiled
+  // while loading instead of the first time a material with those features is drawn.
+  // Programs are compiled on the loader thread if set, otherwise on the next
+  // RenderContext::Update().
+  void PreloadPrograms(CreationContextPtr& aContext, const std::vector<uint32_t>& aFeatureMasks);
+  void SetUniformBlocksSupported(const bool aSupported);
+  // With KHR_parallel_shader_compile, programs built on the render thread are compiled
+  // in the background and only become ready once UpdatePendingPrograms() sees them finish.
+  void SetParallelCompileSupported(const bool aSupported);
+  // Polls programs still being compiled, called from RenderContext::Update().
+  // Returns the number of programs that are not ready yet.
+  int32_t UpdatePendingPrograms();
+  // Linked programs are loaded from and stored to aCache when set. Pass null to disable.
+  void SetProgramBinaryCache(const ProgramBinaryCachePtr& aCache);
+  // When enabled every program gets a multiview variant, see Program::GetMultiviewVariant().
+  // The variants are GLSL ES 3.00, so enabling fails without uniform block support and
+  // custom fragment shaders stay GLSL ES 1.00 until multiview is on.
+  bool SetMultiviewEnabled(CreationContextPtr& aContext, const bool aEnabled);
+  UniformBufferPtr GetSharedUniformBuffer(CreationContextPtr& aContext, const GLuint aBindingPoint, const GLsizeiptr aSize);
 protected:
   struct State;
   ProgramFactory(State& aState);
@@ -25,13 +25,22 @@ public:
   bool IsOnRenderThread();
   bool InitializeGL();
   void ShutdownGL();
+  // Builds multiview program variants for DrawableList::Draw(left, right). Requires OVR_multiview2.
+  bool SetMultiviewEnabled(const bool aEnabled);
   void Update();
+  // Limits the time Update spends initializing new resources each frame. Resources
+  // left over are initialized in later frames in priority order. Zero, the default,
+  // initializes every resource in the frame it was added.
+  void SetResourceInitializationBudget(const double aSeconds);
+  uint32_t GetPendingResourceCount() const;
   double GetTimestamp();
   double GetFrameDelta();
 
   ThreadIdentityPtr& GetRenderThreadIdentity();
   DataCachePtr& GetDataCache();
   TextureCachePtr& GetTextureCache();
+  TextureStreamerPtr& GetTextureStreamer();
+  TextureUploadQueuePtr& GetTextureUploadQueue();
   ProgramFactoryPtr& GetProgramFactory();
   CreationContextPtr& GetRenderThreadCreationContext();
   GLExtensionsPtr GetGLExtensions() const;
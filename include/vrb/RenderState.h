@@ -22,9 +22,17 @@ public:
   GLint AttributeNormal() const;
   GLint AttributeUV() const;
   GLint AttributeColor() const;
+  // Id of the current LightSet, changes whenever the lights change.
   uint32_t GetLightId() const;
-  void ResetLights(const uint32_t aId);
+  void SetLightSet(const LightSet& aLightSet);
+  void ResetLights();
   void AddLight(const Vector& aDirection, const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular);
+  // Number of light uploads to uniform buffers or program uniforms since startup.
+  static uint32_t GetLightUploadCount();
+  // Number of uniform group uploads made and skipped because the bound program
+  // already had the current values, since startup.
+  static uint32_t GetUniformUploadCount();
+  static uint32_t GetUniformSkipCount();
   void SetMaterial(const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular, const float aSpecularExponent);
   void SetAmbient(const Color& aColor);
   void SetDiffuse(const Color& aColor);
@@ -36,9 +44,16 @@ public:
   const Color& GetTintColor() const;
   void SetTintColor(const Color& aColor);
   bool Enable(const Matrix& aPerspective, const Matrix& aView, const Matrix& aModel);
+  // Enables the multiview variant of the program and uploads both eyes at once.
+  bool Enable(const Matrix& aLeftPerspective, const Matrix& aLeftView,
+              const Matrix& aRightPerspective, const Matrix& aRightView, const Matrix& aModel);
   void Disable();
   void SetLightsEnabled(bool aEnabled);
   void SetUVTransform(const vrb::Matrix& aMatrix);
+  // Layer of a TextureArray drawn with FeatureTextureArray programs. It is added to the
+  // z of the UVs, so Geometry sharing this RenderState may also pick layers per vertex.
+  void SetTextureLayer(const int32_t aLayer);
+  int32_t GetTextureLayer() const;
 protected:
   struct State;
   RenderState(State& aState, CreationContextPtr& aContext);
@@ -9,11 +9,21 @@
 #include "vrb/Forward.h"
 #include "vrb/MacroUtils.h"
 
+#include <cstdint>
+
 namespace vrb {
 
 class ResourceGL {
 public:
+  enum class Priority : uint8_t {
+    High,
+    Normal,
+    Low
+  };
   virtual bool SupportOffRenderThreadInitialization() { return false; }
+  // Resources with a higher priority are initialized first when RenderContext::Update
+  // runs out of its initialization budget.
+  virtual Priority GetInitializationPriority() { return Priority::Normal; }
   virtual void InitializeGL() = 0;
   virtual void ShutdownGL() = 0;
 protected:
@@ -7,6 +7,7 @@
 #define VRB_SHADER_UTIL_DOT_H
 
 #include "vrb/gl.h"
+#include <memory>
 #include <string>
 
 namespace vrb {
@@ -17,6 +18,20 @@ GLint GetUniformLocation(GLuint aProgram, const char* aName);
 GLint GetUniformLocation(GLuint aProgram, const std::string& aName);
 GLuint LoadShader(GLenum type, const char* src);
 GLuint CreateProgram (GLuint aVertexShader, GLuint aFragmentShader);
+// CompileShader and LinkProgram submit work without querying its status, which would
+// make the driver block. Query the results with CheckShaderCompiled and
+// CheckProgramLinked once the work is done, see GL_COMPLETION_STATUS_KHR.
+GLuint CompileShader(GLenum aType, const char* aSrc);
+// Compiles the concatenation of aCount null terminated strings.
+GLuint CompileShader(GLenum aType, GLsizei aCount, const char* const* aStrings);
+bool CheckShaderCompiled(GLuint aShader, const char* aSrc);
+GLuint LinkProgram(GLuint aVertexShader, GLuint aFragmentShader);
+bool CheckProgramLinked(GLuint aProgram);
+// Creates a program from a binary returned by GetProgramBinary. Returns 0 when the
+// driver rejects the binary, which is expected after driver updates.
+GLuint CreateProgramFromBinary(GLenum aFormat, const void* aBinary, GLsizei aLength);
+bool GetProgramBinary(GLuint aProgram, GLenum& aFormat, std::unique_ptr<uint8_t[]>& aBinary, GLsizei& aLength);
+void BindUniformBlock(GLuint aProgram, const char* aBlockName, GLuint aBindingPoint);
 
 } // namespace vrb
 
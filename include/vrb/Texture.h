@@ -22,6 +22,8 @@ public:
   GLenum GetTarget() const;
   void SetName(const std::string& aName);
   void SetTextureParameter(GLenum aName, GLint aParam);
+  // Zero when the parameter was never set.
+  GLint GetTextureParameter(GLenum aName) const;
   GLuint GetHandle() const;
 protected:
   struct State;
@@ -29,6 +31,8 @@ protected:
   virtual ~Texture();
 
   virtual void AboutToBind() {}
+  // Texture name bound by Bind().
+  virtual GLuint GetBindHandle() const;
 
 private:
   State& m;
@@ -0,0 +1,58 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_TEXTURE_ARRAY_DOT_H
+#define VRB_TEXTURE_ARRAY_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/ResourceGL.h"
+#include "vrb/Texture.h"
+
+#include "vrb/gl.h"
+#include <string>
+#include <vector>
+
+namespace vrb {
+
+// GL_TEXTURE_2D_ARRAY holding images of the same size and format as layers. Draw it
+// with a FeatureTextureArray program and pick the layer with RenderState::SetTextureLayer()
+// or the z of the UVs, so materials differing only by texture can share a RenderState.
+// The texture is created once every layer has image data. Requires GLES3.
+class TextureArray : public Texture, protected ResourceGL {
+public:
+  static TextureArrayPtr Create(CreationContextPtr& aContext);
+  // Loads one image file per layer.
+  static void Load(CreationContextPtr& aContext, const TextureArrayPtr& aTexture, const std::vector<std::string>& aFiles);
+  void SetLayerCount(const int32_t aCount);
+  int32_t GetLayerCount() const;
+  // The first image sets the size and format of the array, images that do not match
+  // are rejected.
+  void SetImageData(const int32_t aLayer, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat);
+  GLsizei GetWidth() const;
+  GLsizei GetHeight() const;
+protected:
+  struct State;
+  TextureArray(State& aState, CreationContextPtr& aContext);
+  ~TextureArray();
+
+  // Texture interface
+  void AboutToBind() override;
+
+  // ResourceGL interface
+  bool SupportOffRenderThreadInitialization() override;
+  Priority GetInitializationPriority() override;
+  void InitializeGL() override;
+  void ShutdownGL() override;
+
+private:
+  State& m;
+  TextureArray() = delete;
+  VRB_NO_DEFAULTS(TextureArray)
+};
+
+} // namespace vrb
+
+#endif // VRB_TEXTURE_ARRAY_DOT_H
@@ -0,0 +1,51 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_TEXTURE_ATLAS_DOT_H
+#define VRB_TEXTURE_ATLAS_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/Updatable.h"
+
+#include <cstdint>
+#include <string>
+
+namespace vrb {
+
+// Packs small RGBA images into shared atlas textures with shelf packing, so materials
+// using them can share a texture. Each image gets a gutter of repeated edge texels.
+// Its location is returned as a matrix for GeometryDrawable::SetUVTransform, so Geometry
+// drawing images of one page can share a RenderState. Atlased images can not repeat,
+// so only use them for texture coordinates within [0, 1].
+// Rows of a page changed by new images are uploaded at most once per frame.
+class TextureAtlas : protected Updatable {
+public:
+  static TextureAtlasPtr Create(CreationContextPtr& aContext, const int32_t aPageSize = 1024, const int32_t aMaxImageSize = 256);
+  // Images larger than this in either dimension are not added.
+  int32_t GetMaxImageSize() const;
+  int32_t GetPageCount() const;
+  // Returns the region of an image that was already added under aName.
+  bool Find(const std::string& aName, TextureGLPtr& aTexture, Matrix& aUVTransform);
+  // Copies a tightly packed GL_RGBA / GL_UNSIGNED_BYTE image into an atlas page.
+  // Returns false when the image is too large to be atlased.
+  bool Add(const std::string& aName, const uint8_t* aPixels, const int32_t aWidth, const int32_t aHeight,
+           TextureGLPtr& aTexture, Matrix& aUVTransform);
+protected:
+  struct State;
+  TextureAtlas(State& aState, CreationContextPtr& aContext);
+  ~TextureAtlas();
+
+  // Updatable interface
+  void UpdateResource(RenderContext& aContext) override;
+private:
+  State& m;
+  TextureAtlas() = delete;
+  VRB_NO_DEFAULTS(TextureAtlas)
+};
+
+} // namespace vrb
+
+#endif // VRB_TEXTURE_ATLAS_DOT_H
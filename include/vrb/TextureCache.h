@@ -9,18 +9,46 @@
 #include "vrb/Forward.h"
 #include "vrb/MacroUtils.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace vrb {
 
+// Textures loaded by name. When a memory budget is set, cached textures that are no
+// longer referenced outside of the cache are evicted in least recently bound order
+// until the resident sizes fit the budget again.
 class TextureCache {
 public:
+  struct Stats {
+    uint32_t textures;
+    uint32_t residentTextures;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t gpuBytes;
+    size_t cpuBytes;
+    Stats()
+        : textures(0)
+        , residentTextures(0)
+        , hits(0)
+        , misses(0)
+        , evictions(0)
+        , gpuBytes(0)
+        , cpuBytes(0)
+    {}
+  };
   static TextureCachePtr Create();
   void Init(CreationContextPtr& aContext);
   void Shutdown();
   TextureGLPtr FindTexture(const std::string& aTextureName);
   void AddTexture(const std::string& aTextureName, TextureGLPtr& aTexture);
   TextureGLPtr GetDefaultTexture();
+  // A budget of zero is unlimited, which is the default.
+  void SetMemoryBudget(const size_t aGPUBytes, const size_t aCPUBytes);
+  // Evicts textures that exceed the budget. Called by RenderContext::Update.
+  void Update();
+  Stats GetStats();
 protected:
   struct State;
   TextureCache(State& aState);
@@ -6,6 +6,7 @@
 #ifndef VRB_TEXTURE_GL_DOT_H
 #define VRB_TEXTURE_GL_DOT_H
 
+#include "vrb/FileReader.h"
 #include "vrb/Forward.h"
 #include "vrb/MacroUtils.h"
 #include "vrb/ResourceGL.h"
@@ -21,8 +22,54 @@ public:
   static TextureGLPtr Create(CreationContextPtr& aContext);
 
   void SetImageData(std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat);
+  // Shares a whole image container and uploads every level and cube face listed in
+  // aLayout straight from it. A mipmapped GL_TEXTURE_MIN_FILTER is needed to sample
+  // the lower levels.
+  void SetImageLevels(const DataBufferPtr& aImage, const ImageLayout& aLayout);
+  // Keeps the image data in memory after it is uploaded instead of releasing it to
+  // its source file or the DataCache. Needed by UpdateImageRows().
+  void SetRetainImageData(const bool aRetain);
+  // Uploads rows of level 0 again from the retained image data after its owner changed
+  // them. Does nothing until the texture is created, since that uploads the whole
+  // image. Uncompressed 2D textures only. Render thread only.
+  void UpdateImageRows(const GLint aY, const GLsizei aHeight);
   GLsizei GetWidth() const;
   GLsizei GetHeight() const;
+  // Bytes of the uploaded levels while the texture exists on the GPU.
+  size_t GetGPUByteSize() const;
+  // Bytes of image data currently held in memory.
+  size_t GetCPUByteSize() const;
+  // Increases every time the texture is bound, used to find the least recently used.
+  uint32_t GetBindSerial() const;
+  // Deletes the GL texture and releases the image data to its source file or the
+  // DataCache. The texture is recreated the next time it is bound. Must be called
+  // on the render thread.
+  void Evict();
+  // Uploads go through the queue when it is enabled, the default is the queue of the
+  // CreationContext. Null uploads synchronously on the first bind.
+  void SetUploadQueue(const TextureUploadQueuePtr& aQueue);
+  // True while the placeholder texture is bound in place of this one.
+  bool IsUploading() const;
+  // False until InitializeGL() has run, the loader thread may still be creating the texture.
+  bool IsInitialized() const;
+  // Mipmapped textures only upload the levels the streamer selects while it is
+  // enabled, the default is the streamer of the CreationContext. Null uploads every level.
+  void SetTextureStreamer(const TextureStreamerPtr& aStreamer);
+  GLint GetLevelCount() const;
+  // Finest level kept on the GPU while streaming, -1 when the texture is not streamed.
+  GLint GetStreamLevel() const;
+  // Finest level uploaded, GetLevelCount() while nothing is uploaded.
+  GLint GetResidentLevel() const;
+  // Bytes of the levels from aLevel to the coarsest one.
+  size_t GetLevelsByteSize(const GLint aLevel) const;
+
+  // Internal interface
+  // Uploads queued levels until aBudget is spent. Returns true once all are issued.
+  bool UploadQueued(TextureUploadQueue& aQueue, size_t& aBudget);
+  void FinishUpload();
+  // Uploads the missing levels down to aLevel, or recreates the texture without the
+  // levels finer than aLevel. Render thread only.
+  void SetStreamLevel(const GLint aLevel);
 protected:
   struct State;
   TextureGL(State& aState, CreationContextPtr& aContext);
@@ -30,9 +77,11 @@ protected:
 
   // Texture interface
   void AboutToBind() override;
+  GLuint GetBindHandle() const override;
 
   // ResourceGL interface
   bool SupportOffRenderThreadInitialization() override;
+  Priority GetInitializationPriority() override;
   void InitializeGL() override;
   void ShutdownGL() override;
 
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_TEXTURE_STREAMER_DOT_H
+#define VRB_TEXTURE_STREAMER_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+#include "vrb/gl.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace vrb {
+
+// Keeps only the mip levels of a TextureGL that are needed for its size on screen.
+// Mipmapped textures first upload their levels up to the coarse size, so they show
+// up quickly, and finer levels are uploaded once CompiledScene reports the texture
+// large enough on screen. Levels of textures that shrink or are no longer drawn are
+// dropped again. When the budget is exceeded the textures with the smallest screen
+// size are coarsened first. Streaming needs GL_TEXTURE_BASE_LEVEL, so it is only
+// enabled on GLES 3 contexts. Only CompiledScene reports sizes, Group::Cull does not,
+// so streaming also stays off until a CompiledScene uses the streamer.
+class TextureStreamer {
+public:
+  static TextureStreamerPtr Create();
+  void InitializeGL(const bool aSupported);
+  void SetEnabled(const bool aEnabled);
+  // True when enabled, supported and sizes are reported.
+  bool IsEnabled() const;
+  // Bytes of streamed levels to keep on the GPU, zero for no limit. Coarse levels
+  // are always kept.
+  void SetBudget(const size_t aBytes);
+  // Size in pixels of the levels every texture starts with, 64 by default.
+  void SetCoarseSize(const GLsizei aPixels);
+  // Height in pixels of the render target, used to convert the projected size.
+  void SetViewportHeight(const int32_t aPixels);
+  int32_t GetViewportHeight() const;
+  // Added to the selected level. Positive values save memory, negative values help
+  // textures tiled over an object.
+  void SetLevelBias(const float aBias);
+  // Finest level that fits in the coarse size.
+  GLint GetCoarseLevel(const GLsizei aWidth, const GLsizei aHeight, const GLint aLevelCount) const;
+  // Reports the height in pixels of an object drawn with aTexture this frame. Other
+  // textures are ignored. Render thread only.
+  void RequestSize(const Texture* aTexture, const float aPixels);
+  int32_t GetTextureCount() const;
+  // Bytes of all streamed textures on the GPU after the last Update.
+  size_t GetResidentByteSize() const;
+  // Must be called on the render thread, RenderContext::Update does so.
+  void Update();
+
+  // Internal interface
+  void Add(const TextureGLPtr& aTexture);
+  // Counts the objects reporting sizes with RequestSize().
+  void AddSizeSource();
+  void RemoveSizeSource();
+protected:
+  struct State;
+  TextureStreamer(State& aState);
+  ~TextureStreamer();
+private:
+  State& m;
+  TextureStreamer() = delete;
+  VRB_NO_DEFAULTS(TextureStreamer)
+};
+
+} // namespace vrb
+
+#endif // VRB_TEXTURE_STREAMER_DOT_H
@@ -0,0 +1,54 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_TEXTURE_UPLOAD_QUEUE_DOT_H
+#define VRB_TEXTURE_UPLOAD_QUEUE_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vrb {
+
+// Spreads TextureGL uploads over several frames. Each Update stages up to the frame
+// budget of image data in pixel buffer objects and issues the uploads from them.
+// Textures sample the placeholder texture until the fence that follows their last
+// upload has signaled. The queue is only enabled on GLES 3 contexts, otherwise
+// textures upload synchronously when first bound.
+class TextureUploadQueue {
+public:
+  static TextureUploadQueuePtr Create();
+  void InitializeGL(const bool aSupported);
+  void ShutdownGL();
+  bool IsEnabled() const;
+  // At least one level is uploaded per frame, even when it is larger than the budget.
+  void SetFrameBudget(const size_t aBytes);
+  void SetPlaceholder(const TextureGLPtr& aTexture);
+  TextureGLPtr GetPlaceholder();
+  // Number of textures waiting for their upload or its fence. Render thread only.
+  uint32_t GetPendingCount();
+  void Enqueue(const TextureGLPtr& aTexture);
+  // Must be called on the render thread, RenderContext::Update does so.
+  void Update();
+
+  // Internal interface
+  // Copies aData into a staging buffer and binds it to GL_PIXEL_UNPACK_BUFFER. Returns
+  // false when the data has to be uploaded from client memory instead.
+  bool Stage(const uint8_t* aData, const size_t aSize);
+protected:
+  struct State;
+  TextureUploadQueue(State& aState);
+  ~TextureUploadQueue();
+private:
+  State& m;
+  TextureUploadQueue() = delete;
+  VRB_NO_DEFAULTS(TextureUploadQueue)
+};
+
+} // namespace vrb
+
+#endif // VRB_TEXTURE_UPLOAD_QUEUE_DOT_H
@@ -22,6 +22,7 @@ public:
   const Matrix& GetTransform() const;
   virtual void SetTransform(const Matrix& aTransform);
 protected:
+  void InvalidateWorldTransform() override;
   struct State;
   Transform(State& aState, CreationContextPtr& aContext);
   ~Transform();
@@ -0,0 +1,46 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRB_UNIFORM_BUFFER_DOT_H
+#define VRB_UNIFORM_BUFFER_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/ResourceGL.h"
+
+#include "vrb/gl.h"
+
+namespace vrb {
+
+class UniformBuffer : protected ResourceGL {
+public:
+  static UniformBufferPtr Create(CreationContextPtr& aContext, const GLsizeiptr aSize);
+  GLsizeiptr GetSize() const;
+  // Uploads aData only when it differs from the last upload. Returns true if the buffer was written.
+  bool Update(const void* aData);
+  // Same as Update(aData) but skips the comparison when aVersion is non-zero and
+  // matches the version of the last upload.
+  bool Update(const void* aData, const uint32_t aVersion);
+  // Version passed to the last Update, zero if unversioned.
+  uint32_t GetVersion() const;
+  void Bind(const GLuint aBindingPoint);
+protected:
+  struct State;
+  UniformBuffer(State& aState, CreationContextPtr& aContext);
+  ~UniformBuffer();
+
+  // ResourceGL interface
+  void InitializeGL() override;
+  void ShutdownGL() override;
+
+private:
+  State& m;
+  UniformBuffer() = delete;
+  VRB_NO_DEFAULTS(UniformBuffer)
+};
+
+} // namespace vrb
+
+#endif // VRB_UNIFORM_BUFFER_DOT_H
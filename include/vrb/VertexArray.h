@@ -42,6 +42,12 @@ public:
 
   void AddNormal(const int aIndex, const Vector& aNormal);
 
+  // Changes whenever a vertex position is set or appended. Versions are unique across
+  // all vertex arrays.
+  uint32_t GetPositionVersion() const;
+  // Latest position version of any vertex array, lets callers skip checking each array.
+  static uint32_t GetPositionGeneration();
+
 protected:
   struct State;
   VertexArray(State& aState, CreationContextPtr& aContext);
@@ -9,24 +9,28 @@
 #include "vrb/DrawableList.h"
 #include "vrb/Color.h"
 #include "vrb/Light.h"
+#include "vrb/LightSet.h"
 #include "vrb/Matrix.h"
 
+#include <vector>
+
 namespace vrb {
 
 struct DrawableList::State {
   struct LightSnapshot {
     LightSnapshot* next;
     LightSnapshot* masterNext;
-    const uint32_t id;
+    // Index into lightSets of the lights from this snapshot down, -1 until resolved.
+    int32_t lightSet;
     const int depth;
     const Vector direction;
     const Color ambient;
     const Color diffuse;
     const Color specular;
-    LightSnapshot(const uint32_t aId, const int aDepth, const Light& aLight)
+    LightSnapshot(const int aDepth, const Light& aLight)
       : next(nullptr)
       , masterNext(nullptr)
-      , id(aId)
+      , lightSet(-1)
       , depth(aDepth)
       , direction(aLight.GetDirection())
       , ambient(aLight.GetAmbientColor())
@@ -37,21 +41,34 @@ struct DrawableList::State {
   struct DrawNode {
     DrawNode* next;
     LightSnapshot* lights;
-    DrawablePtr drawable;
+    int32_t lightSet;
+    Drawable* drawable;
+    // Null when the drawable is kept alive by its caller, see AddDrawable(Drawable&).
+    DrawablePtr owner;
     Matrix transform;
 
-    DrawNode() : next(nullptr), lights(nullptr) {}
+    DrawNode() : next(nullptr), lights(nullptr), lightSet(0), drawable(nullptr) {}
   };
 
   DrawNode* drawables;
+  // Nodes released by Reset(), reused by the next frame.
+  DrawNode* freeNodes;
   LightSnapshot* currentLights;
   LightSnapshot* lights;
-  uint32_t idCount;
   int depth;
+  // Light sets resolved once per frame. Entry zero is the empty set.
+  std::vector<LightSet> lightSets;
+  std::vector<LightSet> previousLightSets;
+  bool lightsResolved;
+  Stats stats;
 
-  State() : drawables(nullptr), currentLights(nullptr), lights(nullptr), idCount(0), depth(0) {}
-  ~State() { Reset(); }
+  State() : drawables(nullptr), freeNodes(nullptr), currentLights(nullptr), lights(nullptr), depth(0), lightsResolved(false) {}
+  ~State();
   void Reset();
+  DrawNode* AddNode(const Matrix& aTransform);
+  void ResolveLights();
+  int32_t ResolveLightSet(LightSnapshot* aSnapshot);
+  void UpdateLights(DrawNode& aNode);
 };
 
 }
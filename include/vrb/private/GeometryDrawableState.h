@@ -9,6 +9,7 @@
 #include "vrb/GeometryDrawable.h"
 #include <vrb/gl.h>
 #include <vrb/Logger.h>
+#include "vrb/Matrix.h"
 #include "vrb/private/DrawableState.h"
 #include "vrb/private/NodeState.h"
 #include "vrb/RenderBuffer.h"
@@ -22,6 +23,8 @@ struct GeometryDrawable::State : public Node::State, public Drawable::State {
 
   uint32_t rangeStart = 0;
   uint32_t rangeLength = 0;
+  Matrix uvTransform = Matrix::Identity();
+  bool hasUVTransform = false;
 
   bool UseTexture() const {
     if (!renderState || !renderBuffer) {
@@ -8,6 +8,9 @@
 
 #include "vrb/Forward.h"
 #include "vrb/private/NodeState.h"
+#include "vrb/Vector.h"
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace vrb {
@@ -16,16 +19,36 @@ class LambdaDrawable;
 typedef std::shared_ptr<LambdaDrawable> LambdaDrawablePtr;
 
 struct Group::State : public Node::State {
+  // Removed children leave a null slot so removal does not shift the vector.
+  // Slots are compacted once they make up half of the vector or an index is needed.
   std::vector<NodePtr> children;
+  std::unordered_map<const Node*, size_t> childIndex;
+  size_t removedCount = 0;
   std::vector<LightPtr> lights;
+  std::unordered_set<const Light*> lightSet;
   GroupWeak self;
   LambdaDrawablePtr preRenderLambda;
   LambdaDrawablePtr postRenderLambda;
+  std::vector<NodePtr> bakedNodes;
+  bool baked = false;
+  // Bounds of the enabled children in this Group's space, valid while
+  // cachedBoundsVersion and cachedPositionGeneration match.
+  Vector boundsMin;
+  Vector boundsMax;
+  bool hasBounds = false;
+  uint32_t cachedBoundsVersion = 0;
+  uint32_t cachedPositionGeneration = 0;
   LambdaDrawablePtr createLambdaDrawable(CreationContextPtr& aContext, const RenderLambda& aLambda);
   bool Contains(const Node& aNode);
   bool Contains(const Light& aLight);
+  void AppendChild(NodePtr&& aNode);
+  bool EraseChild(const Node& aNode);
+  void Compact();
+  void Reindex(const size_t aStart);
+  void CullBegin(DrawableList& aDrawables);
+  void CullEnd(DrawableList& aDrawables);
   virtual bool IsEnabled(const Node&) { return true; }
-  virtual void Clear() { children.clear(); }
+  virtual void Clear() { children.clear(); childIndex.clear(); removedCount = 0; }
 };
 
 }
@@ -16,6 +16,11 @@ namespace vrb {
 struct Node::State {
   std::string name;
   std::vector<GroupWeak> parents;
+  uint32_t kind = 0;
+  // Unique stamp replaced whenever this node or a node below it changes structure.
+  uint32_t version = 0;
+  // Like version, but also replaced when a Transform at or below this node moves.
+  uint32_t boundsVersion = 0;
 };
 
 }
@@ -66,6 +66,24 @@ struct ResourceGL::State {
     aHead.m.nextResource = &aTail;
   }
 
+  // Removes and returns the first resource in the list, null when only the tail is left.
+  ResourceGL* RemoveFirst() {
+    ResourceGL* first = nextResource;
+    if (!first || !first->m.nextResource) {
+      return nullptr;
+    }
+    first->m.RemoveFromCurrentList();
+    return first;
+  }
+
+  uint32_t Count() const {
+    uint32_t result = 0;
+    for (ResourceGL* current = nextResource; current && current->m.nextResource; current = current->m.nextResource) {
+      result++;
+    }
+    return result;
+  }
+
   void RemoveFromCurrentList() {
     if (!prevResource || !nextResource) {
       // can't remove head or tail
@@ -125,6 +143,14 @@ public:
     return m.nextResource != &mTail;
   }
 
+  ResourceGL* RemoveFirst() {
+    return m.RemoveFirst();
+  }
+
+  uint32_t GetCount() const {
+    return m.Count();
+  }
+
   void Append(vrb::ResourceGL* aResource)  {
     mTail.Prepend(aResource);
   }
@@ -14,8 +14,12 @@ namespace vrb {
 
 struct Transform::State : public Group::State {
   Matrix transform;
+  // Cached product of every Transform above and including this one. Invalidated
+  // by SetTransform() and reparenting, recalculated on demand.
+  Matrix worldTransform;
+  bool worldDirty;
 
-  State() : transform(Matrix::Identity()) {}
+  State() : transform(Matrix::Identity()), worldTransform(Matrix::Identity()), worldDirty(true) {}
 };
 
 }
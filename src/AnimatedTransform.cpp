@@ -210,6 +210,8 @@ AnimatedTransform::UpdateResource(RenderContext& aContext) {
     m.currentAnimationTransform.PreMultiplyInPlace(sampler->Update(delta));
   }
   m.transform = m.startTransform.PreMultiply(m.currentAnimationTransform);
+  BoundsChanged();
+  InvalidateWorldTransform();
 }
 
 } // namespace vrb
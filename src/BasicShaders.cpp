@@ -1,13 +1,11 @@
 namespace vrb {
 
+// The sources below have no #version line. They are compiled after one of the headers
+// and a preamble defining VRB_USE_TEXTURE, VRB_UV_TYPE, VRB_UV_TRANSFORM,
+// VRB_VERTEX_COLOR, VRB_UNIFORM_BLOCKS, VRB_MULTIVIEW, VRB_TEXTURE_ARRAY and
+// VRB_FRAGMENT_PRECISION.
 static const char* sVertexShaderSource = R"SHADER(
-#version 100
-
 #define MAX_LIGHTS 2
-#define VRB_USE_TEXTURE VRB_TEXTURE_STATE
-#define VRB_UV_TYPE VRB_TEXTURE_UV_TYPE
-#define VRB_UV_TRANSFORM VRB_UV_TRANSFORM_ENABLED
-#define VRB_VERTEX_COLOR VRB_VERTEX_COLOR_ENABLED
 
 struct Light {
   vec3 direction;
@@ -23,16 +21,47 @@ struct Material {
   float specularExponent;
 };
 
+#if VRB_UNIFORM_BLOCKS == 1
+layout(std140) uniform vrb_Camera {
+#if VRB_MULTIVIEW == 1
+  mat4 u_perspective[2];
+  mat4 u_view[2];
+#else
+  mat4 u_perspective;
+  mat4 u_view;
+#endif // VRB_MULTIVIEW
+};
+layout(std140) uniform vrb_Lights {
+  int u_lightCount;
+  Light u_lights[MAX_LIGHTS];
+};
+layout(std140) uniform vrb_Material {
+  Material u_material;
+  vec4 u_tintColor;
+};
+#else
 uniform mat4 u_perspective;
 uniform mat4 u_view;
-uniform mat4 u_model;
 uniform int u_lightCount;
 uniform Light u_lights[MAX_LIGHTS];
 uniform Material u_material;
 uniform vec4 u_tintColor;
+#endif // VRB_UNIFORM_BLOCKS
+uniform mat4 u_model;
+
+#if VRB_MULTIVIEW == 1
+#define VRB_PERSPECTIVE u_perspective[gl_ViewID_OVR]
+#define VRB_VIEW u_view[gl_ViewID_OVR]
+#else
+#define VRB_PERSPECTIVE u_perspective
+#define VRB_VIEW u_view
+#endif // VRB_MULTIVIEW
 #if VRB_UV_TRANSFORM == 1
 uniform mat4 u_uv_transform;
 #endif
+#if VRB_TEXTURE_ARRAY == 1
+uniform float u_textureLayer;
+#endif
 
 attribute vec3 a_position;
 attribute vec3 a_normal;
@@ -53,7 +82,7 @@ vec4 normal;
 vec4
 calculate_light(int index) {
   vec4 result = vec4(0, 0, 0, 0);
-  vec4 direction = -normalize(u_view * vec4(u_lights[index].direction.xyz, 0));
+  vec4 direction = -normalize(VRB_VIEW * vec4(u_lights[index].direction.xyz, 0));
   vec4 hvec;
   float ndotl;
   float ndoth;
@@ -71,7 +100,7 @@ calculate_light(int index) {
 void main(void) {
   int ix;
   v_color = vec4(0, 0, 0, 0);
-  normal = normalize(u_view * u_model * vec4(a_normal.xyz, 0));
+  normal = normalize(VRB_VIEW * u_model * vec4(a_normal.xyz, 0));
   for(ix = 0; ix < MAX_LIGHTS; ix++) {
     if (ix >= u_lightCount) {
       break;
@@ -87,19 +116,26 @@ void main(void) {
 #endif
   v_color *= u_tintColor;
 #ifdef VRB_USE_TEXTURE
+#if VRB_TEXTURE_ARRAY == 1
 #if VRB_UV_TRANSFORM == 1
+  v_uv.xy = (u_uv_transform * vec4(a_uv.xy, 0, 1)).xy;
+#else
+  v_uv.xy = a_uv.xy;
+#endif // VRB_UV_TRANSFORM
+  // Two component UV attributes read a z of zero, leaving the layer to the uniform.
+  v_uv.z = a_uv.z + u_textureLayer;
+#elif VRB_UV_TRANSFORM == 1
   v_uv = (u_uv_transform * vec4(a_uv.xy, 0, 1)).xy;
 #else
   v_uv = a_uv;
-#endif // VRB_UV_TRANSFORM
+#endif // VRB_TEXTURE_ARRAY
 #endif // VRB_USE_TEXTURE
-  gl_Position = u_perspective * u_view * u_model * vec4(a_position.xyz, 1);
+  gl_Position = VRB_PERSPECTIVE * VRB_VIEW * u_model * vec4(a_position.xyz, 1);
 }
 
 )SHADER";
 
 static const char* sFragmentShaderSource = R"SHADER(
-#version 100
 precision VRB_FRAGMENT_PRECISION float;
 
 varying vec4 v_color;
@@ -111,7 +147,6 @@ void main() {
 )SHADER";
 
 static const char* sFragmentTextureShaderSource = R"SHADER(
-#version 100
 precision VRB_FRAGMENT_PRECISION float;
 
 uniform sampler2D u_texture0;
@@ -125,8 +160,6 @@ void main() {
 )SHADER";
 
 static const char* sFragmentSurfaceTextureShaderSource = R"SHADER(
-#version 100
-#extension GL_OES_EGL_image_external : require
 precision VRB_FRAGMENT_PRECISION float;
 
 uniform samplerExternalOES u_texture0;
@@ -140,7 +173,6 @@ void main() {
 )SHADER";
 
 static const char* sFragmentCubeMapTextureShaderSource = R"SHADER(
-#version 100
 precision VRB_FRAGMENT_PRECISION float;
 
 uniform samplerCube u_texture0;
@@ -153,6 +185,46 @@ void main() {
 
 )SHADER";
 
+// Only compiled as GLSL ES 3.00. The layer in v_uv.z is rounded to the nearest layer.
+static const char* sFragmentTextureArrayShaderSource = R"SHADER(
+precision VRB_FRAGMENT_PRECISION float;
+
+uniform mediump sampler2DArray u_texture0;
+varying vec4 v_color;
+varying vec3 v_uv;
+
+void main() {
+  gl_FragColor = texture(u_texture0, v_uv) * v_color;
+}
+
+)SHADER";
+
+static const char* sShaderES2Header = R"SHADER(#version 100
+)SHADER";
+
+static const char* sVertexShaderES3Header = R"SHADER(#version 300 es
+#define attribute in
+#define varying out
+)SHADER";
+
+static const char* sVertexShaderMultiviewHeader = R"SHADER(#version 300 es
+#extension GL_OVR_multiview2 : require
+layout(num_views = 2) in;
+#define attribute in
+#define varying out
+)SHADER";
+
+static const char* sFragmentShaderES3Header = R"SHADER(#version 300 es
+)SHADER";
+
+// Follows the #extension lines, which must come straight after the #version line.
+static const char* sFragmentShaderES3Prologue = R"SHADER(#define varying in
+#define texture2D texture
+#define textureCube texture
+#define gl_FragColor vrb_FragColor
+out mediump vec4 vrb_FragColor;
+)SHADER";
+
 const char*
 GetVertexShaderSource() { return sVertexShaderSource; }
 
@@ -168,4 +240,22 @@ GetFragmentSurfaceTextureShaderSource() { return sFragmentSurfaceTextureShaderSo
 const char*
 GetFragmentCubeMapTextureShaderSource() { return sFragmentCubeMapTextureShaderSource; }
 
+const char*
+GetFragmentTextureArrayShaderSource() { return sFragmentTextureArrayShaderSource; }
+
+const char*
+GetShaderES2Header() { return sShaderES2Header; }
+
+const char*
+GetVertexShaderES3Header() { return sVertexShaderES3Header; }
+
+const char*
+GetVertexShaderMultiviewHeader() { return sVertexShaderMultiviewHeader; }
+
+const char*
+GetFragmentShaderES3Header() { return sFragmentShaderES3Header; }
+
+const char*
+GetFragmentShaderES3Prologue() { return sFragmentShaderES3Prologue; }
+
 } // namespace vrb
@@ -0,0 +1,609 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/CompiledScene.h"
+#include "vrb/private/GroupState.h"
+
+#include "vrb/Camera.h"
+#include "vrb/ConcreteClass.h"
+#include "vrb/CullVisitor.h"
+#include "vrb/DrawableList.h"
+#include "vrb/Geometry.h"
+#include "vrb/GeometryDrawable.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/RenderState.h"
+#include "vrb/TextureStreamer.h"
+#include "vrb/Transform.h"
+#include "vrb/Vector.h"
+#include "vrb/VertexArray.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Appends the entries [aBegin, aEnd) of aSource to aDest.
+template<typename T>
+void
+MoveRange(std::vector<T>& aDest, std::vector<T>& aSource, const int32_t aBegin, const int32_t aEnd) {
+  aDest.insert(aDest.end(), std::make_move_iterator(aSource.begin() + aBegin), std::make_move_iterator(aSource.begin() + aEnd));
+}
+
+}
+
+namespace vrb {
+
+struct CompiledScene::State {
+  enum class Kind : uint8_t {
+    // Group with lights or render lambdas.
+    Group,
+    // Group that only holds children, Cull() skips it.
+    PlainGroup,
+    Drawable,
+    Other
+  };
+
+  // One entry per node in depth first order. A node's subtree occupies the entries
+  // in the range [index, subtreeEnd[index]).
+  struct Table {
+    std::vector<Kind> kinds;
+    std::vector<int32_t> parents;
+    std::vector<int32_t> subtreeEnd;
+    std::vector<Node*> nodes;
+    // Node::GetVersion() when the entry was compiled.
+    std::vector<uint32_t> versions;
+    std::vector<Transform*> transforms;
+    // World transform of Transform entries and of a non Transform root. Other entries
+    // use the world of their worldSources entry, the closest Transform above them.
+    std::vector<Matrix> worlds;
+    std::vector<int32_t> worldSources;
+    // Changes whenever the world transform of the entry changes.
+    std::vector<uint32_t> worldStamps;
+    // Bounds version of the Group when its world transforms were last updated, zero
+    // when they must be updated.
+    std::vector<uint32_t> worldVersions;
+    std::vector<Geometry*> geometries;
+    // Geometry::GetBoundsVersion() of the bounds below.
+    std::vector<uint32_t> boundsVersions;
+    std::vector<Vector> boundsCenter;
+    std::vector<Vector> boundsExtent;
+    std::vector<uint8_t> hasBounds;
+    std::vector<Group*> groups;
+    std::vector<DrawablePtr> drawables;
+    std::vector<Node*> others;
+
+    int32_t Size() const { return (int32_t)kinds.size(); }
+    void Clear();
+    void MoveSubtree(Table& aSource, const int32_t aIndex, const int32_t aParent);
+  };
+
+  GroupPtr root;
+  CameraPtr frustumCamera;
+  TextureStreamerPtr streamer;
+  bool compiled;
+  uint32_t rootVersion;
+  uint32_t positionGeneration;
+  Table table;
+  // Previous table while it is updated, kept to reuse its allocations.
+  Table previous;
+  uint32_t worldStamp;
+  // Entries Cull() visits, every entry but the plain groups.
+  std::vector<int32_t> cullEntries;
+  // Per drawable entry, in table order: the entry, its world space bounds box, the world
+  // stamp the box was computed for and the frustum visibility.
+  std::vector<int32_t> drawableEntries;
+  std::vector<Vector> worldCenters;
+  std::vector<Vector> worldExtents;
+  std::vector<uint32_t> worldBoundsStamps;
+  std::vector<uint8_t> visible;
+  // Drawables removed by a compile. A DrawableList refers to the drawables of the last
+  // Cull() without holding them, so they are released on the next Cull().
+  std::vector<DrawablePtr> retiredDrawables;
+
+  std::vector<int32_t> openGroups;
+  float planes[6][4];
+  Matrix viewBase;
+  float pixelsPerUnit;
+
+  State() : compiled(false), rootVersion(0), positionGeneration(0), worldStamp(0), pixelsPerUnit(0.0f) {}
+  void Clear();
+  void Retire(Table& aTable);
+  void UpdateCullEntries();
+  void ReadBounds(const int32_t aIndex);
+  int32_t Append(Node& aNode, const int32_t aParent);
+  void AppendSubtree(Node& aNode, const int32_t aParent);
+  void UpdateSubtree(const int32_t aPreviousIndex, const int32_t aParent);
+  void UpdateBounds();
+  void UpdateWorldTransforms();
+  void UpdateWorldBounds(const size_t aDrawable);
+  void UpdateFrustum(const Matrix& aBaseTransform);
+  bool IsVisible(const size_t aDrawable) const;
+  void RequestTextureSize(const int32_t aIndex);
+};
+
+void
+CompiledScene::State::Table::Clear() {
+  kinds.clear();
+  parents.clear();
+  subtreeEnd.clear();
+  nodes.clear();
+  versions.clear();
+  transforms.clear();
+  worlds.clear();
+  worldSources.clear();
+  worldStamps.clear();
+  worldVersions.clear();
+  geometries.clear();
+  boundsVersions.clear();
+  boundsCenter.clear();
+  boundsExtent.clear();
+  hasBounds.clear();
+  groups.clear();
+  drawables.clear();
+  others.clear();
+}
+
+// Moves an unchanged subtree over from aSource, only its indices change.
+void
+CompiledScene::State::Table::MoveSubtree(Table& aSource, const int32_t aIndex, const int32_t aParent) {
+  const int32_t kBegin = aIndex;
+  const int32_t kEnd = aSource.subtreeEnd[aIndex];
+  const int32_t kFirst = Size();
+  const int32_t kOffset = kFirst - kBegin;
+  MoveRange(kinds, aSource.kinds, kBegin, kEnd);
+  MoveRange(parents, aSource.parents, kBegin, kEnd);
+  MoveRange(subtreeEnd, aSource.subtreeEnd, kBegin, kEnd);
+  MoveRange(nodes, aSource.nodes, kBegin, kEnd);
+  MoveRange(versions, aSource.versions, kBegin, kEnd);
+  MoveRange(transforms, aSource.transforms, kBegin, kEnd);
+  MoveRange(worlds, aSource.worlds, kBegin, kEnd);
+  MoveRange(worldSources, aSource.worldSources, kBegin, kEnd);
+  MoveRange(worldStamps, aSource.worldStamps, kBegin, kEnd);
+  MoveRange(worldVersions, aSource.worldVersions, kBegin, kEnd);
+  MoveRange(geometries, aSource.geometries, kBegin, kEnd);
+  MoveRange(boundsVersions, aSource.boundsVersions, kBegin, kEnd);
+  MoveRange(boundsCenter, aSource.boundsCenter, kBegin, kEnd);
+  MoveRange(boundsExtent, aSource.boundsExtent, kBegin, kEnd);
+  MoveRange(hasBounds, aSource.hasBounds, kBegin, kEnd);
+  MoveRange(groups, aSource.groups, kBegin, kEnd);
+  MoveRange(drawables, aSource.drawables, kBegin, kEnd);
+  MoveRange(others, aSource.others, kBegin, kEnd);
+  parents[kFirst] = aParent;
+  // The new parent may have another world transform, the subtree is updated on the next Cull().
+  const int32_t kRootSource = (transforms[kFirst] || (aParent < 0)) ? kFirst : worldSources[aParent];
+  for (int32_t ix = kFirst; ix < Size(); ix++) {
+    if (ix > kFirst) {
+      parents[ix] += kOffset;
+    }
+    subtreeEnd[ix] += kOffset;
+    worldSources[ix] = worldSources[ix] < kBegin ? kRootSource : worldSources[ix] + kOffset;
+    worldVersions[ix] = 0;
+  }
+  worldSources[kFirst] = kRootSource;
+  if (kRootSource == kFirst && !transforms[kFirst]) {
+    worlds[kFirst] = Matrix::Identity();
+  }
+}
+
+void
+CompiledScene::State::Clear() {
+  Retire(table);
+  Retire(previous);
+  table.Clear();
+  previous.Clear();
+  cullEntries.clear();
+  drawableEntries.clear();
+  rootVersion = 0;
+}
+
+// Keeps the drawables that are still in aTable until the next Cull().
+void
+CompiledScene::State::Retire(Table& aTable) {
+  for (DrawablePtr& drawable: aTable.drawables) {
+    if (drawable) {
+      retiredDrawables.push_back(std::move(drawable));
+    }
+  }
+}
+
+// The world bounds of every drawable are computed again on the next Cull().
+void
+CompiledScene::State::UpdateCullEntries() {
+  cullEntries.clear();
+  drawableEntries.clear();
+  const int32_t count = table.Size();
+  for (int32_t ix = 0; ix < count; ix++) {
+    if (table.kinds[ix] != Kind::PlainGroup) {
+      cullEntries.push_back(ix);
+    }
+    if (table.kinds[ix] == Kind::Drawable) {
+      drawableEntries.push_back(ix);
+    }
+  }
+  worldCenters.resize(drawableEntries.size());
+  worldExtents.resize(drawableEntries.size());
+  worldBoundsStamps.assign(drawableEntries.size(), 0);
+  visible.resize(drawableEntries.size());
+}
+
+void
+CompiledScene::State::ReadBounds(const int32_t aIndex) {
+  Geometry* geometry = table.geometries[aIndex];
+  Vector min, max;
+  const bool kBounds = geometry && geometry->GetBounds(min, max);
+  table.boundsVersions[aIndex] = geometry ? geometry->GetBoundsVersion() : 0;
+  table.boundsCenter[aIndex] = kBounds ? (min + max) * 0.5f : Vector();
+  table.boundsExtent[aIndex] = kBounds ? (max - min) * 0.5f : Vector();
+  table.hasBounds[aIndex] = kBounds;
+}
+
+int32_t
+CompiledScene::State::Append(Node& aNode, const int32_t aParent) {
+  const int32_t index = table.Size();
+  Kind kind = Kind::Other;
+  Group* group = nullptr;
+  GeometryDrawable* drawable = nullptr;
+  if (aNode.IsKind(Node::KindGroup)) {
+    group = static_cast<Group*>(&aNode);
+    // Lights and render lambdas change the node version, so this is compiled again.
+    const Group::State& state = group->m;
+    kind = (state.lights.empty() && !state.preRenderLambda && !state.postRenderLambda) ? Kind::PlainGroup : Kind::Group;
+  } else if (aNode.IsKind(Node::KindDrawable)) {
+    kind = Kind::Drawable;
+    drawable = static_cast<GeometryDrawable*>(&aNode);
+  }
+  table.kinds.push_back(kind);
+  table.parents.push_back(aParent);
+  table.subtreeEnd.push_back(index + 1);
+  table.nodes.push_back(&aNode);
+  table.versions.push_back(aNode.GetVersion());
+  table.transforms.push_back(aNode.IsKind(Node::KindTransform) ? static_cast<Transform*>(group) : nullptr);
+  table.worlds.push_back(Matrix::Identity());
+  table.worldSources.push_back((table.transforms[index] || (aParent < 0)) ? index : table.worldSources[aParent]);
+  table.worldStamps.push_back(++worldStamp);
+  table.worldVersions.push_back(0);
+  table.geometries.push_back(aNode.IsKind(Node::KindGeometry) ? static_cast<Geometry*>(drawable) : nullptr);
+  table.boundsVersions.push_back(0);
+  table.boundsCenter.push_back(Vector());
+  table.boundsExtent.push_back(Vector());
+  table.hasBounds.push_back(false);
+  table.groups.push_back(group);
+  table.drawables.push_back(drawable ? drawable->CreateDrawablePtr() : nullptr);
+  table.others.push_back(kind == Kind::Other ? &aNode : nullptr);
+  ReadBounds(index);
+  return index;
+}
+
+// Compiles aNode and everything below it from the graph.
+void
+CompiledScene::State::AppendSubtree(Node& aNode, const int32_t aParent) {
+  const int32_t first = Append(aNode, aParent);
+  if (!table.groups[first]) {
+    return;
+  }
+  // Pairs of entry index and next child to visit.
+  std::vector<std::pair<int32_t, size_t>> stack;
+  stack.emplace_back(first, 0);
+  while (!stack.empty()) {
+    const int32_t index = stack.back().first;
+    Group::State& group = table.groups[index]->m;
+    std::vector<NodePtr>& children = group.baked ? group.bakedNodes : group.children;
+    size_t& next = stack.back().second;
+    while ((next < children.size()) && (!children[next] || !group.IsEnabled(*children[next]))) {
+      next++;
+    }
+    if (next >= children.size()) {
+      table.subtreeEnd[index] = table.Size();
+      stack.pop_back();
+      continue;
+    }
+    Node& child = *children[next];
+    next++;
+    const int32_t childIndex = Append(child, index);
+    if (table.groups[childIndex]) {
+      stack.emplace_back(childIndex, 0);
+    }
+  }
+}
+
+// Moves subtrees whose version did not change from the previous table and only
+// compiles the changed nodes again.
+void
+CompiledScene::State::UpdateSubtree(const int32_t aPreviousIndex, const int32_t aParent) {
+  Node& node = *previous.nodes[aPreviousIndex];
+  if (node.GetVersion() == previous.versions[aPreviousIndex]) {
+    table.MoveSubtree(previous, aPreviousIndex, aParent);
+    return;
+  }
+  if (!previous.groups[aPreviousIndex] || !node.IsKind(Node::KindGroup)) {
+    AppendSubtree(node, aParent);
+    return;
+  }
+  std::unordered_map<Node*, int32_t> compiledChildren;
+  for (int32_t child = aPreviousIndex + 1; child < previous.subtreeEnd[aPreviousIndex]; child = previous.subtreeEnd[child]) {
+    compiledChildren[previous.nodes[child]] = child;
+  }
+  const int32_t index = Append(node, aParent);
+  Group::State& group = table.groups[index]->m;
+  for (NodePtr& child: (group.baked ? group.bakedNodes : group.children)) {
+    if (!child || !group.IsEnabled(*child)) {
+      continue;
+    }
+    auto compiled = compiledChildren.find(child.get());
+    if (compiled != compiledChildren.end()) {
+      UpdateSubtree(compiled->second, index);
+    } else {
+      AppendSubtree(*child, index);
+    }
+  }
+  table.subtreeEnd[index] = table.Size();
+}
+
+void
+CompiledScene::State::UpdateBounds() {
+  for (size_t drawable = 0; drawable < drawableEntries.size(); drawable++) {
+    const int32_t ix = drawableEntries[drawable];
+    Geometry* geometry = table.geometries[ix];
+    if (geometry && (geometry->GetBoundsVersion() != table.boundsVersions[ix])) {
+      ReadBounds(ix);
+      worldBoundsStamps[drawable] = 0;
+    }
+  }
+}
+
+// Only walks the Groups whose bounds version changed, Transform::SetTransform()
+// stamps the transform and its ancestors. When a world transform changes, everything
+// below it is updated.
+void
+CompiledScene::State::UpdateWorldTransforms() {
+  const int32_t count = table.Size();
+  int32_t movedEnd = 0;
+  int32_t ix = 0;
+  while (ix < count) {
+    Group* group = table.groups[ix];
+    if (!group) {
+      ix++;
+      continue;
+    }
+    const uint32_t kVersion = group->m.boundsVersion;
+    if ((ix >= movedEnd) && (table.worldVersions[ix] == kVersion)) {
+      ix = table.subtreeEnd[ix];
+      continue;
+    }
+    table.worldVersions[ix] = kVersion;
+    Transform* transform = table.transforms[ix];
+    if (transform) {
+      const int32_t parent = table.parents[ix];
+      const Matrix world = parent < 0 ? transform->GetTransform() : table.worlds[table.worldSources[parent]].PostMultiply(transform->GetTransform());
+      if (memcmp(&world, &table.worlds[ix], sizeof(Matrix)) != 0) {
+        table.worlds[ix] = world;
+        table.worldStamps[ix] = ++worldStamp;
+        movedEnd = std::max(movedEnd, table.subtreeEnd[ix]);
+      }
+    }
+    ix++;
+  }
+}
+
+void
+CompiledScene::State::UpdateFrustum(const Matrix& aBaseTransform) {
+  const Matrix clip = frustumCamera->GetPerspective().PostMultiply(frustumCamera->GetView()).PostMultiply(aBaseTransform);
+  viewBase = frustumCamera->GetView().PostMultiply(aBaseTransform);
+  // Projected height in pixels of a sphere with a radius of one, one unit in front of the camera.
+  pixelsPerUnit = frustumCamera->GetPerspective().At(1, 1) * (streamer ? (float)streamer->GetViewportHeight() : 0.0f);
+  for (int32_t plane = 0; plane < 6; plane++) {
+    const int32_t row = plane / 2;
+    const float sign = (plane % 2) == 0 ? 1.0f : -1.0f;
+    for (int32_t column = 0; column < 4; column++) {
+      planes[plane][column] = clip.At(column, 3) + (sign * clip.At(column, row));
+    }
+  }
+}
+
+// Transforms the local bounds box of the drawable by its center and extent.
+void
+CompiledScene::State::UpdateWorldBounds(const size_t aDrawable) {
+  const int32_t ix = drawableEntries[aDrawable];
+  const int32_t source = table.worldSources[ix];
+  worldBoundsStamps[aDrawable] = table.worldStamps[source];
+  if (!table.hasBounds[ix]) {
+    return;
+  }
+  const Matrix& world = table.worlds[source];
+  const Vector& local = table.boundsExtent[ix];
+  float extent[3];
+  for (int32_t row = 0; row < 3; row++) {
+    extent[row] = std::fabs(world.At(0, row)) * local.x() +
+                  std::fabs(world.At(1, row)) * local.y() +
+                  std::fabs(world.At(2, row)) * local.z();
+  }
+  worldCenters[aDrawable] = world.MultiplyPosition(table.boundsCenter[ix]);
+  worldExtents[aDrawable] = Vector(extent[0], extent[1], extent[2]);
+}
+
+bool
+CompiledScene::State::IsVisible(const size_t aDrawable) const {
+  if (!table.hasBounds[drawableEntries[aDrawable]]) {
+    return true;
+  }
+  const Vector& center = worldCenters[aDrawable];
+  const Vector& extent = worldExtents[aDrawable];
+  for (int32_t plane = 0; plane < 6; plane++) {
+    const float* p = planes[plane];
+    const float distance = p[0] * center.x() + p[1] * center.y() + p[2] * center.z() + p[3];
+    const float radius = std::fabs(p[0]) * extent.x() + std::fabs(p[1]) * extent.y() + std::fabs(p[2]) * extent.z();
+    if ((distance + radius) < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Estimates the height on screen of the drawable from its bounding sphere.
+void
+CompiledScene::State::RequestTextureSize(const int32_t aIndex) {
+  if (!table.hasBounds[aIndex]) {
+    return;
+  }
+  RenderStatePtr& state = table.drawables[aIndex]->GetRenderState();
+  TexturePtr texture = state ? state->GetTexture() : nullptr;
+  if (!texture) {
+    return;
+  }
+  const Matrix& world = table.worlds[table.worldSources[aIndex]];
+  const Vector center = viewBase.MultiplyPosition(world.MultiplyPosition(table.boundsCenter[aIndex]));
+  float scale = 0.0f;
+  for (int32_t column = 0; column < 3; column++) {
+    scale = std::max(scale, Vector(world.At(column, 0), world.At(column, 1), world.At(column, 2)).Magnitude());
+  }
+  const float radius = table.boundsExtent[aIndex].Magnitude() * scale;
+  const float depth = -center.z();
+  const float pixels = depth > radius ? (radius * pixelsPerUnit / depth) : std::numeric_limits<float>::max();
+  streamer->RequestSize(texture.get(), pixels);
+}
+
+CompiledScenePtr
+CompiledScene::Create(CreationContextPtr& aContext) {
+  return std::make_shared<ConcreteClass<CompiledScene, CompiledScene::State> >(aContext);
+}
+
+void
+CompiledScene::SetRoot(const GroupPtr& aRoot) {
+  m.root = aRoot;
+  m.compiled = false;
+  m.Clear();
+}
+
+void
+CompiledScene::SetFrustumCamera(const CameraPtr& aCamera) {
+  m.frustumCamera = aCamera;
+}
+
+void
+CompiledScene::SetTextureStreamer(const TextureStreamerPtr& aStreamer) {
+  if (aStreamer) {
+    aStreamer->AddSizeSource();
+  }
+  if (m.streamer) {
+    m.streamer->RemoveSizeSource();
+  }
+  m.streamer = aStreamer;
+}
+
+bool
+CompiledScene::IsCompiled() const {
+  return m.compiled && (!m.root || (m.rootVersion == m.root->GetVersion()));
+}
+
+void
+CompiledScene::Compile() {
+  const bool kIncremental = m.compiled && m.root && (m.table.Size() > 0) && (m.table.nodes[0] == m.root.get());
+  m.compiled = true;
+  m.positionGeneration = VertexArray::GetPositionGeneration();
+  if (!m.root) {
+    m.Clear();
+    return;
+  }
+  if (kIncremental) {
+    std::swap(m.table, m.previous);
+    m.table.Clear();
+    m.UpdateSubtree(0, -1);
+    m.Retire(m.previous);
+    m.previous.Clear();
+  } else {
+    m.Clear();
+    m.AppendSubtree(*m.root, -1);
+    VRB_LOG("Compiled scene with %d nodes", (int)m.table.Size());
+  }
+  m.UpdateCullEntries();
+  m.rootVersion = m.root->GetVersion();
+}
+
+int32_t
+CompiledScene::GetNodeCount() const {
+  return m.table.Size();
+}
+
+void
+CompiledScene::Cull(CullVisitor& aVisitor, DrawableList& aDrawables) {
+  m.retiredDrawables.clear();
+  if (!IsCompiled()) {
+    Compile();
+  }
+  const uint32_t kPositionGeneration = VertexArray::GetPositionGeneration();
+  if (kPositionGeneration != m.positionGeneration) {
+    m.positionGeneration = kPositionGeneration;
+    m.UpdateBounds();
+  }
+  m.UpdateWorldTransforms();
+  const Matrix& base = aVisitor.GetTransform();
+  const bool kIdentityBase = base.IsIdentity();
+  const bool kFrustumCull = (m.frustumCamera != nullptr);
+  const bool kStreamTextures = kFrustumCull && m.streamer && m.streamer->IsEnabled();
+  State::Table& table = m.table;
+  if (kFrustumCull) {
+    m.UpdateFrustum(base);
+    const size_t kDrawables = m.drawableEntries.size();
+    for (size_t drawable = 0; drawable < kDrawables; drawable++) {
+      if (m.worldBoundsStamps[drawable] != table.worldStamps[table.worldSources[m.drawableEntries[drawable]]]) {
+        m.UpdateWorldBounds(drawable);
+      }
+      m.visible[drawable] = m.IsVisible(drawable) ? 1 : 0;
+    }
+  } else {
+    std::fill(m.visible.begin(), m.visible.end(), 1);
+  }
+
+  // Drawable entries are visited in table order, so drawable indexes the visibility.
+  size_t drawable = 0;
+  m.openGroups.clear();
+  for (const int32_t ix: m.cullEntries) {
+    while (!m.openGroups.empty() && (ix >= table.subtreeEnd[m.openGroups.back()])) {
+      table.groups[m.openGroups.back()]->m.CullEnd(aDrawables);
+      m.openGroups.pop_back();
+    }
+    switch (table.kinds[ix]) {
+      case State::Kind::Group:
+        table.groups[ix]->m.CullBegin(aDrawables);
+        m.openGroups.push_back(ix);
+        break;
+      case State::Kind::PlainGroup:
+        break;
+      case State::Kind::Drawable:
+        if (m.visible[drawable++]) {
+          const Matrix& world = table.worlds[table.worldSources[ix]];
+          aDrawables.AddDrawable(*table.drawables[ix], kIdentityBase ? world : base.PostMultiply(world));
+          if (kStreamTextures) {
+            m.RequestTextureSize(ix);
+          }
+        }
+        break;
+      case State::Kind::Other:
+        aVisitor.PushTransform(table.worlds[table.worldSources[ix]]);
+        table.others[ix]->Cull(aVisitor, aDrawables);
+        aVisitor.PopTransform();
+        break;
+    }
+  }
+  while (!m.openGroups.empty()) {
+    table.groups[m.openGroups.back()]->m.CullEnd(aDrawables);
+    m.openGroups.pop_back();
+  }
+}
+
+CompiledScene::CompiledScene(State& aState, CreationContextPtr& aContext) : m(aState) {}
+CompiledScene::~CompiledScene() {
+  if (m.streamer) {
+    m.streamer->RemoveSizeSource();
+  }
+}
+
+} // namespace vrb
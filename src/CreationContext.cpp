@@ -32,24 +32,27 @@ typedef std::shared_ptr<TextureHandler> TextureHandlerPtr;
 
 class TextureHandler : public vrb::FileHandler {
 public:
-  static TextureHandlerPtr Create(const vrb::TextureGLPtr& aTexture);
+  static TextureHandlerPtr Create(const vrb::TextureGLPtr& aTexture, const bool aAllowCubeMap);
   void BindFileHandle(const std::string& aFileName, const int aFileHandle) override;
   void LoadFailed(const int aFileHandle, const std::string& aReason) override;
   void ProcessRawFileChunk(const int aFileHandle, const char* aBuffer, const size_t aSize) override {};
   void FinishRawFile(const int aFileHandle) override {};
   void ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) override;
-  TextureHandler() {}
+  void ProcessImageLevels(const int aFileHandle, const vrb::DataBufferPtr& aImage, const vrb::ImageLayout& aLayout) override;
+  TextureHandler() : mAllowCubeMap(false) {}
   ~TextureHandler() {}
 protected:
   vrb::TextureGLPtr mTexture;
+  bool mAllowCubeMap;
 private:
   VRB_NO_DEFAULTS(TextureHandler)
 };
 
 TextureHandlerPtr
-TextureHandler::Create(const vrb::TextureGLPtr& aTexture) {
+TextureHandler::Create(const vrb::TextureGLPtr& aTexture, const bool aAllowCubeMap) {
   TextureHandlerPtr result = std::make_shared<TextureHandler>();
   result->mTexture = aTexture;
+  result->mAllowCubeMap = aAllowCubeMap;
   return result;
 }
 
@@ -70,6 +73,30 @@ TextureHandler::ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[
   }
 }
 
+void
+TextureHandler::ProcessImageLevels(const int aFileHandle, const vrb::DataBufferPtr& aImage, const vrb::ImageLayout& aLayout) {
+  if (!mTexture) {
+    return;
+  }
+  // Callers sample the texture as a sampler2D unless they asked for a cube map.
+  if ((aLayout.target != GL_TEXTURE_2D) && !mAllowCubeMap) {
+    VRB_ERROR("Failed to load texture: %s is not a 2D texture", mTexture->GetName().c_str());
+    return;
+  }
+  // The lower levels are only sampled with a mipmapped filter.
+  bool mipmapped = false;
+  for (const vrb::ImageLayout::Level& level: aLayout.levels) {
+    mipmapped = mipmapped || (level.level > 0);
+  }
+  const GLint kFilter = mTexture->GetTextureParameter(GL_TEXTURE_MIN_FILTER);
+  if (mipmapped && (kFilter == GL_NEAREST)) {
+    mTexture->SetTextureParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+  } else if (mipmapped && (kFilter == GL_LINEAR)) {
+    mTexture->SetTextureParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  }
+  mTexture->SetImageLevels(aImage, aLayout);
+}
+
 }
 
 namespace vrb {
@@ -84,6 +111,8 @@ struct CreationContext::State {
   ProgramFactoryPtr programFactory;
   DataCachePtr dataCache;
   TextureCachePtr textureCache;
+  TextureStreamerPtr textureStreamer;
+  TextureUploadQueuePtr textureUploadQueue;
   pthread_t threadSelf;
 
   State() {}
@@ -101,6 +130,8 @@ CreationContext::Create(RenderContextPtr& aContext) {
   result->m.programFactory = aContext->GetProgramFactory();
   result->m.dataCache = aContext->GetDataCache();
   result->m.textureCache = aContext->GetTextureCache();
+  result->m.textureStreamer = aContext->GetTextureStreamer();
+  result->m.textureUploadQueue = aContext->GetTextureUploadQueue();
   return result;
 }
 
@@ -124,6 +155,9 @@ CreationContext::BindToThread() {
 void
 CreationContext::Synchronize() {
   ASSERT_ON_CREATION_THREAD();
+  if (m.fileReader) {
+    m.fileReader->ProcessCompletions();
+  }
   if (m.uninitializedResources.IsDirty() || m.resources.IsDirty() || m.updatables.IsDirty()) {
     m.sync->AdoptLists(m.uninitializedResources, m.resources, m.updatables);
   }
@@ -149,8 +183,18 @@ CreationContext::GetProgramFactory() {
   return m.programFactory;
 }
 
+TextureStreamerPtr
+CreationContext::GetTextureStreamer() {
+  return m.textureStreamer;
+}
+
+TextureUploadQueuePtr
+CreationContext::GetTextureUploadQueue() {
+  return m.textureUploadQueue;
+}
+
 TextureGLPtr
-CreationContext::LoadTexture(const std::string& aTextureName, const bool aUseCache) {
+CreationContext::LoadTexture(const std::string& aTextureName, const bool aUseCache, const bool aAllowCubeMap) {
   TextureGLPtr result;
   if (aUseCache) {
     result = m.textureCache->FindTexture(aTextureName);
@@ -169,8 +213,8 @@ CreationContext::LoadTexture(const std::string& aTextureName, const bool aUseCac
   }
   result = TextureGL::Create(context);
   m.textureCache->AddTexture(aTextureName, result);
-  m.fileReader->ReadImageFile(aTextureName, TextureHandler::Create(result));
   result->SetName(aTextureName);
+  m.fileReader->ReadImageFile(aTextureName, TextureHandler::Create(result, aAllowCubeMap));
 
   return result;
 }
@@ -0,0 +1,304 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/CullWorkerPool.h"
+#include "vrb/private/GroupState.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/ConditionVariable.h"
+#include "vrb/CullVisitor.h"
+#include "vrb/DrawableList.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/Transform.h"
+
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Jobs per thread, so a thread that finishes early can pick up more work.
+const size_t kJobsPerThread = 4;
+
+}
+
+namespace vrb {
+
+struct CullWorkerPool::State {
+  // A node to cull and the index of the transform it is culled with.
+  struct Item {
+    Node* node;
+    size_t transform;
+  };
+  // A range of items culled into one shard.
+  struct Job {
+    size_t begin;
+    size_t end;
+  };
+  CreationContextWeak context;
+  std::vector<pthread_t> threads;
+  ConditionVariable lock;
+  bool quit;
+  // Items, transforms and jobs for the current Cull call, guarded by lock.
+  std::vector<Item> items;
+  std::vector<Item> expanded;
+  std::vector<Matrix> transforms;
+  std::vector<Job> jobs;
+  size_t nextJob;
+  size_t finishedJobs;
+  std::vector<DrawableListPtr> shards;
+  // Drawables each shard held in the last Cull call. The merged nodes are handed back
+  // to the shards once the destination list has been reset.
+  std::vector<uint32_t> shardSizes;
+  std::vector<CullVisitorPtr> visitors;
+
+  State() : quit(false), nextJob(0), finishedJobs(0) {}
+  // Groups without lights or render lambdas may be replaced by their children.
+  static Group* GetExpandableGroup(Node& aNode);
+  void AddChildren(Group& aGroup, const size_t aTransform, std::vector<Item>& aItems);
+  // Replaces the largest groups with their children until there are enough items
+  // to balance aJobCount jobs.
+  void CreateItems(Group& aRoot, const size_t aJobCount);
+  void CreateJobs(const size_t aJobCount);
+  void RunJob(const size_t aIndex);
+  // Runs jobs until none are left to start. Must be called with lock held.
+  void RunJobs();
+};
+
+Group*
+CullWorkerPool::State::GetExpandableGroup(Node& aNode) {
+  if (!aNode.IsKind(Node::KindGroup)) {
+    return nullptr;
+  }
+  Group* group = static_cast<Group*>(&aNode);
+  const Group::State& state = group->m;
+  if (!state.lights.empty() || state.preRenderLambda || state.postRenderLambda) {
+    return nullptr;
+  }
+  return group;
+}
+
+void
+CullWorkerPool::State::AddChildren(Group& aGroup, const size_t aTransform, std::vector<Item>& aItems) {
+  Group::State& state = aGroup.m;
+  for (NodePtr& child: (state.baked ? state.bakedNodes : state.children)) {
+    if (child && state.IsEnabled(*child)) {
+      aItems.push_back({child.get(), aTransform});
+    }
+  }
+}
+
+void
+CullWorkerPool::State::CreateItems(Group& aRoot, const size_t aJobCount) {
+  items.clear();
+  AddChildren(aRoot, 0, items);
+  while (items.size() < aJobCount) {
+    // Child count stands in for subtree size, walking the subtrees would cost as much
+    // as culling them.
+    size_t largest = items.size();
+    size_t largestCount = 0;
+    for (size_t ix = 0; ix < items.size(); ix++) {
+      Group* group = GetExpandableGroup(*items[ix].node);
+      if (!group) {
+        continue;
+      }
+      const size_t kCount = (group->m.baked ? group->m.bakedNodes : group->m.children).size();
+      if (kCount > largestCount) {
+        largest = ix;
+        largestCount = kCount;
+      }
+    }
+    if (largest == items.size()) {
+      break;
+    }
+    Group& group = *static_cast<Group*>(items[largest].node);
+    size_t transform = items[largest].transform;
+    if (group.IsKind(Node::KindTransform)) {
+      transforms.push_back(transforms[transform].PostMultiply(static_cast<Transform&>(group).GetTransform()));
+      transform = transforms.size() - 1;
+    }
+    expanded.assign(items.begin(), items.begin() + largest);
+    AddChildren(group, transform, expanded);
+    expanded.insert(expanded.end(), items.begin() + largest + 1, items.end());
+    items.swap(expanded);
+  }
+}
+
+void
+CullWorkerPool::State::CreateJobs(const size_t aJobCount) {
+  jobs.clear();
+  const size_t kCount = std::min(aJobCount, items.size());
+  for (size_t ix = 0; ix < kCount; ix++) {
+    jobs.push_back({(items.size() * ix) / kCount, (items.size() * (ix + 1)) / kCount});
+  }
+}
+
+void
+CullWorkerPool::State::RunJob(const size_t aIndex) {
+  CullVisitor& visitor = *visitors[aIndex];
+  DrawableList& shard = *shards[aIndex];
+  shard.Reset();
+  const Job& job = jobs[aIndex];
+  size_t transform = items[job.begin].transform;
+  visitor.PushTransform(transforms[transform]);
+  for (size_t ix = job.begin; ix < job.end; ix++) {
+    const Item& item = items[ix];
+    if (item.transform != transform) {
+      transform = item.transform;
+      visitor.PopTransform();
+      visitor.PushTransform(transforms[transform]);
+    }
+    item.node->Cull(visitor, shard);
+  }
+  visitor.PopTransform();
+}
+
+void
+CullWorkerPool::State::RunJobs() {
+  while (nextJob < jobs.size()) {
+    const size_t index = nextJob++;
+    {
+      MutexAutoUnlock unlock(lock);
+      RunJob(index);
+    }
+    finishedJobs++;
+    if (finishedJobs == jobs.size()) {
+      lock.Broadcast();
+    }
+  }
+}
+
+CullWorkerPoolPtr
+CullWorkerPool::Create(CreationContextPtr& aContext, const int32_t aThreadCount) {
+  CullWorkerPoolPtr result = std::make_shared<ConcreteClass<CullWorkerPool, CullWorkerPool::State> >(aContext);
+  int32_t count = aThreadCount;
+  if (count <= 0) {
+    count = (int32_t)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  for (int32_t ix = 0; ix < count; ix++) {
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, &CullWorkerPool::Run, &result->m) != 0) {
+      VRB_ERROR("CullWorkerPool failed to create worker thread");
+      break;
+    }
+    result->m.threads.push_back(thread);
+  }
+  VRB_LOG("CullWorkerPool started %d worker threads", (int)result->m.threads.size());
+  return result;
+}
+
+int32_t
+CullWorkerPool::GetThreadCount() const {
+  return (int32_t)m.threads.size();
+}
+
+void
+CullWorkerPool::Cull(Group& aRoot, CullVisitor& aVisitor, DrawableList& aDrawables) {
+  Group::State& root = aRoot.m;
+  if (m.threads.empty()) {
+    aRoot.Cull(aVisitor, aDrawables);
+    return;
+  }
+
+  // Shards start from the root's world transform, as the children would see it in
+  // Transform::Cull.
+  const bool kTransformRoot = aRoot.IsKind(Node::KindTransform);
+  if (kTransformRoot) {
+    aVisitor.PushTransform(static_cast<Transform&>(aRoot).GetTransform());
+  }
+  MutexAutoLock lock(m.lock);
+  m.transforms.clear();
+  m.transforms.push_back(aVisitor.GetTransform());
+  const size_t kJobCount = (m.threads.size() + 1) * kJobsPerThread;
+  m.CreateItems(aRoot, kJobCount);
+  m.CreateJobs(kJobCount);
+  if (m.jobs.size() < 2) {
+    m.jobs.clear();
+    MutexAutoUnlock unlock(m.lock);
+    if (kTransformRoot) {
+      aVisitor.PopTransform();
+    }
+    aRoot.Cull(aVisitor, aDrawables);
+    return;
+  }
+  if (m.shards.size() < m.jobs.size()) {
+    CreationContextPtr context = m.context.lock();
+    if (!context) {
+      VRB_ERROR("CullWorkerPool unable to create shards without a CreationContext");
+      m.jobs.clear();
+      MutexAutoUnlock unlock(m.lock);
+      if (kTransformRoot) {
+        aVisitor.PopTransform();
+      }
+      aRoot.Cull(aVisitor, aDrawables);
+      return;
+    }
+    while (m.shards.size() < m.jobs.size()) {
+      m.shards.push_back(DrawableList::Create(context));
+      m.shardSizes.push_back(0);
+      m.visitors.push_back(CullVisitor::Create(context));
+    }
+  } else {
+    // Fewer jobs than the last call, for example after children were removed.
+    m.shards.resize(m.jobs.size());
+    m.shardSizes.resize(m.jobs.size());
+    m.visitors.resize(m.jobs.size());
+  }
+  for (size_t ix = 0; ix < m.jobs.size(); ix++) {
+    aDrawables.MoveFreeNodes(*m.shards[ix], m.shardSizes[ix]);
+  }
+
+  root.CullBegin(aDrawables);
+  m.nextJob = 0;
+  m.finishedJobs = 0;
+  m.lock.Broadcast();
+  m.RunJobs();
+  while (m.finishedJobs < m.jobs.size()) {
+    m.lock.Wait();
+  }
+  for (size_t ix = 0; ix < m.jobs.size(); ix++) {
+    m.shardSizes[ix] = m.shards[ix]->GetStats().drawables;
+    aDrawables.TakeDrawables(*m.shards[ix]);
+  }
+  m.jobs.clear();
+  m.items.clear();
+  root.CullEnd(aDrawables);
+  if (kTransformRoot) {
+    aVisitor.PopTransform();
+  }
+}
+
+void*
+CullWorkerPool::Run(void* aData) {
+  State& m = *(State*)aData;
+  MutexAutoLock lock(m.lock);
+  while (!m.quit) {
+    if (m.nextJob < m.jobs.size()) {
+      m.RunJobs();
+    } else {
+      m.lock.Wait();
+    }
+  }
+  return nullptr;
+}
+
+CullWorkerPool::CullWorkerPool(State& aState, CreationContextPtr& aContext) : m(aState) {
+  m.context = aContext;
+}
+
+CullWorkerPool::~CullWorkerPool() {
+  {
+    MutexAutoLock lock(m.lock);
+    m.quit = true;
+    m.lock.Broadcast();
+  }
+  for (pthread_t& thread: m.threads) {
+    pthread_join(thread, nullptr);
+  }
+}
+
+} // namespace vrb
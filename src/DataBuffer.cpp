@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/DataBuffer.h"
+#include "vrb/ConcreteClass.h"
+
+#include "vrb/Logger.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace vrb {
+
+struct DataBuffer::State {
+  std::unique_ptr<uint8_t[]> data;
+  void* mapped;
+  size_t size;
+  std::string path;
+  State() : mapped(nullptr), size(0) {}
+};
+
+DataBufferPtr
+DataBuffer::Create(std::unique_ptr<uint8_t[]>& aData, const size_t aSize) {
+  if (!aData) {
+    return nullptr;
+  }
+  DataBufferPtr result = std::make_shared<ConcreteClass<DataBuffer, DataBuffer::State> >();
+  result->m.data = std::move(aData);
+  result->m.size = aSize;
+  return result;
+}
+
+DataBufferPtr
+DataBuffer::CreateFromFile(const std::string& aPath) {
+  int file = open(aPath.c_str(), O_RDONLY);
+  if (file < 0) {
+    return nullptr;
+  }
+  struct stat info;
+  if ((fstat(file, &info) < 0) || (info.st_size <= 0)) {
+    close(file);
+    return nullptr;
+  }
+  DataBufferPtr result = std::make_shared<ConcreteClass<DataBuffer, DataBuffer::State> >();
+  result->m.size = (size_t)info.st_size;
+  result->m.path = aPath;
+  void* mapped = mmap(nullptr, result->m.size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (mapped != MAP_FAILED) {
+    result->m.mapped = mapped;
+    close(file);
+    return result;
+  }
+
+  VRB_WARN("Unable to map file: %s, reading it instead", aPath.c_str());
+  result->m.data = std::make_unique<uint8_t[]>(result->m.size);
+  size_t place = 0;
+  while (place < result->m.size) {
+    ssize_t dataRead = read(file, &(result->m.data[place]), result->m.size - place);
+    if (dataRead <= 0) {
+      VRB_ERROR("Failed to read file: %s", aPath.c_str());
+      close(file);
+      return nullptr;
+    }
+    place += (size_t)dataRead;
+  }
+  close(file);
+  return result;
+}
+
+const uint8_t*
+DataBuffer::GetData() const {
+  if (m.mapped) {
+    return (const uint8_t*)m.mapped;
+  }
+  return m.data.get();
+}
+
+size_t
+DataBuffer::GetSize() const {
+  return m.size;
+}
+
+bool
+DataBuffer::IsMapped() const {
+  return m.mapped != nullptr;
+}
+
+const std::string&
+DataBuffer::GetFilePath() const {
+  return m.path;
+}
+
+DataBuffer::DataBuffer(State& aState) : m(aState) {}
+DataBuffer::~DataBuffer() {
+  if (m.mapped) {
+    munmap(m.mapped, m.size);
+    m.mapped = nullptr;
+  }
+}
+
+} // namespace vrb
@@ -6,6 +6,7 @@
 #include "vrb/DataCache.h"
 #include "vrb/ConcreteClass.h"
 
+#include "vrb/DataBuffer.h"
 #include "vrb/Logger.h"
 #include "vrb/Mutex.h"
 
@@ -52,27 +53,22 @@ struct DataCache::State {
   uint32_t handleCount;
   std::unordered_map<uint32_t, CachedData> cache;
   State() : handleCount(0) {}
+  uint32_t Write(const uint8_t* aData, const size_t aDataSize);
 };
 
-DataCachePtr
-DataCache::Create() {
-  DataCachePtr result = std::make_shared<ConcreteClass <DataCache, DataCache::State> >();
-  return result;
-}
-
 uint32_t
-DataCache::CacheData(std::unique_ptr<uint8_t[]>& aData, const size_t aDataSize) {
+DataCache::State::Write(const uint8_t* aData, const size_t aDataSize) {
   uint32_t handle = 0;
   std::string root;
   {
-    MutexAutoLock lock(m.cacheLock);
-    root = m.cachePath;
+    MutexAutoLock lock(cacheLock);
+    root = cachePath;
     if (root.empty()) {
       VRB_ERROR("Failed to cache data, root path not set");
       return 0;
     }
-    m.handleCount++;
-    handle = m.handleCount;
+    handleCount++;
+    handle = handleCount;
   }
 
   CachedData info;
@@ -95,16 +91,38 @@ DataCache::CacheData(std::unique_ptr<uint8_t[]>& aData, const size_t aDataSize)
     toWrite -= (size_t)written;
     place = aDataSize - toWrite;
   }
-  // Keep data for deletion
-  std::unique_ptr<uint8_t[]> data = std::move(aData);
   {
-    MutexAutoLock lock(m.cacheLock);
-    m.cache[handle] = info;
+    MutexAutoLock lock(cacheLock);
+    cache[handle] = info;
   }
   VRB_LOG("Cached data: %u size: %u", handle, (uint32_t)aDataSize);
   return handle;
 }
 
+DataCachePtr
+DataCache::Create() {
+  DataCachePtr result = std::make_shared<ConcreteClass <DataCache, DataCache::State> >();
+  return result;
+}
+
+uint32_t
+DataCache::CacheData(std::unique_ptr<uint8_t[]>& aData, const size_t aDataSize) {
+  const uint32_t handle = m.Write(aData.get(), aDataSize);
+  if (handle > 0) {
+    // Keep data for deletion
+    std::unique_ptr<uint8_t[]> data = std::move(aData);
+  }
+  return handle;
+}
+
+uint32_t
+DataCache::CacheData(const DataBufferPtr& aData) {
+  if (!aData) {
+    return 0;
+  }
+  return m.Write(aData->GetData(), aData->GetSize());
+}
+
 size_t
 DataCache::LoadData(const uint32_t aHandle, std::unique_ptr<uint8_t[]>& aData) {
   cacheIterator_t found;
@@ -139,6 +157,27 @@ DataCache::LoadData(const uint32_t aHandle, std::unique_ptr<uint8_t[]>& aData) {
   return info.size;
 }
 
+DataBufferPtr
+DataCache::LoadBuffer(const uint32_t aHandle) {
+  std::string path;
+  {
+    MutexAutoLock lock(m.cacheLock);
+    cacheIterator_t found = m.cache.find(aHandle);
+    if (found == m.cache.end()) {
+      VRB_ERROR("Failed to find cache file from handle: %u", aHandle);
+      return nullptr;
+    }
+    path = found->second.path;
+  }
+  DataBufferPtr result = DataBuffer::CreateFromFile(path);
+  if (!result) {
+    VRB_ERROR("Failed to open cache file: %s for reading", path.c_str());
+    return nullptr;
+  }
+  VRB_LOG("Loaded cached data: %u size: %u", aHandle, (uint32_t)result->GetSize());
+  return result;
+}
+
 void
 DataCache::RemoveData(const uint32_t aHandle) {
   std::string path;
@@ -164,6 +203,12 @@ DataCache::SetCachePath(const std::string& aPath) {
   m.cachePath = aPath;
 }
 
+std::string
+DataCache::GetCachePath() {
+  MutexAutoLock lock(m.cacheLock);
+  return m.cachePath;
+}
+
 DataCache::DataCache(State& aState) : m(aState) {}
 DataCache::~DataCache() {
   // No need to lock since if destructor is called, no references are left
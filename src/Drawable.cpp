@@ -13,6 +13,12 @@ Drawable::CreateDrawablePtr() {
   return shared_from_this();
 }
 
+void
+Drawable::Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform) {
+  Draw(aLeftCamera, aModelTransform);
+  Draw(aRightCamera, aModelTransform);
+}
+
 Drawable::Drawable(State& aState, CreationContextPtr& aContext) : m(aState) {}
 Drawable::~Drawable() {}
 
@@ -16,12 +16,16 @@ namespace vrb {
 void
 DrawableList::State::Reset() {
   depth = 0;
+  lightsResolved = false;
+  stats = Stats();
   DrawNode* current = drawables;
   drawables = nullptr;
   while (current) {
     DrawNode* tmp = current;
     current = current->next;
-    delete tmp;
+    tmp->owner = nullptr;
+    tmp->next = freeNodes;
+    freeNodes = tmp;
   }
   LightSnapshot* currentLight = lights;
   lights = nullptr;
@@ -32,6 +36,32 @@ DrawableList::State::Reset() {
   }
 }
 
+DrawableList::State::~State() {
+  Reset();
+  while (freeNodes) {
+    DrawNode* tmp = freeNodes;
+    freeNodes = freeNodes->next;
+    delete tmp;
+  }
+}
+
+DrawableList::State::DrawNode*
+DrawableList::State::AddNode(const Matrix& aTransform) {
+  DrawNode* node = freeNodes;
+  if (node) {
+    freeNodes = node->next;
+  } else {
+    node = new DrawNode;
+  }
+  node->transform = aTransform;
+  node->lights = currentLights;
+  node->next = drawables;
+  drawables = node;
+  lightsResolved = false;
+  stats.drawables++;
+  return node;
+}
+
 DrawableListPtr
 DrawableList::Create(CreationContextPtr& aContext) {
   return std::make_shared<ConcreteClass<DrawableList, DrawableList::State> >(aContext);
@@ -45,9 +75,7 @@ DrawableList::Reset() {
 void
 DrawableList::PushLight(const Light& aLight) {
   m.depth++;
-  m.idCount++;
-  if (m.idCount == 0) { m.idCount++; }
-  State::LightSnapshot* light = new State::LightSnapshot(m.idCount, m.depth, aLight);
+  State::LightSnapshot* light = new State::LightSnapshot(m.depth, aLight);
   light->next = m.currentLights;
   m.currentLights = light;
   light->masterNext = m.lights;
@@ -69,33 +97,156 @@ DrawableList::PopLights(const int aCount) {
 
 void
 DrawableList::AddDrawable(DrawablePtr&& aDrawable, const Matrix& aTransform) {
-  State::DrawNode* node = new State::DrawNode;
-  node->drawable = aDrawable;
-  node->transform = aTransform;
-  node->lights = m.currentLights;
-  node->next = m.drawables;
-  m.drawables = node;
+  State::DrawNode* node = m.AddNode(aTransform);
+  node->drawable = aDrawable.get();
+  node->owner = std::move(aDrawable);
+}
+
+void
+DrawableList::AddDrawable(Drawable& aDrawable, const Matrix& aTransform) {
+  m.AddNode(aTransform)->drawable = &aDrawable;
+}
+
+void
+DrawableList::TakeDrawables(DrawableList& aSource) {
+  State::LightSnapshot* lastLight = nullptr;
+  for (State::LightSnapshot* light = aSource.m.lights; light; light = light->masterNext) {
+    if (!light->next) {
+      light->next = m.currentLights;
+    }
+    lastLight = light;
+  }
+  if (lastLight) {
+    lastLight->masterNext = m.lights;
+    m.lights = aSource.m.lights;
+  }
+
+  State::DrawNode* lastNode = nullptr;
+  for (State::DrawNode* node = aSource.m.drawables; node; node = node->next) {
+    if (!node->lights) {
+      node->lights = m.currentLights;
+    }
+    lastNode = node;
+  }
+  if (lastNode) {
+    lastNode->next = m.drawables;
+    m.drawables = aSource.m.drawables;
+  }
+
+  m.lightsResolved = false;
+  m.stats.drawables += aSource.m.stats.drawables;
+  aSource.m.drawables = nullptr;
+  aSource.m.lights = nullptr;
+  aSource.m.currentLights = nullptr;
+  aSource.m.depth = 0;
+  aSource.m.lightsResolved = false;
+  aSource.m.stats = Stats();
+}
+
+void
+DrawableList::MoveFreeNodes(DrawableList& aTarget, const uint32_t aCount) {
+  for (uint32_t ix = 0; (ix < aCount) && m.freeNodes; ix++) {
+    State::DrawNode* node = m.freeNodes;
+    m.freeNodes = node->next;
+    node->next = aTarget.m.freeNodes;
+    aTarget.m.freeNodes = node;
+  }
+}
+
+int32_t
+DrawableList::State::ResolveLightSet(LightSnapshot* aSnapshot) {
+  if (!aSnapshot) {
+    return 0;
+  }
+  if (aSnapshot->lightSet >= 0) {
+    return aSnapshot->lightSet;
+  }
+  const int32_t index = (int32_t)lightSets.size();
+  lightSets.emplace_back();
+  LightSet& set = lightSets.back();
+  for (LightSnapshot* snapshot = aSnapshot; snapshot && (set.data.count < VRB_MAX_LIGHTS); snapshot = snapshot->next) {
+    set.Add(snapshot->direction, snapshot->ambient, snapshot->diffuse, snapshot->specular);
+  }
+  // Keep last frame's id when the lights did not change so RenderStates and programs
+  // that already hold these lights do not upload them again.
+  if ((index < (int32_t)previousLightSets.size()) && set.HasSameLights(previousLightSets[index])) {
+    set.id = previousLightSets[index].id;
+  } else {
+    set.id = LightSet::NextId();
+  }
+  aSnapshot->lightSet = index;
+  return index;
+}
+
+void
+DrawableList::State::ResolveLights() {
+  if (lightsResolved) {
+    return;
+  }
+  lightSets.swap(previousLightSets);
+  lightSets.clear();
+  lightSets.emplace_back();
+  lightSets[0].id = previousLightSets.empty() ? LightSet::NextId() : previousLightSets[0].id;
+  for (LightSnapshot* snapshot = lights; snapshot; snapshot = snapshot->masterNext) {
+    snapshot->lightSet = -1;
+  }
+  for (DrawNode* node = drawables; node; node = node->next) {
+    node->lightSet = ResolveLightSet(node->lights);
+  }
+  stats.lightSets = (uint32_t)lightSets.size();
+  lightsResolved = true;
+}
+
+void
+DrawableList::State::UpdateLights(DrawNode& aNode) {
+  RenderStatePtr& state = aNode.drawable->GetRenderState();
+  if (!state) {
+    return;
+  }
+  const LightSet& set = lightSets[aNode.lightSet];
+  if (set.id != state->GetLightId()) {
+    state->SetLightSet(set);
+    stats.lightSetChanges++;
+  }
+}
+
+const DrawableList::Stats&
+DrawableList::GetStats() const {
+  return m.stats;
 }
 
 void
 DrawableList::Draw(const Camera& aCamera) {
+  m.ResolveLights();
+  const uint32_t uploads = RenderState::GetLightUploadCount();
+  const uint32_t uniformUploads = RenderState::GetUniformUploadCount();
+  const uint32_t uniformSkips = RenderState::GetUniformSkipCount();
   State::DrawNode* current = m.drawables;
   while (current) {
-    if (current->drawable->GetRenderState()) {
-      const uint32_t id = current->lights ? current->lights->id : 0;
-      if (id != current->drawable->GetRenderState()->GetLightId()) {
-        current->drawable->GetRenderState()->ResetLights(id);
-        State::LightSnapshot* snapshot = current->lights;
-        while (snapshot) {
-          current->drawable->GetRenderState()->AddLight(snapshot->direction, snapshot->ambient,
-                                                        snapshot->diffuse, snapshot->specular);
-          snapshot = snapshot->next;
-        }
-      }
-    }
+    m.UpdateLights(*current);
     current->drawable->Draw(aCamera, current->transform);
     current = current->next;
   }
+  m.stats.lightUploads += RenderState::GetLightUploadCount() - uploads;
+  m.stats.uniformUploads += RenderState::GetUniformUploadCount() - uniformUploads;
+  m.stats.uniformUploadsSkipped += RenderState::GetUniformSkipCount() - uniformSkips;
+}
+
+void
+DrawableList::Draw(const Camera& aLeftCamera, const Camera& aRightCamera) {
+  m.ResolveLights();
+  const uint32_t uploads = RenderState::GetLightUploadCount();
+  const uint32_t uniformUploads = RenderState::GetUniformUploadCount();
+  const uint32_t uniformSkips = RenderState::GetUniformSkipCount();
+  State::DrawNode* current = m.drawables;
+  while (current) {
+    m.UpdateLights(*current);
+    current->drawable->Draw(aLeftCamera, aRightCamera, current->transform);
+    current = current->next;
+  }
+  m.stats.lightUploads += RenderState::GetLightUploadCount() - uploads;
+  m.stats.uniformUploads += RenderState::GetUniformUploadCount() - uniformUploads;
+  m.stats.uniformUploadsSkipped += RenderState::GetUniformSkipCount() - uniformSkips;
 }
 
 DrawableList::DrawableList(State& aState, CreationContextPtr& aContext) : m(aState) {}
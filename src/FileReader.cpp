@@ -0,0 +1,37 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/FileReader.h"
+#include "vrb/DataBuffer.h"
+
+#include <cstring>
+
+namespace vrb {
+
+void
+FileHandler::ProcessImageLevels(const int aFileHandle, const DataBufferPtr& aImage, const ImageLayout& aLayout) {
+  if (!aImage || aLayout.levels.empty()) {
+    LoadFailed(aFileHandle, "Image does not contain any levels");
+    return;
+  }
+  const ImageLayout::Level& first = aLayout.levels.front();
+  // Written so that it can not wrap around.
+  if ((first.size > aImage->GetSize()) || (first.offset > (aImage->GetSize() - first.size))) {
+    LoadFailed(aFileHandle, "Image level exceeds image data");
+    return;
+  }
+  // ProcessImageFile() takes the pixel format of uncompressed images, sized formats
+  // such as GL_SRGB8_ALPHA8 would be taken for compressed ones.
+  if (!aLayout.compressed && (aLayout.type != GL_UNSIGNED_BYTE)) {
+    LoadFailed(aFileHandle, "Image pixel type is not supported");
+    return;
+  }
+  std::unique_ptr<uint8_t[]> image = std::make_unique<uint8_t[]>(first.size);
+  memcpy(image.get(), aImage->GetData() + first.offset, first.size);
+  ProcessImageFile(aFileHandle, image, (uint64_t)first.size, first.width, first.height,
+                   aLayout.compressed ? aLayout.internalFormat : aLayout.format);
+}
+
+} // namespace vrb
@@ -4,31 +4,81 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "vrb/FileReaderBasic.h"
+#include "vrb/ConditionVariable.h"
+#include "vrb/DataBuffer.h"
+#include "vrb/KTX2.h"
 #include "vrb/Logger.h"
 
 #include "vrb/ConcreteClass.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <cstring>
 #include <fstream>
+#include <pthread.h>
 #include <vector>
 #define GLIML_NO_DDS
 #define GLIML_NO_PVR
 #include "gliml/gliml.h"
 
+namespace {
+
+struct ImageRequest {
+  int handle;
+  std::string fileName;
+  vrb::FileHandlerPtr handler;
+  int32_t priority;
+  uint32_t serial;
+  pthread_t thread;
+};
+
+struct ImageResult {
+  int handle;
+  vrb::FileHandlerPtr handler;
+  pthread_t thread;
+  vrb::DataBufferPtr buffer;
+  vrb::ImageLayout layout;
+  std::string error;
+};
+
+}
+
 namespace vrb {
 
 struct FileReaderBasic::State {
-  int trackingHandleCount;
+  std::atomic<int> trackingHandleCount;
+  std::vector<pthread_t> workers;
+  // Guards everything below.
+  ConditionVariable lock;
+  bool quit;
+  uint32_t serial;
+  std::vector<ImageRequest> pending;
+  std::vector<int> running;
+  std::vector<int> cancelled;
+  std::vector<ImageResult> completed;
+  ImageTranscoderPtr transcoder;
+  ImageTranscoder::Target transcodeTarget;
+
   State()
       : trackingHandleCount(0)
+      , quit(false)
+      , serial(0)
+      , transcodeTarget(ImageTranscoder::Target::RGBA)
   {}
 
   int nextHandle() {
-    trackingHandleCount++;
-    return trackingHandleCount;
+    return ++trackingHandleCount;
   }
 
+  static bool loadImage(const std::string& aFileName, const ImageTranscoderPtr& aTranscoder, const ImageTranscoder::Target aTarget,
+                        DataBufferPtr& aBuffer, ImageLayout& aLayout, std::string& aError);
+  static bool loadKTX2(const ImageTranscoderPtr& aTranscoder, const ImageTranscoder::Target aTarget,
+                       DataBufferPtr& aBuffer, ImageLayout& aLayout, std::string& aError);
+  void deliver(ImageResult& aResult);
+  std::vector<ImageRequest>::iterator findPending(const int aFileHandle);
+  std::vector<ImageRequest>::iterator nextPending();
+
   void readRawFile(const std::string& aFileName, FileHandlerPtr aHandler) {
     const int handle = nextHandle();
     aHandler->BindFileHandle(aFileName, handle);
@@ -54,9 +104,118 @@ private:
   State& operator=(const State&) = delete;
 };
 
+// The file is mapped once and handed over as is, levels are referenced by offset.
+bool
+FileReaderBasic::State::loadImage(const std::string& aFileName, const ImageTranscoderPtr& aTranscoder, const ImageTranscoder::Target aTarget,
+                                  DataBufferPtr& aBuffer, ImageLayout& aLayout, std::string& aError) {
+  aBuffer = DataBuffer::CreateFromFile(aFileName);
+  if (!aBuffer) {
+    aError = "Unable to load file: " + aFileName;
+    return false;
+  }
+
+  if (IsKTX2(aBuffer->GetData(), aBuffer->GetSize())) {
+    if (!loadKTX2(aTranscoder, aTarget, aBuffer, aLayout, aError)) {
+      aError += ": " + aFileName;
+      aBuffer = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  gliml::context loader;
+  loader.enable_etc2(true);
+
+  if (!loader.load_ktx(aBuffer->GetData(), (unsigned int)aBuffer->GetSize())) {
+    VRB_ERROR("Error code: %d", loader.error());
+    aError = "Failed to parse file: " + aFileName;
+    aBuffer = nullptr;
+    return false;
+  }
+
+  const int faces = loader.num_faces();
+  aLayout.target = (faces == 6) ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  aLayout.internalFormat = (GLenum)loader.image_internal_format();
+  aLayout.format = (GLenum)loader.image_format();
+  aLayout.type = (GLenum)loader.image_type();
+  aLayout.compressed = loader.is_compressed();
+  for (int face = 0; face < faces; face++) {
+    const int levels = loader.num_mipmaps(face);
+    for (int level = 0; level < levels; level++) {
+      ImageLayout::Level info;
+      info.target = (faces == 6) ? (GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face) : GL_TEXTURE_2D;
+      info.level = level;
+      info.width = loader.image_width(face, level);
+      info.height = loader.image_height(face, level);
+      info.offset = (size_t)((const uint8_t*)loader.image_data(face, level) - aBuffer->GetData());
+      info.size = (size_t)loader.image_size(face, level);
+      aLayout.levels.push_back(info);
+    }
+  }
+  return true;
+}
+
+bool
+FileReaderBasic::State::loadKTX2(const ImageTranscoderPtr& aTranscoder, const ImageTranscoder::Target aTarget,
+                                 DataBufferPtr& aBuffer, ImageLayout& aLayout, std::string& aError) {
+  KTX2Header header;
+  if (!ReadKTX2Header(aBuffer->GetData(), aBuffer->GetSize(), header, aError)) {
+    return false;
+  }
+  if (aTranscoder && aTranscoder->CanTranscode(header.vkFormat, header.supercompression)) {
+    DataBufferPtr image;
+    if (!aTranscoder->Transcode(aBuffer, aTarget, image, aLayout) || !image) {
+      aError = "Failed to transcode KTX2";
+      return false;
+    }
+    aBuffer = image;
+    return true;
+  }
+  if ((header.vkFormat == 0) || (header.supercompression != 0)) {
+    aError = "KTX2 needs an ImageTranscoder";
+    return false;
+  }
+  return CreateKTX2Layout(header, header.levels, aLayout, aError);
+}
+
+void
+FileReaderBasic::State::deliver(ImageResult& aResult) {
+  if (aResult.buffer) {
+    aResult.handler->ProcessImageLevels(aResult.handle, aResult.buffer, aResult.layout);
+  } else {
+    aResult.handler->LoadFailed(aResult.handle, aResult.error);
+  }
+}
+
+std::vector<ImageRequest>::iterator
+FileReaderBasic::State::findPending(const int aFileHandle) {
+  return std::find_if(pending.begin(), pending.end(), [aFileHandle](const ImageRequest& aRequest) {
+    return aRequest.handle == aFileHandle;
+  });
+}
+
+std::vector<ImageRequest>::iterator
+FileReaderBasic::State::nextPending() {
+  return std::max_element(pending.begin(), pending.end(), [](const ImageRequest& aLeft, const ImageRequest& aRight) {
+    if (aLeft.priority != aRight.priority) {
+      return aLeft.priority < aRight.priority;
+    }
+    return aLeft.serial > aRight.serial;
+  });
+}
+
 FileReaderBasicPtr
-FileReaderBasic::Create() {
-  return std::make_shared<ConcreteClass<FileReaderBasic, FileReaderBasic::State> >();
+FileReaderBasic::Create(const int32_t aWorkerCount) {
+  FileReaderBasicPtr result = std::make_shared<ConcreteClass<FileReaderBasic, FileReaderBasic::State> >();
+  for (int32_t ix = 0; ix < aWorkerCount; ix++) {
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, &FileReaderBasic::Run, &result->m) != 0) {
+      VRB_ERROR("FileReaderBasic failed to create worker thread");
+      break;
+    }
+    result->m.workers.push_back(thread);
+  }
+  return result;
 }
 
 void
@@ -66,43 +225,161 @@ FileReaderBasic::ReadRawFile(const std::string& aFileName, FileHandlerPtr aHandl
 
 void
 FileReaderBasic::ReadImageFile(const std::string& aFileName, FileHandlerPtr aHandler) {
+  ReadImageFile(aFileName, std::move(aHandler), 0);
+}
+
+void
+FileReaderBasic::ReadImageFile(const std::string& aFileName, FileHandlerPtr aHandler, const int32_t aPriority) {
   if (!aHandler) {
     return;
   }
   const int imageTargetHandle = m.nextHandle();
   aHandler->BindFileHandle(aFileName, imageTargetHandle);
 
-  std::ifstream input(aFileName, std::ios::binary);
-  if (!input) {
-    std::string message("Unable to load file: ");
-    aHandler->LoadFailed(imageTargetHandle, message + aFileName);
+  if (m.workers.empty()) {
+    ImageTranscoderPtr transcoder;
+    ImageTranscoder::Target target;
+    {
+      MutexAutoLock lock(m.lock);
+      transcoder = m.transcoder;
+      target = m.transcodeTarget;
+    }
+    ImageResult result;
+    result.handle = imageTargetHandle;
+    result.handler = std::move(aHandler);
+    State::loadImage(aFileName, transcoder, target, result.buffer, result.layout, result.error);
+    m.deliver(result);
     return;
   }
 
-  std::vector<char> buffer((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
-  if (buffer.size() == 0) {
-    std::string message("File is empty: ");
-    aHandler->LoadFailed(imageTargetHandle, message + aFileName);
-    return;
+  MutexAutoLock lock(m.lock);
+  m.pending.push_back({imageTargetHandle, aFileName, std::move(aHandler), aPriority, m.serial++, pthread_self()});
+  m.lock.Signal();
+}
+
+void
+FileReaderBasic::ProcessCompletions() {
+  std::vector<ImageResult> results;
+  {
+    MutexAutoLock lock(m.lock);
+    if (m.completed.empty()) {
+      return;
+    }
+    const pthread_t self = pthread_self();
+    auto other = std::stable_partition(m.completed.begin(), m.completed.end(), [&self](const ImageResult& aResult) {
+      return pthread_equal(aResult.thread, self) != 0;
+    });
+    std::move(m.completed.begin(), other, std::back_inserter(results));
+    m.completed.erase(m.completed.begin(), other);
+  }
+  for (ImageResult& result: results) {
+    m.deliver(result);
   }
+}
 
-  gliml::context loader;
-  loader.enable_etc2(true);
+int32_t
+FileReaderBasic::GetWorkerCount() const {
+  return (int32_t)m.workers.size();
+}
 
-  if (!loader.load_ktx(buffer.data(), buffer.size())) {
-    std::string message("Failed to parse file: ");
-    VRB_ERROR("Error code: %d", loader.error());
-    aHandler->LoadFailed(imageTargetHandle, message + aFileName);
-    return;
+int32_t
+FileReaderBasic::GetPendingCount() const {
+  MutexAutoLock lock(m.lock);
+  return (int32_t)(m.pending.size() + m.running.size() + m.completed.size() - m.cancelled.size());
+}
+
+bool
+FileReaderBasic::SetPriority(const int aFileHandle, const int32_t aPriority) {
+  MutexAutoLock lock(m.lock);
+  auto request = m.findPending(aFileHandle);
+  if (request == m.pending.end()) {
+    return false;
   }
+  request->priority = aPriority;
+  return true;
+}
 
-  const size_t length = loader.image_size(0, 0);
-  std::unique_ptr<uint8_t[]> image = std::make_unique<uint8_t[]>(length);
-  memcpy(image.get(), loader.image_data(0, 0), length);
-  aHandler->ProcessImageFile(imageTargetHandle, image, (uint64_t)length, loader.image_width(0, 0), loader.image_height(0, 0), (GLenum)loader.image_internal_format());
+bool
+FileReaderBasic::Cancel(const int aFileHandle) {
+  MutexAutoLock lock(m.lock);
+  auto request = m.findPending(aFileHandle);
+  if (request != m.pending.end()) {
+    m.pending.erase(request);
+    return true;
+  }
+  if (std::find(m.running.begin(), m.running.end(), aFileHandle) != m.running.end()) {
+    if (std::find(m.cancelled.begin(), m.cancelled.end(), aFileHandle) == m.cancelled.end()) {
+      m.cancelled.push_back(aFileHandle);
+    }
+    return true;
+  }
+  auto result = std::find_if(m.completed.begin(), m.completed.end(), [aFileHandle](const ImageResult& aResult) {
+    return aResult.handle == aFileHandle;
+  });
+  if (result != m.completed.end()) {
+    m.completed.erase(result);
+    return true;
+  }
+  return false;
+}
+
+void
+FileReaderBasic::SetTranscoder(const ImageTranscoderPtr& aTranscoder) {
+  MutexAutoLock lock(m.lock);
+  m.transcoder = aTranscoder;
+}
+
+void
+FileReaderBasic::SetTranscodeTarget(const ImageTranscoder::Target aTarget) {
+  MutexAutoLock lock(m.lock);
+  m.transcodeTarget = aTarget;
+}
+
+void*
+FileReaderBasic::Run(void* aData) {
+  State& m = *(State*)aData;
+  MutexAutoLock lock(m.lock);
+  while (!m.quit) {
+    if (m.pending.empty()) {
+      m.lock.Wait();
+      continue;
+    }
+    auto next = m.nextPending();
+    ImageRequest request = std::move(*next);
+    m.pending.erase(next);
+    m.running.push_back(request.handle);
+    ImageResult result;
+    result.handle = request.handle;
+    result.handler = std::move(request.handler);
+    result.thread = request.thread;
+    ImageTranscoderPtr transcoder = m.transcoder;
+    const ImageTranscoder::Target kTarget = m.transcodeTarget;
+    {
+      MutexAutoUnlock unlock(m.lock);
+      State::loadImage(request.fileName, transcoder, kTarget, result.buffer, result.layout, result.error);
+    }
+    m.running.erase(std::find(m.running.begin(), m.running.end(), request.handle));
+    auto cancelled = std::find(m.cancelled.begin(), m.cancelled.end(), request.handle);
+    if (cancelled != m.cancelled.end()) {
+      m.cancelled.erase(cancelled);
+    } else {
+      m.completed.push_back(std::move(result));
+    }
+  }
+  return nullptr;
 }
 
 FileReaderBasic::FileReaderBasic(State& aState) : m(aState) {}
-FileReaderBasic::~FileReaderBasic() {}
+
+FileReaderBasic::~FileReaderBasic() {
+  {
+    MutexAutoLock lock(m.lock);
+    m.quit = true;
+    m.lock.Broadcast();
+  }
+  for (pthread_t& thread: m.workers) {
+    pthread_join(thread, nullptr);
+  }
+}
 
 } // namespace vrb
@@ -8,6 +8,7 @@
 #include "vrb/GLError.h"
 #include "vrb/GLExtensions.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <unordered_set>
@@ -21,17 +22,29 @@ namespace vrb {
 struct GLExtensions::State {
   std::unordered_set<GLExtensions::Ext> supportedExtensions;
   Functions functions;
+  bool gles;
+  int majorVersion;
 
-  State() {
+  State() : gles(false), majorVersion(0) {
     memset(&functions, 0, sizeof(functions));
   }
 
   void Initialize() {
     supportedExtensions.clear();
 
+    const char* versionStr = (const char *) glGetString(GL_VERSION);
+    if (versionStr) {
+      gles = strstr(versionStr, "OpenGL ES") != nullptr;
+      const char* digits = versionStr;
+      while (*digits && ((*digits < '0') || (*digits > '9'))) { digits++; }
+      majorVersion = atoi(digits);
+    }
+
     const char * glStr = (const char *) glGetString( GL_EXTENSIONS );
 #define ADD_EXT(n, v) if (strstr(glStr, n)) { supportedExtensions.insert(v); }
     ADD_EXT("GL_EXT_multisampled_render_to_texture", Ext::EXT_multisampled_render_to_texture);
+    ADD_EXT("GL_KHR_parallel_shader_compile", Ext::KHR_parallel_shader_compile);
+    ADD_EXT("GL_KHR_texture_compression_astc_ldr", Ext::KHR_texture_compression_astc_ldr);
     ADD_EXT("GL_OVR_multiview", Ext::OVR_multiview);
     ADD_EXT("GL_OVR_multiview2", Ext::OVR_multiview2);
     ADD_EXT("OVR_multiview_multisampled_render_to_texture", Ext::OVR_multiview_multisampled_render_to_texture);
@@ -42,6 +55,7 @@ struct GLExtensions::State {
     GET_PROC(glFramebufferTexture2DMultisampleEXT);
     GET_PROC(glFramebufferTextureMultiviewOVR);
     GET_PROC(glFramebufferTextureMultisampleMultiviewOVR);
+    GET_PROC(glMaxShaderCompilerThreadsKHR);
 #endif
   }
 };
@@ -61,6 +75,11 @@ GLExtensions::IsExtensionSupported(GLExtensions::Ext aExtension) const {
   return m.supportedExtensions.find(aExtension) != m.supportedExtensions.end();
 }
 
+bool
+GLExtensions::IsGLES3Supported() const {
+  return m.gles && (m.majorVersion >= 3);
+}
+
 const GLExtensions::Functions &
 GLExtensions::GetFunctions() const {
   return m.functions;
@@ -16,12 +16,14 @@
 #include "vrb/GLError.h"
 #include "vrb/Logger.h"
 #include "vrb/Matrix.h"
+#include "vrb/PickResult.h"
 #include "vrb/RenderBuffer.h"
 #include "vrb/RenderState.h"
 #include "vrb/Texture.h"
 #include "vrb/VertexArray.h"
 #include "vrb/Vector.h"
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -38,6 +40,118 @@ CopyIndices(std::vector<GLushort> &aTarget, const std::vector<int> &aSource) {
   }
 }
 
+const int32_t kMaxTrianglesPerLeaf = 4;
+
+struct PickTriangle {
+  int32_t vertices[3];
+  int32_t face;
+};
+
+struct BVHNode {
+  vrb::Vector min;
+  vrb::Vector max;
+  // Leaves reference count triangles starting at start. Interior nodes have a count
+  // of zero, their left child follows them and right is the index of the right child.
+  int32_t start;
+  int32_t count;
+  int32_t right;
+};
+
+int32_t
+BuildBVH(std::vector<BVHNode>& aNodes, std::vector<PickTriangle>& aTriangles,
+         const std::vector<vrb::Vector>& aCentroids, std::vector<int32_t>& aOrder,
+         const vrb::VertexArray& aVertices, const int32_t aStart, const int32_t aEnd) {
+  const int32_t index = (int32_t)aNodes.size();
+  aNodes.push_back(BVHNode());
+  vrb::Vector min = vrb::Vector::Max();
+  vrb::Vector max = -vrb::Vector::Max();
+  vrb::Vector centroidMin = vrb::Vector::Max();
+  vrb::Vector centroidMax = -vrb::Vector::Max();
+  for (int32_t ix = aStart; ix < aEnd; ix++) {
+    const PickTriangle& triangle = aTriangles[aOrder[ix]];
+    for (int32_t vertex = 0; vertex < 3; vertex++) {
+      const vrb::Vector& point = aVertices.GetVertex(triangle.vertices[vertex]);
+      min.ContractInPlace(point);
+      max.ExpandInPlace(point);
+    }
+    centroidMin.ContractInPlace(aCentroids[aOrder[ix]]);
+    centroidMax.ExpandInPlace(aCentroids[aOrder[ix]]);
+  }
+  aNodes[index].min = min;
+  aNodes[index].max = max;
+  if ((aEnd - aStart) <= kMaxTrianglesPerLeaf) {
+    aNodes[index].start = aStart;
+    aNodes[index].count = aEnd - aStart;
+    aNodes[index].right = -1;
+    return index;
+  }
+  const vrb::Vector extent = centroidMax - centroidMin;
+  int32_t axis = 0;
+  if (extent.y() > extent.x()) { axis = 1; }
+  if (extent.z() > (axis == 0 ? extent.x() : extent.y())) { axis = 2; }
+  const int32_t middle = aStart + ((aEnd - aStart) / 2);
+  std::nth_element(aOrder.begin() + aStart, aOrder.begin() + middle, aOrder.begin() + aEnd,
+                   [&aCentroids, axis](const int32_t aLeft, const int32_t aRight) {
+    return aCentroids[aLeft].Data()[axis] < aCentroids[aRight].Data()[axis];
+  });
+  aNodes[index].start = aStart;
+  aNodes[index].count = 0;
+  BuildBVH(aNodes, aTriangles, aCentroids, aOrder, aVertices, aStart, middle);
+  const int32_t right = BuildBVH(aNodes, aTriangles, aCentroids, aOrder, aVertices, middle, aEnd);
+  aNodes[index].right = right;
+  return index;
+}
+
+bool
+IntersectBounds(const vrb::Vector& aMin, const vrb::Vector& aMax,
+                const vrb::Vector& aOrigin, const vrb::Vector& aInverse, const float aMaxT) {
+  float tMin = 0.0f;
+  float tMax = aMaxT;
+  const float* origin = aOrigin.Data();
+  const float* inverse = aInverse.Data();
+  const float* min = aMin.Data();
+  const float* max = aMax.Data();
+  for (int32_t axis = 0; axis < 3; axis++) {
+    float t0 = (min[axis] - origin[axis]) * inverse[axis];
+    float t1 = (max[axis] - origin[axis]) * inverse[axis];
+    if (t0 > t1) { std::swap(t0, t1); }
+    tMin = t0 > tMin ? t0 : tMin;
+    tMax = t1 < tMax ? t1 : tMax;
+    if (tMin > tMax) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Moller-Trumbore ray triangle intersection.
+bool
+IntersectTriangle(const vrb::Vector& aOrigin, const vrb::Vector& aDirection,
+                  const vrb::Vector& aV0, const vrb::Vector& aV1, const vrb::Vector& aV2,
+                  float& aT, float& aU, float& aV) {
+  const float kEpsilon = 1.0e-7f;
+  const vrb::Vector edge1 = aV1 - aV0;
+  const vrb::Vector edge2 = aV2 - aV0;
+  const vrb::Vector p = aDirection.Cross(edge2);
+  const float determinant = edge1.Dot(p);
+  if ((determinant > -kEpsilon) && (determinant < kEpsilon)) {
+    return false;
+  }
+  const float inverse = 1.0f / determinant;
+  const vrb::Vector s = aOrigin - aV0;
+  aU = s.Dot(p) * inverse;
+  if ((aU < 0.0f) || (aU > 1.0f)) {
+    return false;
+  }
+  const vrb::Vector q = s.Cross(edge1);
+  aV = aDirection.Dot(q) * inverse;
+  if ((aV < 0.0f) || ((aU + aV) > 1.0f)) {
+    return false;
+  }
+  aT = edge2.Dot(q) * inverse;
+  return aT >= 0.0f;
+}
+
 }
 
 namespace vrb {
@@ -47,11 +161,63 @@ struct Geometry::State : public GeometryDrawable::State, public ResourceGL::Stat
   std::vector<Face> faces;
   GLsizei vertexCount = 0;
   GLsizei triangleCount = 0;
+  // Lazily built by Pick() and rebuilt whenever the faces or vertices change.
+  std::vector<PickTriangle> pickTriangles;
+  std::vector<BVHNode> bvh;
+  // Position version of the vertex array the BVH was built from.
+  uint32_t bvhVersion = 0;
+  // Bounds of the vertices referenced by the faces at boundsVersion, zero until they
+  // are computed or after the faces change.
+  Vector boundsMin;
+  Vector boundsMax;
+  uint32_t boundsVersion = 0;
+
+  void BuildBVH();
 
   State() = default;
   ~State() = default;
 };
 
+void
+Geometry::State::BuildBVH() {
+  pickTriangles.clear();
+  bvh.clear();
+  if (!vertexArray) {
+    return;
+  }
+  bvhVersion = vertexArray->GetPositionVersion();
+  const int32_t vertexCount = vertexArray->GetVertexCount();
+  std::vector<vrb::Vector> centroids;
+  for (int32_t faceIndex = 0; faceIndex < (int32_t)faces.size(); faceIndex++) {
+    const Face& face = faces[faceIndex];
+    for (size_t ix = 1; (ix + 1) < face.vertices.size(); ix++) {
+      PickTriangle triangle = {{face.vertices[0] - 1, face.vertices[ix] - 1, face.vertices[ix + 1] - 1}, faceIndex};
+      if ((triangle.vertices[0] >= vertexCount) || (triangle.vertices[1] >= vertexCount) || (triangle.vertices[2] >= vertexCount)) {
+        continue;
+      }
+      pickTriangles.push_back(triangle);
+      centroids.push_back((vertexArray->GetVertex(triangle.vertices[0]) +
+                           vertexArray->GetVertex(triangle.vertices[1]) +
+                           vertexArray->GetVertex(triangle.vertices[2])) / 3.0f);
+    }
+  }
+  if (pickTriangles.empty()) {
+    return;
+  }
+  std::vector<int32_t> order(pickTriangles.size());
+  for (int32_t ix = 0; ix < (int32_t)order.size(); ix++) {
+    order[ix] = ix;
+  }
+  bvh.reserve(pickTriangles.size() / 2);
+  ::BuildBVH(bvh, pickTriangles, centroids, order, *vertexArray, 0, (int32_t)order.size());
+  std::vector<PickTriangle> sorted;
+  sorted.reserve(pickTriangles.size());
+  for (int32_t index: order) {
+    sorted.push_back(pickTriangles[index]);
+  }
+  pickTriangles.swap(sorted);
+}
+
 GeometryPtr
 Geometry::Create(CreationContextPtr& aContext) {
   return std::make_shared<ConcreteClass<Geometry, Geometry::State> >(aContext);
@@ -65,7 +231,10 @@ Geometry::GetVertexArray() const {
 
 void
 Geometry::SetVertexArray(const VertexArrayPtr& aVertexArray) {
+  GraphChanged();
   m.vertexArray = aVertexArray;
+  m.boundsVersion = 0;
+  m.bvh.clear();
 }
 
 void
@@ -179,6 +348,8 @@ Geometry::AddFace(
     const std::vector<int>& aNormals) {
 
   Face face;
+  m.bvh.clear();
+  m.boundsVersion = 0;
   m.vertexCount += aVertices.size();
   m.triangleCount += aVertices.size() - 2;
   CopyIndices(face.vertices, aVertices);
@@ -230,11 +401,107 @@ Geometry::GetFace(int32_t aIndex) const {
   return m.faces[aIndex];
 }
 
+bool
+Geometry::GetBounds(Vector& aMin, Vector& aMax) const {
+  if (!m.vertexArray || (m.vertexArray->GetVertexCount() == 0)) {
+    return false;
+  }
+  const uint32_t kVersion = m.vertexArray->GetPositionVersion();
+  if (m.boundsVersion != kVersion) {
+    // A vertex array may be shared by several geometries, as OBJ groups are, so only
+    // the vertices of this geometry's faces count.
+    const GLuint kVertexCount = (GLuint)m.vertexArray->GetVertexCount();
+    Vector min = Vector::Max();
+    Vector max = -Vector::Max();
+    for (const Face& face: m.faces) {
+      for (const GLuint index: face.vertices) {
+        if ((index == 0) || (index > kVertexCount)) {
+          continue;
+        }
+        const Vector& vertex = m.vertexArray->GetVertex(index - 1);
+        min.Set(std::min(min.x(), vertex.x()), std::min(min.y(), vertex.y()), std::min(min.z(), vertex.z()));
+        max.Set(std::max(max.x(), vertex.x()), std::max(max.y(), vertex.y()), std::max(max.z(), vertex.z()));
+      }
+    }
+    m.boundsMin = min;
+    m.boundsMax = max;
+    m.boundsVersion = kVersion;
+  }
+  if (m.boundsMin.x() > m.boundsMax.x()) {
+    return false;
+  }
+  aMin = m.boundsMin;
+  aMax = m.boundsMax;
+  return true;
+}
+
+uint32_t
+Geometry::GetBoundsVersion() const {
+  return m.vertexArray ? m.vertexArray->GetPositionVersion() : 0;
+}
+
+bool
+Geometry::Pick(const Vector& aOrigin, const Vector& aDirection, PickResult& aResult) const {
+  const float kMax = std::numeric_limits<float>::max();
+  const Vector inverse(aDirection.x() != 0.0f ? 1.0f / aDirection.x() : kMax,
+                       aDirection.y() != 0.0f ? 1.0f / aDirection.y() : kMax,
+                       aDirection.z() != 0.0f ? 1.0f / aDirection.z() : kMax);
+  // Test the cached bounds first so the BVH is only built once a ray gets close.
+  Vector min, max;
+  if (!GetBounds(min, max) || !IntersectBounds(min, max, aOrigin, inverse, aResult.distance)) {
+    return false;
+  }
+  if (m.bvh.empty() || (m.bvhVersion != m.vertexArray->GetPositionVersion())) {
+    m.BuildBVH();
+    if (m.bvh.empty()) {
+      return false;
+    }
+  }
+  bool hit = false;
+  int32_t stack[64];
+  int32_t depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0) {
+    const BVHNode& node = m.bvh[stack[--depth]];
+    if (!IntersectBounds(node.min, node.max, aOrigin, inverse, aResult.distance)) {
+      continue;
+    }
+    if (node.count == 0) {
+      if (depth > 62) {
+        VRB_ERROR("Geometry::Pick BVH is too deep");
+        break;
+      }
+      stack[depth++] = node.right;
+      stack[depth++] = (int32_t)(&node - &m.bvh[0]) + 1;
+      continue;
+    }
+    for (int32_t ix = node.start; ix < (node.start + node.count); ix++) {
+      const PickTriangle& triangle = m.pickTriangles[ix];
+      float t, u, v;
+      if (IntersectTriangle(aOrigin, aDirection,
+                            m.vertexArray->GetVertex(triangle.vertices[0]),
+                            m.vertexArray->GetVertex(triangle.vertices[1]),
+                            m.vertexArray->GetVertex(triangle.vertices[2]), t, u, v) && (t < aResult.distance)) {
+        hit = true;
+        aResult.distance = t;
+        aResult.face = triangle.face;
+        aResult.vertices[0] = triangle.vertices[0];
+        aResult.vertices[1] = triangle.vertices[1];
+        aResult.vertices[2] = triangle.vertices[2];
+        aResult.barycentric.Set(1.0f - u - v, u, v);
+        aResult.point = aOrigin + (aDirection * t);
+      }
+    }
+  }
+  return hit;
+}
+
 Geometry::Geometry(State& aState, CreationContextPtr& aContext) :
     GeometryDrawable(aState, aContext),
     ResourceGL(aState, aContext),
     m(aState)
 {
+  m.kind |= KindGeometry;
   m.renderBuffer = RenderBuffer::Create(aContext);
 }
 
@@ -49,47 +49,22 @@ GeometryDrawable::SetRenderState(const RenderStatePtr& aRenderState) {
 
 void
 GeometryDrawable::Draw(const Camera& aCamera, const Matrix& aModelTransform) {
+  if (m.hasUVTransform) {
+    m.renderState->SetUVTransform(m.uvTransform);
+  }
   if (m.renderState->Enable(aCamera.GetPerspective(), aCamera.GetView(), aModelTransform)) {
-    const bool kUseTexture = m.UseTexture();
-    const bool kUseColor = m.UseColor();
-    const GLsizei kSize = m.renderBuffer->VertexSize();
-    m.renderBuffer->Bind();
-
-    VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributePosition(), m.renderBuffer->PositionLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->PositionOffset()));
-    VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeNormal(), m.renderBuffer->NormalLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->NormalOffset()));
-    if (kUseTexture) {
-      VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeUV(), m.renderBuffer->UVLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->UVOffset()));
-    }
-    if (kUseColor) {
-      VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeColor(), m.renderBuffer->ColorLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->ColorOffset()));
-    }
-
-    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributePosition()));
-    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeNormal()));
-    if (kUseTexture) {
-      VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeUV()));
-    }
-    if (kUseColor) {
-      VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeColor()));
-    }
-    const int32_t maxLength = m.renderBuffer->IndexCount();
-    if (m.rangeLength == 0) {
-      VRB_GL_CHECK(glDrawElements(GL_TRIANGLES, maxLength, GL_UNSIGNED_SHORT, 0));
-    } else if ((m.rangeStart + m.rangeLength) <= maxLength) {
-      VRB_GL_CHECK(glDrawElements(GL_TRIANGLES, m.rangeLength, GL_UNSIGNED_SHORT, (void*)(m.rangeStart * sizeof(GLushort))));
-    } else {
-      VRB_WARN("Invalid geometry range (%u-%u). Max geometry length %d", m.rangeStart, m.rangeLength + m.rangeLength, maxLength);
-    }
-    VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributePosition()));
-    VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeNormal()));
-    if (kUseTexture) {
-      VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeUV()));
-    }
-    if (kUseColor) {
-      VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeColor()));
-    }
-    m.renderBuffer->Unbind();
-    m.renderState->Disable();
+    DrawRenderBuffer();
+  }
+}
+
+void
+GeometryDrawable::Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform) {
+  if (m.hasUVTransform) {
+    m.renderState->SetUVTransform(m.uvTransform);
+  }
+  if (m.renderState->Enable(aLeftCamera.GetPerspective(), aLeftCamera.GetView(),
+                            aRightCamera.GetPerspective(), aRightCamera.GetView(), aModelTransform)) {
+    DrawRenderBuffer();
   }
 }
 
@@ -110,11 +85,78 @@ GeometryDrawable::SetRenderRange(uint32_t aStartIndex, uint32_t aLength) {
   m.rangeLength = aLength;
 }
 
+void
+GeometryDrawable::GetRenderRange(uint32_t& aStartIndex, uint32_t& aLength) const {
+  aStartIndex = m.rangeStart;
+  aLength = m.rangeLength;
+}
+
+void
+GeometryDrawable::SetUVTransform(const Matrix& aMatrix) {
+  m.uvTransform = aMatrix;
+  m.hasUVTransform = true;
+}
+
+bool
+GeometryDrawable::GetUVTransform(Matrix& aMatrix) const {
+  aMatrix = m.uvTransform;
+  return m.hasUVTransform;
+}
+
+void
+GeometryDrawable::DrawRenderBuffer() {
+  if ((m.renderBuffer->GetVertexObject() == 0) || (m.renderBuffer->GetIndexObject() == 0)) {
+    // Buffers are not created until the owning Geometry is initialized.
+    return;
+  }
+  const bool kUseTexture = m.UseTexture();
+  const bool kUseColor = m.UseColor();
+  const GLsizei kSize = m.renderBuffer->VertexSize();
+  m.renderBuffer->Bind();
+
+  VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributePosition(), m.renderBuffer->PositionLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->PositionOffset()));
+  VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeNormal(), m.renderBuffer->NormalLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->NormalOffset()));
+  if (kUseTexture) {
+    VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeUV(), m.renderBuffer->UVLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->UVOffset()));
+  }
+  if (kUseColor) {
+    VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.renderState->AttributeColor(), m.renderBuffer->ColorLength(), GL_FLOAT, GL_FALSE, kSize, (const GLvoid*)m.renderBuffer->ColorOffset()));
+  }
+
+  VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributePosition()));
+  VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeNormal()));
+  if (kUseTexture) {
+    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeUV()));
+  }
+  if (kUseColor) {
+    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.renderState->AttributeColor()));
+  }
+  const int32_t maxLength = m.renderBuffer->IndexCount();
+  if (m.rangeLength == 0) {
+    VRB_GL_CHECK(glDrawElements(GL_TRIANGLES, maxLength, GL_UNSIGNED_SHORT, 0));
+  } else if ((m.rangeStart + m.rangeLength) <= maxLength) {
+    VRB_GL_CHECK(glDrawElements(GL_TRIANGLES, m.rangeLength, GL_UNSIGNED_SHORT, (void*)(m.rangeStart * sizeof(GLushort))));
+  } else {
+    VRB_WARN("Invalid geometry range (%u-%u). Max geometry length %d", m.rangeStart, m.rangeLength + m.rangeLength, maxLength);
+  }
+  VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributePosition()));
+  VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeNormal()));
+  if (kUseTexture) {
+    VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeUV()));
+  }
+  if (kUseColor) {
+    VRB_GL_CHECK(glDisableVertexAttribArray((GLuint)m.renderState->AttributeColor()));
+  }
+  m.renderBuffer->Unbind();
+  m.renderState->Disable();
+}
+
 GeometryDrawable::GeometryDrawable(State& aState, CreationContextPtr& aContext) :
     Node(aState, aContext),
     Drawable(aState, aContext),
     m(aState)
 {
+  m.kind |= KindDrawable;
   m.renderBuffer = RenderBuffer::Create(aContext);
 }
 
@@ -9,13 +9,109 @@
 
 #include "vrb/ConcreteClass.h"
 #include "vrb/DrawableList.h"
+#include "vrb/Geometry.h"
 #include "vrb/Light.h"
 #include "vrb/Logger.h"
 #include "vrb/Matrix.h"
+#include "vrb/PickResult.h"
+#include "vrb/RenderState.h"
+#include "vrb/Transform.h"
+#include "vrb/Vector.h"
+#include "vrb/VertexArray.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 
+namespace {
+
+struct BakeSource {
+  vrb::Geometry* geometry;
+  vrb::Matrix transform;
+};
+
+struct BakeBatch {
+  vrb::RenderState* renderState;
+  int uvLength;
+  bool hasColor;
+  // Sources with their own UV transform are baked with it applied to their UVs.
+  bool hasUVTransform;
+  vrb::GeometryPtr geometry;
+  vrb::VertexArrayPtr vertexArray;
+  int32_t drawnVertexCount;
+};
+
+// Number of indices Geometry writes for its faces, see Geometry::UpdateBuffers.
+int32_t
+DrawnVertexCount(const vrb::Geometry& aGeometry) {
+  int32_t result = 0;
+  for (int32_t ix = 0; ix < aGeometry.GetFaceCount(); ix++) {
+    const size_t size = aGeometry.GetFace(ix).vertices.size();
+    if (size == 0) {
+      break;
+    }
+    if (size >= 3) {
+      result += (size - 2) * 3;
+    }
+  }
+  return result;
+}
+
+float
+Determinant(const vrb::Matrix& aMatrix) {
+  return aMatrix.At(0, 0) * (aMatrix.At(1, 1) * aMatrix.At(2, 2) - aMatrix.At(2, 1) * aMatrix.At(1, 2)) -
+         aMatrix.At(1, 0) * (aMatrix.At(0, 1) * aMatrix.At(2, 2) - aMatrix.At(2, 1) * aMatrix.At(0, 2)) +
+         aMatrix.At(2, 0) * (aMatrix.At(0, 1) * aMatrix.At(1, 2) - aMatrix.At(1, 1) * aMatrix.At(0, 2));
+}
+
+// Slab test of a ray against a box, limited to ray parameters below aMaxT.
+bool
+IntersectBounds(const vrb::Vector& aMin, const vrb::Vector& aMax,
+                const vrb::Vector& aOrigin, const vrb::Vector& aDirection, const float aMaxT) {
+  float tMin = 0.0f;
+  float tMax = aMaxT;
+  for (int32_t axis = 0; axis < 3; axis++) {
+    const float origin = aOrigin.Data()[axis];
+    const float direction = aDirection.Data()[axis];
+    if (direction == 0.0f) {
+      if ((origin < aMin.Data()[axis]) || (origin > aMax.Data()[axis])) {
+        return false;
+      }
+      continue;
+    }
+    float t0 = (aMin.Data()[axis] - origin) / direction;
+    float t1 = (aMax.Data()[axis] - origin) / direction;
+    if (t0 > t1) { std::swap(t0, t1); }
+    tMin = t0 > tMin ? t0 : tMin;
+    tMax = t1 < tMax ? t1 : tMax;
+    if (tMin > tMax) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Broad phase of Group::Pick, true when a ray may hit something below aGroup closer
+// than the current result of that ray.
+bool
+RaysHitGroup(const vrb::Group& aGroup, const vrb::Matrix& aInverse, const std::vector<vrb::PickRay>& aRays,
+             const std::vector<vrb::PickResult>& aResults) {
+  vrb::Vector min, max;
+  if (!aGroup.GetBounds(min, max)) {
+    return false;
+  }
+  for (size_t ix = 0; ix < aRays.size(); ix++) {
+    if (IntersectBounds(min, max, aInverse.MultiplyPosition(aRays[ix].origin),
+                        aInverse.MultiplyDirection(aRays[ix].direction), aResults[ix].distance)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
 namespace vrb {
 
 class LambdaDrawable : public Drawable {
@@ -24,6 +120,7 @@ public:
   RenderStatePtr& GetRenderState() override;
   void SetRenderState(const RenderStatePtr& aRenderState) override {}
   void Draw(const Camera& aCamera, const Matrix& aModelTransform) override;
+  void Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform) override;
 protected:
   struct State;
   LambdaDrawable(State& aState, CreationContextPtr& aContext);
@@ -58,6 +155,11 @@ LambdaDrawable::Draw(const Camera& aCamera, const Matrix& aModelTransform) {
   m.lambda();
 }
 
+void
+LambdaDrawable::Draw(const Camera& aLeftCamera, const Camera& aRightCamera, const Matrix& aModelTransform) {
+  m.lambda();
+}
+
 LambdaDrawablePtr
 Group::State::createLambdaDrawable(CreationContextPtr& aContext, const RenderLambda& aLambda) {
   if (aLambda) {
@@ -68,22 +170,53 @@ Group::State::createLambdaDrawable(CreationContextPtr& aContext, const RenderLam
 
 bool
 Group::State::Contains(const Node& aNode) {
-  for (NodePtr& node: children) {
-    if (node.get() == &aNode) {
-      return true;
-    }
-  }
-  return false;
+  return childIndex.count(&aNode) > 0;
 }
 
 bool
 Group::State::Contains(const Light& aLight) {
-  for (LightPtr& light: lights) {
-    if (light.get() == &aLight) {
-      return true;
-    }
+  return lightSet.count(&aLight) > 0;
+}
+
+void
+Group::State::AppendChild(NodePtr&& aNode) {
+  childIndex[aNode.get()] = children.size();
+  children.push_back(std::move(aNode));
+}
+
+bool
+Group::State::EraseChild(const Node& aNode) {
+  auto it = childIndex.find(&aNode);
+  if (it == childIndex.end()) {
+    return false;
+  }
+  children[it->second] = nullptr;
+  childIndex.erase(it);
+  removedCount++;
+  if (children.size() == removedCount) {
+    children.clear();
+    removedCount = 0;
+  } else if (removedCount * 2 >= children.size()) {
+    Compact();
+  }
+  return true;
+}
+
+void
+Group::State::Compact() {
+  if (removedCount == 0) {
+    return;
+  }
+  children.erase(std::remove(children.begin(), children.end(), nullptr), children.end());
+  removedCount = 0;
+  Reindex(0);
+}
+
+void
+Group::State::Reindex(const size_t aStart) {
+  for (size_t ix = aStart; ix < children.size(); ix++) {
+    childIndex[children[ix].get()] = ix;
   }
-  return false;
 }
 
 GroupPtr
@@ -94,34 +227,50 @@ Group::Create(CreationContextPtr& aContext) {
 }
 
 void
-Group::Cull(CullVisitor& aVisitor, DrawableList& aDrawables) {
-  for (LightPtr& light: m.lights) {
+Group::State::CullBegin(DrawableList& aDrawables) {
+  for (LightPtr& light: lights) {
     aDrawables.PushLight(*light);
   }
   // Lambdas are added post first and pre last because the DrawablesList is FILO.
-  if (m.postRenderLambda) {
-    aDrawables.AddDrawable(m.postRenderLambda, Matrix());
+  if (postRenderLambda) {
+    aDrawables.AddDrawable(postRenderLambda, Matrix());
+  }
+}
+
+void
+Group::State::CullEnd(DrawableList& aDrawables) {
+  if (preRenderLambda) {
+    aDrawables.AddDrawable(preRenderLambda, Matrix());
   }
-  for (NodePtr& node: m.children) {
-    if (m.IsEnabled(*node)) {
+  aDrawables.PopLights(lights.size());
+}
+
+void
+Group::Cull(CullVisitor& aVisitor, DrawableList& aDrawables) {
+  m.CullBegin(aDrawables);
+  for (NodePtr& node: (m.baked ? m.bakedNodes : m.children)) {
+    if (node && m.IsEnabled(*node)) {
       node->Cull(aVisitor, aDrawables);
     }
   }
-  if (m.preRenderLambda) {
-    aDrawables.AddDrawable(m.preRenderLambda, Matrix());
-  }
-  aDrawables.PopLights(m.lights.size());
+  m.CullEnd(aDrawables);
 }
 
 void
 Group::AddLight(LightPtr aLight) {
   if (!m.Contains(*aLight)) {
+    GraphChanged();
+    m.lightSet.insert(aLight.get());
     m.lights.push_back(std::move(aLight));
   }
 }
 
 void
 Group::RemoveLight(const Light& aLight) {
+  if (m.lightSet.erase(&aLight) == 0) {
+    return;
+  }
+  GraphChanged();
   for (auto it = m.lights.begin(); it != m.lights.end(); it++) {
     if (it->get() == &aLight) {
       m.lights.erase(it);
@@ -134,18 +283,14 @@ void
 Group::AddNode(NodePtr aNode) {
   if (!m.Contains(*aNode)) {
     AddToParents(m.self, *aNode);
-    m.children.push_back(std::move(aNode));
+    m.AppendChild(std::move(aNode));
   }
 }
 
 void
 Group::RemoveNode(Node& aNode) {
-  for (auto childIt = m.children.begin(); childIt != m.children.end(); childIt++) {
-    if (childIt->get() == &aNode) {
-      m.children.erase(childIt);
-      RemoveFromParents(*this, aNode);
-      return;
-    }
+  if (m.EraseChild(aNode)) {
+    RemoveFromParents(*this, aNode);
   }
 }
 
@@ -153,58 +298,394 @@ void
 Group::InsertNode(NodePtr aNode, uint32_t aIndex) {
   if (!m.Contains(*aNode)) {
     AddToParents(m.self, *aNode);
+    m.Compact();
     m.children.insert(m.children.begin() + aIndex, std::move(aNode));
+    m.Reindex(aIndex);
   }
 }
 
 const NodePtr&
 Group::GetNode(uint32_t aIndex) const {
+  m.Compact();
   return m.children.at(aIndex);
 }
 
 int32_t
 Group::GetNodeCount() const {
-  return m.children.size();
+  return m.children.size() - m.removedCount;
 }
 
 void
 Group::SortNodes(const std::function<bool(const vrb::NodePtr&, const vrb::NodePtr&)>& aFunction) {
+  GraphChanged();
+  m.Compact();
   std::sort(m.children.begin(), m.children.end(), aFunction);
+  m.Reindex(0);
 }
 
 void
 Group::TakeChildren(GroupPtr& aSource) {
   for (NodePtr& child: aSource->m.children) {
-    m.children.push_back(child);
+    if (!child) {
+      continue;
+    }
+    RemoveFromParents(*aSource, *child);
+    if (!m.Contains(*child)) {
+      AddToParents(m.self, *child);
+      m.AppendChild(std::move(child));
+    }
   }
   aSource->m.Clear();
 }
 
 void
 Group::SetPreRenderLambda(CreationContextPtr& aContext, const RenderLambda& aLambda) {
+  GraphChanged();
   m.preRenderLambda = m.createLambdaDrawable(aContext, aLambda);
 }
 
 void
 Group::SetPostRenderLambda(CreationContextPtr& aContext, const RenderLambda& aLambda) {
+  GraphChanged();
   m.postRenderLambda = m.createLambdaDrawable(aContext, aLambda);
 }
 
+bool
+Group::Bake(CreationContextPtr& aContext) {
+  Unbake();
+  std::vector<BakeSource> sources;
+  std::vector<std::pair<Group*, Matrix>> stack;
+  stack.emplace_back(this, Matrix::Identity());
+  while (!stack.empty()) {
+    Group* group = stack.back().first;
+    const Matrix transform = stack.back().second;
+    stack.pop_back();
+    if ((group != this) && (group->m.lights.size() || group->m.preRenderLambda || group->m.postRenderLambda)) {
+      VRB_WARN("Unable to bake Group: %s, nested Group: %s has lights or render lambdas", m.name.c_str(), group->m.name.c_str());
+      return false;
+    }
+    for (NodePtr& child: group->m.children) {
+      if (!child || !group->m.IsEnabled(*child)) {
+        continue;
+      }
+      if (child->IsKind(KindGeometry)) {
+        sources.push_back({static_cast<Geometry*>(child.get()), transform});
+      } else if (child->IsKind(KindTransform)) {
+        Transform* childTransform = static_cast<Transform*>(child.get());
+        stack.emplace_back(childTransform, transform.PostMultiply(childTransform->GetTransform()));
+      } else if (child->IsKind(KindGroup)) {
+        stack.emplace_back(static_cast<Group*>(child.get()), transform);
+      } else {
+        VRB_WARN("Unable to bake Group: %s, unsupported Node: %s", m.name.c_str(), child->GetName().c_str());
+        return false;
+      }
+    }
+  }
+
+  std::vector<BakeBatch> batches;
+  for (BakeSource& source: sources) {
+    Geometry& geometry = *source.geometry;
+    VertexArrayPtr vertexArray = geometry.GetVertexArray();
+    RenderStatePtr renderState = geometry.GetRenderState();
+    if (!vertexArray || !renderState) {
+      VRB_WARN("Skipping Geometry: %s while baking, missing VertexArray or RenderState", geometry.GetName().c_str());
+      continue;
+    }
+    const int uvLength = vertexArray->GetUVCount() > 0 ? vertexArray->GetUVLength() : 0;
+    const bool hasColor = vertexArray->GetColorCount() > 0;
+    // Only the indices in the render range are drawn, so only their triangles are baked.
+    uint32_t rangeStart = 0;
+    uint32_t rangeLength = 0;
+    geometry.GetRenderRange(rangeStart, rangeLength);
+    const uint32_t kIndexCount = (uint32_t)DrawnVertexCount(geometry);
+    if (rangeLength == 0) {
+      rangeStart = 0;
+      rangeLength = kIndexCount;
+    } else if ((rangeStart > kIndexCount) || (rangeLength > (kIndexCount - rangeStart))) {
+      VRB_WARN("Skipping Geometry: %s while baking, invalid render range", geometry.GetName().c_str());
+      continue;
+    }
+    const uint32_t kRangeEnd = rangeStart + rangeLength;
+    const int32_t drawnVertexCount = (int32_t)rangeLength;
+    Matrix uvTransform = Matrix::Identity();
+    const bool kHasUVTransform = geometry.GetUVTransform(uvTransform);
+    // Batches are limited by the GLushort indices used by Geometry.
+    BakeBatch* batch = nullptr;
+    for (BakeBatch& candidate: batches) {
+      if ((candidate.renderState == renderState.get()) && (candidate.uvLength == uvLength) &&
+          (candidate.hasColor == hasColor) && (candidate.hasUVTransform == kHasUVTransform) &&
+          ((candidate.drawnVertexCount + drawnVertexCount) < std::numeric_limits<GLushort>::max())) {
+        batch = &candidate;
+      }
+    }
+    if (!batch) {
+      batches.push_back({renderState.get(), uvLength, hasColor, kHasUVTransform, Geometry::Create(aContext), VertexArray::Create(aContext), 0});
+      batch = &batches.back();
+      if (kHasUVTransform) {
+        // Keeps the RenderState's UV transform off the already transformed UVs.
+        batch->geometry->SetUVTransform(Matrix::Identity());
+      }
+      if (uvLength > 0) {
+        batch->vertexArray->SetUVLength(uvLength);
+      }
+      batch->geometry->SetName(m.name + "_baked");
+      batch->geometry->SetVertexArray(batch->vertexArray);
+      batch->geometry->SetRenderState(renderState);
+    }
+    batch->drawnVertexCount += drawnVertexCount;
+
+    const Matrix normalTransform = source.transform.AfineInverse().Transpose();
+    // A mirroring transform turns front faces into back faces unless the winding is reversed.
+    const bool kMirrored = Determinant(source.transform) < 0.0f;
+    std::vector<int> vertexMap(vertexArray->GetVertexCount(), 0);
+    std::vector<int> normalMap(vertexArray->GetNormalCount(), 0);
+    std::vector<int> uvMap(vertexArray->GetUVCount(), 0);
+    std::vector<int> vertices, uvs, normals;
+    // Corners of the faces to add, as indices into the source face.
+    std::vector<size_t> corners;
+    uint32_t faceEnd = 0;
+    for (int32_t faceIndex = 0; faceIndex < geometry.GetFaceCount(); faceIndex++) {
+      const Geometry::Face& face = geometry.GetFace(faceIndex);
+      if (face.vertices.empty()) {
+        break;
+      }
+      if (face.vertices.size() < 3) {
+        continue;
+      }
+      // The fan of triangles of the face covers the indices [faceStart, faceEnd).
+      const uint32_t kFaceStart = faceEnd;
+      faceEnd += (uint32_t)(face.vertices.size() - 2) * 3;
+      if ((faceEnd <= rangeStart) || (kFaceStart >= kRangeEnd) ||
+          (face.normals.size() != face.vertices.size()) || (uvLength && (face.uvs.size() != face.vertices.size()))) {
+        continue;
+      }
+      corners.clear();
+      size_t cornersPerFace = face.vertices.size();
+      if ((kFaceStart >= rangeStart) && (faceEnd <= kRangeEnd)) {
+        for (size_t ix = 0; ix < face.vertices.size(); ix++) {
+          corners.push_back(ix);
+        }
+      } else {
+        // The range cuts the face, add the triangles of the fan inside it on their own.
+        cornersPerFace = 3;
+        for (size_t ix = 1; (ix + 1) < face.vertices.size(); ix++) {
+          const uint32_t kTriangleStart = kFaceStart + (uint32_t)(ix - 1) * 3;
+          if ((kTriangleStart >= rangeStart) && ((kTriangleStart + 3) <= kRangeEnd)) {
+            corners.insert(corners.end(), {0, ix, ix + 1});
+          }
+        }
+      }
+      for (size_t first = 0; first < corners.size(); first += cornersPerFace) {
+        if (kMirrored) {
+          std::reverse(corners.begin() + first, corners.begin() + first + cornersPerFace);
+        }
+        vertices.clear();
+        uvs.clear();
+        normals.clear();
+        for (size_t corner = first; corner < (first + cornersPerFace); corner++) {
+          const size_t ix = corners[corner];
+          const int vertex = face.vertices[ix] - 1;
+          if (vertexMap[vertex] == 0) {
+            vertexMap[vertex] = batch->vertexArray->AppendVertex(source.transform.MultiplyPosition(vertexArray->GetVertex(vertex))) + 1;
+            if (hasColor) {
+              batch->vertexArray->AppendColor(vertexArray->GetColor(vertex));
+            }
+          }
+          vertices.push_back(vertexMap[vertex]);
+          const int normal = face.normals[ix] - 1;
+          if (normalMap[normal] == 0) {
+            normalMap[normal] = batch->vertexArray->AppendNormal(normalTransform.MultiplyDirection(vertexArray->GetNormal(normal)).Normalize()) + 1;
+          }
+          normals.push_back(normalMap[normal]);
+          if (uvLength) {
+            const int uv = face.uvs[ix] - 1;
+            if (uvMap[uv] == 0) {
+              const Vector& sourceUV = vertexArray->GetUV(uv);
+              const Vector kBakedUV = uvTransform.MultiplyPosition(Vector(sourceUV.x(), sourceUV.y(), 0.0f));
+              uvMap[uv] = batch->vertexArray->AppendUV(Vector(kBakedUV.x(), kBakedUV.y(), sourceUV.z())) + 1;
+            }
+            uvs.push_back(uvMap[uv]);
+          }
+        }
+        batch->geometry->AddFace(vertices, uvs, normals);
+      }
+    }
+  }
+
+  for (BakeBatch& batch: batches) {
+    m.bakedNodes.push_back(batch.geometry);
+  }
+  m.baked = true;
+  GraphChanged();
+  VRB_LOG("Baked %d Geometry nodes into %d in Group: %s", (int)sources.size(), (int)batches.size(), m.name.c_str());
+  return true;
+}
+
+void
+Group::Unbake() {
+  if (m.baked) {
+    GraphChanged();
+  }
+  m.bakedNodes.clear();
+  m.baked = false;
+}
+
+bool
+Group::IsBaked() const {
+  return m.baked;
+}
+
+bool
+Group::GetBounds(Vector& aMin, Vector& aMax) const {
+  const uint32_t kGeneration = VertexArray::GetPositionGeneration();
+  if ((m.cachedBoundsVersion != m.boundsVersion) || (m.cachedPositionGeneration != kGeneration)) {
+    Vector min = Vector::Max();
+    Vector max = -Vector::Max();
+    bool hasBounds = false;
+    for (const NodePtr& child: m.children) {
+      if (!child || !m.IsEnabled(*child)) {
+        continue;
+      }
+      Vector childMin, childMax;
+      if (child->IsKind(KindGroup)) {
+        if (!static_cast<const Group*>(child.get())->GetBounds(childMin, childMax)) {
+          continue;
+        }
+        if (child->IsKind(KindTransform)) {
+          // Transform the box by its center and extent.
+          const Matrix& transform = static_cast<const Transform*>(child.get())->GetTransform();
+          const Vector kCenter = transform.MultiplyPosition((childMin + childMax) * 0.5f);
+          const Vector kExtent = (childMax - childMin) * 0.5f;
+          float extent[3];
+          for (int32_t row = 0; row < 3; row++) {
+            extent[row] = std::fabs(transform.At(0, row)) * kExtent.x() +
+                          std::fabs(transform.At(1, row)) * kExtent.y() +
+                          std::fabs(transform.At(2, row)) * kExtent.z();
+          }
+          const Vector kWorldExtent(extent[0], extent[1], extent[2]);
+          childMin = kCenter - kWorldExtent;
+          childMax = kCenter + kWorldExtent;
+        }
+      } else if (child->IsKind(KindGeometry)) {
+        if (!static_cast<const Geometry*>(child.get())->GetBounds(childMin, childMax)) {
+          continue;
+        }
+      } else {
+        continue;
+      }
+      min.Set(std::min(min.x(), childMin.x()), std::min(min.y(), childMin.y()), std::min(min.z(), childMin.z()));
+      max.Set(std::max(max.x(), childMax.x()), std::max(max.y(), childMax.y()), std::max(max.z(), childMax.z()));
+      hasBounds = true;
+    }
+    m.boundsMin = min;
+    m.boundsMax = max;
+    m.hasBounds = hasBounds;
+    m.cachedBoundsVersion = m.boundsVersion;
+    m.cachedPositionGeneration = kGeneration;
+  }
+  aMin = m.boundsMin;
+  aMax = m.boundsMax;
+  return m.hasBounds;
+}
+
+bool
+Group::Pick(const PickRay& aRay, PickResult& aResult) {
+  std::vector<PickRay> rays(1, aRay);
+  std::vector<PickResult> results;
+  Pick(rays, results);
+  aResult = results[0];
+  return aResult.IsHit();
+}
+
+void
+Group::Pick(const std::vector<PickRay>& aRays, std::vector<PickResult>& aResults) {
+  aResults.assign(aRays.size(), PickResult());
+  std::vector<PickRay> localRays(aRays.size());
+  // Pairs of Group and the matrix from pick space into the Group's space.
+  std::vector<std::pair<Group*, Matrix>> stack;
+  stack.emplace_back(this, IsKind(KindTransform) ? static_cast<Transform*>(this)->GetTransform().AfineInverse() : Matrix::Identity());
+  while (!stack.empty()) {
+    Group* group = stack.back().first;
+    const Matrix inverse = stack.back().second;
+    stack.pop_back();
+    bool localRaysValid = false;
+    for (NodePtr& child: group->m.children) {
+      if (!child || !group->m.IsEnabled(*child)) {
+        continue;
+      }
+      if (child->IsKind(KindGroup)) {
+        Group* childGroup = static_cast<Group*>(child.get());
+        const Matrix childInverse = child->IsKind(KindTransform) ?
+            static_cast<Transform*>(child.get())->GetTransform().AfineInverse().PostMultiply(inverse) : inverse;
+        // Skip subtrees whose cached bounds no ray can hit.
+        if (RaysHitGroup(*childGroup, childInverse, aRays, aResults)) {
+          stack.emplace_back(childGroup, childInverse);
+        }
+      } else if (child->IsKind(KindGeometry)) {
+        if (!localRaysValid) {
+          for (size_t ix = 0; ix < aRays.size(); ix++) {
+            localRays[ix].origin = inverse.MultiplyPosition(aRays[ix].origin);
+            localRays[ix].direction = inverse.MultiplyDirection(aRays[ix].direction);
+          }
+          localRaysValid = true;
+        }
+        Geometry* geometry = static_cast<Geometry*>(child.get());
+        for (size_t ix = 0; ix < aRays.size(); ix++) {
+          // The ray parameter is the same in every space since the direction is not
+          // normalized, so aResults[ix].distance holds it until the end of the traversal.
+          if (geometry->Pick(localRays[ix].origin, localRays[ix].direction, aResults[ix])) {
+            aResults[ix].node = child;
+          }
+        }
+      }
+    }
+  }
+  for (size_t ix = 0; ix < aRays.size(); ix++) {
+    PickResult& result = aResults[ix];
+    if (result.IsHit()) {
+      result.point = aRays[ix].origin + (aRays[ix].direction * result.distance);
+      result.distance *= aRays[ix].direction.Magnitude();
+    }
+  }
+}
+
 bool
 Group::Traverse(const GroupPtr& aParent, const Node::TraverseFunction& aTraverseFunction) {
   for (NodePtr& child: m.children) {
+    if (!child) {
+      continue;
+    }
     if (aTraverseFunction(child, aParent)) {
       return true;
     }
+    if (child->IsKind(KindGroup)) {
+      GroupPtr group = std::static_pointer_cast<Group>(child);
+      if (group->Traverse(group, aTraverseFunction)) {
+        return true;
+      }
+    }
   }
 
   return false;
 }
 
-Group::Group(State& aState, CreationContextPtr& aContext) : Node(aState, aContext), m(aState) {}
+void
+Group::InvalidateWorldTransform() {
+  for (NodePtr& child: m.children) {
+    if (child) {
+      Node::InvalidateWorldTransform(*child);
+    }
+  }
+}
+
+Group::Group(State& aState, CreationContextPtr& aContext) : Node(aState, aContext), m(aState) {
+  m.kind |= KindGroup;
+}
 Group::~Group() {
   for (NodePtr& child: m.children) {
-    RemoveFromParents(*this, *child);
+    if (child) {
+      RemoveFromParents(*this, *child);
+    }
   }
 }
 
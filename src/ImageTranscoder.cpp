@@ -0,0 +1,23 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/ImageTranscoder.h"
+#include "vrb/GLExtensions.h"
+
+namespace vrb {
+
+ImageTranscoder::Target
+ImageTranscoder::SelectTarget(const GLExtensions& aExtensions) {
+  if (aExtensions.IsExtensionSupported(GLExtensions::Ext::KHR_texture_compression_astc_ldr)) {
+    return Target::ASTC;
+  }
+  // ETC2 is part of OpenGL ES 3.0.
+  if (aExtensions.IsGLES3Supported()) {
+    return Target::ETC2;
+  }
+  return Target::RGBA;
+}
+
+} // namespace vrb
@@ -0,0 +1,80 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/ImageTranscoderZlib.h"
+#include "vrb/ConcreteClass.h"
+#include "vrb/DataBuffer.h"
+#include "vrb/FileReader.h"
+#include "vrb/KTX2.h"
+#include "vrb/Logger.h"
+
+#include <limits>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+const uint32_t kSupercompressionZlib = 3;
+
+}
+
+namespace vrb {
+
+struct ImageTranscoderZlib::State {
+};
+
+ImageTranscoderZlibPtr
+ImageTranscoderZlib::Create() {
+  return std::make_shared<ConcreteClass<ImageTranscoderZlib, ImageTranscoderZlib::State> >();
+}
+
+bool
+ImageTranscoderZlib::CanTranscode(const uint32_t aVkFormat, const uint32_t aSupercompressionScheme) const {
+  return (aSupercompressionScheme == kSupercompressionZlib) && IsKTX2FormatSupported(aVkFormat);
+}
+
+// Inflates the levels one after another into a new image.
+bool
+ImageTranscoderZlib::Transcode(const DataBufferPtr& aFile, const Target aTarget, DataBufferPtr& aImage, ImageLayout& aLayout) {
+  KTX2Header header;
+  std::string error;
+  if (!aFile || !ReadKTX2Header(aFile->GetData(), aFile->GetSize(), header, error)) {
+    VRB_ERROR("ImageTranscoderZlib: %s", error.c_str());
+    return false;
+  }
+  std::vector<KTX2Level> levels = header.levels;
+  uint64_t total = 0;
+  for (KTX2Level& level: levels) {
+    level.offset = total;
+    level.length = level.uncompressedLength;
+    total += level.length;
+  }
+  // The layout checks every level length against its dimensions, which bounds the total.
+  if (!CreateKTX2Layout(header, levels, aLayout, error)) {
+    VRB_ERROR("ImageTranscoderZlib: %s", error.c_str());
+    return false;
+  }
+  if ((total == 0) || (total > std::numeric_limits<size_t>::max()) || (total > std::numeric_limits<uLong>::max())) {
+    VRB_ERROR("ImageTranscoderZlib: invalid image size");
+    return false;
+  }
+  std::unique_ptr<uint8_t[]> image = std::make_unique<uint8_t[]>((size_t)total);
+  for (size_t ix = 0; ix < levels.size(); ix++) {
+    const KTX2Level& source = header.levels[ix];
+    uLongf length = (uLongf)levels[ix].length;
+    const int result = uncompress(image.get() + levels[ix].offset, &length, aFile->GetData() + source.offset, (uLong)source.length);
+    if ((result != Z_OK) || (length != levels[ix].length)) {
+      VRB_ERROR("ImageTranscoderZlib: failed to inflate level %d, error %d", (int)ix, result);
+      return false;
+    }
+  }
+  aImage = DataBuffer::Create(image, (size_t)total);
+  return true;
+}
+
+ImageTranscoderZlib::ImageTranscoderZlib(State& aState) : m(aState) {}
+ImageTranscoderZlib::~ImageTranscoderZlib() {}
+
+} // namespace vrb
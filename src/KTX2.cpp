@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/KTX2.h"
+#include "vrb/FileReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct KTX2Format {
+  uint32_t vkFormat;
+  GLenum internalFormat;
+  GLenum format;
+  GLenum type;
+  bool compressed;
+  // Bytes per pixel, or per 4x4 block when compressed.
+  uint32_t blockSize;
+};
+
+const KTX2Format kKTX2Formats[] = {
+  {23, GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, false, 3},            // R8G8B8_UNORM
+  {37, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, false, 4},          // R8G8B8A8_UNORM
+  {43, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, false, 4},  // R8G8B8A8_SRGB
+  {147, 0x9274, 0x9274, 0, true, 8},                           // ETC2_R8G8B8_UNORM_BLOCK
+  {148, 0x9275, 0x9275, 0, true, 8},                           // ETC2_R8G8B8_SRGB_BLOCK
+  {149, 0x9276, 0x9276, 0, true, 8},                           // ETC2_R8G8B8A1_UNORM_BLOCK
+  {150, 0x9277, 0x9277, 0, true, 8},                           // ETC2_R8G8B8A1_SRGB_BLOCK
+  {151, 0x9278, 0x9278, 0, true, 16},                          // ETC2_R8G8B8A8_UNORM_BLOCK
+  {152, 0x9279, 0x9279, 0, true, 16},                          // ETC2_R8G8B8A8_SRGB_BLOCK
+  {157, 0x93B0, 0x93B0, 0, true, 16},                          // ASTC_4x4_UNORM_BLOCK
+  {158, 0x93D0, 0x93D0, 0, true, 16},                          // ASTC_4x4_SRGB_BLOCK
+};
+
+const uint8_t kKTX2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+const size_t kKTX2HeaderSize = 80;
+const size_t kKTX2LevelIndexSize = 24;
+// Larger than any GL_MAX_TEXTURE_SIZE, keeps the level sizes from overflowing.
+const uint32_t kMaxKTX2Size = 1u << 16;
+
+uint32_t
+ReadU32(const uint8_t* aData) {
+  uint32_t result;
+  memcpy(&result, aData, sizeof(result));
+  return result;
+}
+
+uint64_t
+ReadU64(const uint8_t* aData) {
+  uint64_t result;
+  memcpy(&result, aData, sizeof(result));
+  return result;
+}
+
+const KTX2Format*
+FindFormat(const uint32_t aVkFormat) {
+  for (const KTX2Format& format: kKTX2Formats) {
+    if (format.vkFormat == aVkFormat) {
+      return &format;
+    }
+  }
+  return nullptr;
+}
+
+}
+
+namespace vrb {
+
+bool
+IsKTX2(const uint8_t* aData, const size_t aSize) {
+  return (aSize >= sizeof(kKTX2Identifier)) && (memcmp(aData, kKTX2Identifier, sizeof(kKTX2Identifier)) == 0);
+}
+
+bool
+ReadKTX2Header(const uint8_t* aData, const size_t aSize, KTX2Header& aHeader, std::string& aError) {
+  if (aSize < kKTX2HeaderSize) {
+    aError = "Truncated KTX2 header";
+    return false;
+  }
+  aHeader.vkFormat = ReadU32(aData + 12);
+  aHeader.width = ReadU32(aData + 20);
+  aHeader.height = ReadU32(aData + 24);
+  aHeader.depth = ReadU32(aData + 28);
+  aHeader.layers = ReadU32(aData + 32);
+  aHeader.faces = ReadU32(aData + 36);
+  const uint32_t kLevels = std::max(ReadU32(aData + 40), 1u);
+  aHeader.supercompression = ReadU32(aData + 44);
+  // Levels past the 1x1 one would shift the size by 32 bits or more.
+  uint32_t maxLevels = 1;
+  for (uint32_t size = std::max(aHeader.width, aHeader.height); size > 1; size >>= 1) {
+    maxLevels++;
+  }
+  if (kLevels > maxLevels) {
+    aError = "Too many KTX2 levels: " + std::to_string(kLevels);
+    return false;
+  }
+  if ((kKTX2HeaderSize + (kLevels * kKTX2LevelIndexSize)) > aSize) {
+    aError = "Truncated KTX2 level index";
+    return false;
+  }
+  aHeader.levels.clear();
+  for (uint32_t level = 0; level < kLevels; level++) {
+    const uint8_t* index = aData + kKTX2HeaderSize + (level * kKTX2LevelIndexSize);
+    KTX2Level info;
+    info.offset = ReadU64(index);
+    info.length = ReadU64(index + 8);
+    info.uncompressedLength = ReadU64(index + 16);
+    // Written so that it can not wrap around.
+    if ((info.length > aSize) || (info.offset > (aSize - info.length))) {
+      aError = "Truncated KTX2 level data";
+      return false;
+    }
+    aHeader.levels.push_back(info);
+  }
+  return true;
+}
+
+bool
+IsKTX2FormatSupported(const uint32_t aVkFormat) {
+  return FindFormat(aVkFormat) != nullptr;
+}
+
+bool
+CreateKTX2Layout(const KTX2Header& aHeader, const std::vector<KTX2Level>& aLevels, ImageLayout& aLayout, std::string& aError) {
+  if ((aHeader.depth > 1) || (aHeader.layers > 1) || ((aHeader.faces != 1) && (aHeader.faces != 6)) ||
+      (aHeader.width == 0) || (aHeader.height == 0) || (aHeader.width > kMaxKTX2Size) || (aHeader.height > kMaxKTX2Size)) {
+    aError = "Unsupported KTX2 texture type";
+    return false;
+  }
+  const KTX2Format* format = FindFormat(aHeader.vkFormat);
+  if (!format) {
+    aError = "Unsupported KTX2 VkFormat " + std::to_string(aHeader.vkFormat);
+    return false;
+  }
+  aLayout.target = (aHeader.faces == 6) ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  aLayout.internalFormat = format->internalFormat;
+  aLayout.format = format->format;
+  aLayout.type = format->type;
+  aLayout.compressed = format->compressed;
+  aLayout.levels.clear();
+  for (uint32_t face = 0; face < aHeader.faces; face++) {
+    for (uint32_t level = 0; level < (uint32_t)aLevels.size(); level++) {
+      const uint64_t kWidth = std::max(aHeader.width >> level, 1u);
+      const uint64_t kHeight = std::max(aHeader.height >> level, 1u);
+      const uint64_t kFaceSize = format->compressed ? ((kWidth + 3) / 4) * ((kHeight + 3) / 4) * format->blockSize
+                                                    : kWidth * kHeight * format->blockSize;
+      if (aLevels[level].length != (kFaceSize * aHeader.faces)) {
+        aError = "KTX2 level " + std::to_string(level) + " size does not match its dimensions";
+        return false;
+      }
+      ImageLayout::Level info;
+      info.target = (aHeader.faces == 6) ? (GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face) : GL_TEXTURE_2D;
+      info.level = (GLint)level;
+      info.width = (GLsizei)kWidth;
+      info.height = (GLsizei)kHeight;
+      info.size = (size_t)kFaceSize;
+      info.offset = (size_t)aLevels[level].offset + (face * info.size);
+      aLayout.levels.push_back(info);
+    }
+  }
+  return true;
+}
+
+} // namespace vrb
@@ -0,0 +1,60 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/LightSet.h"
+
+#include "vrb/Color.h"
+#include "vrb/Logger.h"
+#include "vrb/Vector.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+std::atomic<uint32_t> sLightSetId(0);
+}
+
+namespace vrb {
+
+LightSet::LightSet() : id(0) {
+  memset(&data, 0, sizeof(data));
+}
+
+void
+LightSet::Clear() {
+  memset(&data, 0, sizeof(data));
+}
+
+bool
+LightSet::Add(const Vector& aDirection, const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular) {
+  if (data.count >= VRB_MAX_LIGHTS) {
+    VRB_WARN("Unable to add light, maximum of %d lights reached", VRB_MAX_LIGHTS);
+    return false;
+  }
+  Light& light = data.lights[data.count];
+  memcpy(light.direction, aDirection.Data(), sizeof(float) * 3);
+  light.direction[3] = 0.0f;
+  memcpy(light.ambient, aAmbient.Data(), sizeof(light.ambient));
+  memcpy(light.diffuse, aDiffuse.Data(), sizeof(light.diffuse));
+  memcpy(light.specular, aSpecular.Data(), sizeof(light.specular));
+  data.count++;
+  return true;
+}
+
+bool
+LightSet::HasSameLights(const LightSet& aOther) const {
+  return memcmp(&data, &aOther.data, sizeof(data)) == 0;
+}
+
+uint32_t
+LightSet::NextId() {
+  uint32_t result = ++sLightSetId;
+  if (result == 0) {
+    result = ++sLightSetId;
+  }
+  return result;
+}
+
+} // namespace vrb
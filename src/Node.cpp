@@ -7,8 +7,17 @@
 #include "vrb/private/NodeState.h"
 #include "vrb/Logger.h"
 
+#include <atomic>
+
+namespace {
+std::atomic<uint32_t> sGraphGeneration(0);
+}
+
 namespace vrb {
 
+uint32_t
+Node::GetKind() const { return m.kind; }
+
 const std::string&
 Node::GetName() const { return m.name; }
 
@@ -40,7 +49,10 @@ Node::RemoveFromParents() {
   }
 }
 
-Node::Node(State& aState, CreationContextPtr& aContext) : m(aState) {}
+Node::Node(State& aState, CreationContextPtr& aContext) : m(aState) {
+  m.version = ++sGraphGeneration;
+  m.boundsVersion = m.version;
+}
 Node::~Node() {
   if (m.parents.size() != 0) {
     const char* name = (m.name.size() ? m.name.c_str() : "<unnamed>");
@@ -48,17 +60,62 @@ Node::~Node() {
   }
 }
 
+uint32_t
+Node::GetVersion() const {
+  return m.version;
+}
+
+// Stamps this node and every ancestor with a new version.
+void
+Node::GraphChanged() {
+  StampAncestors(true);
+}
+
+void
+Node::BoundsChanged() {
+  StampAncestors(false);
+}
+
+void
+Node::StampAncestors(const bool aGraphChanged) {
+  const uint32_t kVersion = ++sGraphGeneration;
+  std::vector<Node*> stack;
+  stack.push_back(this);
+  while (!stack.empty()) {
+    Node* node = stack.back();
+    stack.pop_back();
+    if (node->m.boundsVersion == kVersion) {
+      continue;
+    }
+    node->m.boundsVersion = kVersion;
+    if (aGraphChanged) {
+      node->m.version = kVersion;
+    }
+    for (GroupWeak& weak: node->m.parents) {
+      if (GroupPtr parent = weak.lock()) {
+        stack.push_back(parent.get());
+      }
+    }
+  }
+}
+
 void
 Node::AddToParents(GroupWeak& aParent, Node& aChild) {
+  if (GroupPtr parent = aParent.lock()) {
+    static_cast<Node&>(*parent).GraphChanged();
+  }
   aChild.m.parents.push_back(aParent);
+  aChild.InvalidateWorldTransform();
 }
 
 void
 Node::RemoveFromParents(Group& aParent, Node& aChild) {
+  static_cast<Node&>(aParent).GraphChanged();
   for (auto it = aChild.m.parents.begin(); it != aChild.m.parents.end();) {
     Group* node = it->lock().get();
     if (node == &aParent) {
       it = aChild.m.parents.erase(it);
+      aChild.InvalidateWorldTransform();
       return;
     } else if (node == nullptr) {
       it = aChild.m.parents.erase(it);
@@ -68,12 +125,69 @@ Node::RemoveFromParents(Group& aParent, Node& aChild) {
   }
 }
 
+GroupPtr
+Node::GetFirstParent(const Node& aNode) {
+  if (aNode.m.parents.size() > 1) {
+    VRB_WARN("Calculating world transform where node has more than one parent");
+  }
+  for (const GroupWeak& weak: aNode.m.parents) {
+    if (GroupPtr parent = weak.lock()) {
+      return parent;
+    }
+  }
+  return nullptr;
+}
+
+void
+Node::InvalidateWorldTransform(Node& aNode) {
+  aNode.InvalidateWorldTransform();
+}
+
+void
+Node::InvalidateWorldTransform() {}
+
 bool
 Node::Traverse(const NodePtr& aRootNode, const TraverseFunction& aTraverseFunction) {
   if (aTraverseFunction(aRootNode, nullptr)) {
     return true;
   }
-  return aRootNode->Traverse(std::dynamic_pointer_cast<Group>(aRootNode), aTraverseFunction);
+  if (!aRootNode->IsKind(KindGroup)) {
+    return false;
+  }
+  return aRootNode->Traverse(std::static_pointer_cast<Group>(aRootNode), aTraverseFunction);
+}
+
+bool
+Node::Visit(Node& aRootNode, const uint32_t aKindFilter, VisitCallback aCallback, void* aData) {
+  // Pairs of Group and index of the next child to visit.
+  std::vector<std::pair<Group*, int32_t>> stack;
+  Node* node = &aRootNode;
+  while (true) {
+    if (node) {
+      TraverseResult result = TraverseResult::Continue;
+      if ((node->m.kind & aKindFilter) == aKindFilter) {
+        result = aCallback(*node, aData);
+      }
+      if (result == TraverseResult::Stop) {
+        return true;
+      }
+      if ((result == TraverseResult::Continue) && (node->m.kind & KindGroup)) {
+        stack.emplace_back(static_cast<Group*>(node), 0);
+      }
+    }
+    if (stack.empty()) {
+      return false;
+    }
+    Group* group = stack.back().first;
+    int32_t& index = stack.back().second;
+    if (index < group->GetNodeCount()) {
+      node = group->GetNode(index).get();
+      index++;
+    } else {
+      node = nullptr;
+      stack.pop_back();
+    }
+  }
 }
 
 bool
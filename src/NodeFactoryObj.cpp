@@ -8,21 +8,76 @@
 #include "vrb/Color.h"
 #include "vrb/ConcreteClass.h"
 #include "vrb/CreationContext.h"
+#include "vrb/DataBuffer.h"
+#include "vrb/FileReader.h"
 #include "vrb/Geometry.h"
 #include "vrb/Group.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
 #include "vrb/Mutex.h"
 #include "vrb/Program.h"
 #include "vrb/ProgramFactory.h"
 #include "vrb/RenderState.h"
 #include "vrb/Texture.h"
+#include "vrb/TextureAtlas.h"
 #include "vrb/TextureGL.h"
 #include "vrb/Vector.h"
 #include "vrb/VertexArray.h"
 
 #include <unordered_map>
+#include <vector>
 
 namespace {
 
+struct AtlasMaterial;
+typedef std::shared_ptr<AtlasMaterial> AtlasMaterialPtr;
+
+// Where the diffuse texture of a material ended up in the atlas. Geometry using the
+// material draws the shared RenderState of the atlas page with its own UV transform.
+// Until the image is packed the Geometry waits in pending with the material's own
+// RenderState, which draws the default texture.
+struct AtlasMaterial {
+  vrb::RenderStatePtr state;
+  vrb::Matrix uvTransform;
+  std::vector<vrb::GeometryWeak> pending;
+
+  AtlasMaterial() : uvTransform(vrb::Matrix::Identity()) {}
+  void Apply(vrb::Geometry& aGeometry) const {
+    aGeometry.SetRenderState(state);
+    aGeometry.SetUVTransform(uvTransform);
+  }
+};
+
+struct AtlasRenderStates;
+typedef std::shared_ptr<AtlasRenderStates> AtlasRenderStatesPtr;
+
+// RenderStates shared by atlased materials, one per atlas page and lighting material,
+// so their Geometry can be state sorted and baked together.
+struct AtlasRenderStates {
+  std::vector<vrb::RenderStatePtr> states;
+
+  vrb::RenderStatePtr Get(vrb::CreationContextPtr& aContext, const vrb::TextureGLPtr& aPage,
+                          const vrb::Color& aAmbient, const vrb::Color& aDiffuse, const vrb::Color& aSpecular,
+                          const float aSpecularExponent) {
+    for (const vrb::RenderStatePtr& state: states) {
+      vrb::Color ambient, diffuse, specular;
+      float specularExponent = 0.0f;
+      state->GetMaterial(ambient, diffuse, specular, specularExponent);
+      if ((state->GetTexture() == aPage) && (ambient == aAmbient) && (diffuse == aDiffuse) &&
+          (specular == aSpecular) && (specularExponent == aSpecularExponent)) {
+        return state;
+      }
+    }
+    vrb::RenderStatePtr result = vrb::RenderState::Create(aContext);
+    vrb::ProgramPtr program = aContext->GetProgramFactory()->CreateProgram(aContext, vrb::FeatureTexture | vrb::FeatureUVTransform);
+    result->SetProgram(program);
+    result->SetTexture(aPage);
+    result->SetMaterial(aAmbient, aDiffuse, aSpecular, aSpecularExponent);
+    states.push_back(result);
+    return result;
+  }
+};
+
 struct Material {
   vrb::Color ambient;
   vrb::Color diffuse;
@@ -32,10 +87,133 @@ struct Material {
   std::string diffuseTextureName;
   std::string specularTextureName;
   vrb::RenderStatePtr state;
+  // Set when the diffuse texture goes to the atlas.
+  AtlasMaterialPtr atlas;
 
   Material () : specularExponent(0.0f) {}
 };
 
+class AtlasTextureHandler;
+typedef std::shared_ptr<AtlasTextureHandler> AtlasTextureHandlerPtr;
+
+// Packs a loaded diffuse texture into the atlas and moves the material's Geometry to
+// the shared RenderState of its page. Images the atlas can not take are given their
+// own texture in the material's RenderState instead.
+class AtlasTextureHandler : public vrb::FileHandler {
+public:
+  static AtlasTextureHandlerPtr Create(vrb::CreationContextPtr& aContext, const vrb::TextureAtlasPtr& aAtlas,
+                                      const AtlasRenderStatesPtr& aStates, const std::string& aName,
+                                      const AtlasMaterialPtr& aMaterial, const vrb::RenderStatePtr& aState);
+  void BindFileHandle(const std::string& aFileName, const int aFileHandle) override {}
+  void LoadFailed(const int aFileHandle, const std::string& aReason) override;
+  void ProcessRawFileChunk(const int aFileHandle, const char* aBuffer, const size_t aSize) override {}
+  void FinishRawFile(const int aFileHandle) override {}
+  void ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) override;
+  void ProcessImageLevels(const int aFileHandle, const vrb::DataBufferPtr& aImage, const vrb::ImageLayout& aLayout) override;
+  AtlasTextureHandler() {}
+  ~AtlasTextureHandler() {}
+protected:
+  bool AddToAtlas(const uint8_t* aPixels, const int aWidth, const int aHeight);
+  vrb::TextureGLPtr CreateTexture();
+  vrb::CreationContextWeak mContext;
+  vrb::TextureAtlasPtr mAtlas;
+  AtlasRenderStatesPtr mStates;
+  std::string mName;
+  AtlasMaterialPtr mMaterial;
+  vrb::RenderStatePtr mState;
+private:
+  VRB_NO_DEFAULTS(AtlasTextureHandler)
+};
+
+AtlasTextureHandlerPtr
+AtlasTextureHandler::Create(vrb::CreationContextPtr& aContext, const vrb::TextureAtlasPtr& aAtlas,
+                            const AtlasRenderStatesPtr& aStates, const std::string& aName,
+                            const AtlasMaterialPtr& aMaterial, const vrb::RenderStatePtr& aState) {
+  AtlasTextureHandlerPtr result = std::make_shared<AtlasTextureHandler>();
+  result->mContext = aContext;
+  result->mAtlas = aAtlas;
+  result->mStates = aStates;
+  result->mName = aName;
+  result->mMaterial = aMaterial;
+  result->mState = aState;
+  return result;
+}
+
+void
+AtlasTextureHandler::LoadFailed(const int aFileHandle, const std::string& aReason) {
+  VRB_ERROR("Failed to load texture: %s", aReason.c_str());
+}
+
+void
+AtlasTextureHandler::ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) {
+  if ((aFormat == GL_RGBA) && (aImageLength == ((uint64_t)aWidth * aHeight * 4)) && AddToAtlas(aImage.get(), aWidth, aHeight)) {
+    return;
+  }
+  vrb::TextureGLPtr texture = CreateTexture();
+  if (texture) {
+    texture->SetImageData(aImage, aImageLength, aWidth, aHeight, aFormat);
+  }
+}
+
+void
+AtlasTextureHandler::ProcessImageLevels(const int aFileHandle, const vrb::DataBufferPtr& aImage, const vrb::ImageLayout& aLayout) {
+  if (aLayout.levels.empty()) {
+    return;
+  }
+  // Only the first level is packed, the atlas has no mipmaps.
+  const vrb::ImageLayout::Level& first = aLayout.levels.front();
+  if ((aLayout.target == GL_TEXTURE_2D) && !aLayout.compressed && (aLayout.format == GL_RGBA) &&
+      (aLayout.type == GL_UNSIGNED_BYTE) && (first.size == ((size_t)first.width * first.height * 4)) &&
+      ((first.offset + first.size) <= aImage->GetSize()) &&
+      AddToAtlas(aImage->GetData() + first.offset, first.width, first.height)) {
+    return;
+  }
+  vrb::TextureGLPtr texture = CreateTexture();
+  if (texture) {
+    texture->SetImageLevels(aImage, aLayout);
+  }
+}
+
+bool
+AtlasTextureHandler::AddToAtlas(const uint8_t* aPixels, const int aWidth, const int aHeight) {
+  vrb::CreationContextPtr context = mContext.lock();
+  if (!context) {
+    return false;
+  }
+  vrb::TextureGLPtr texture;
+  vrb::Matrix uvTransform = vrb::Matrix::Identity();
+  if (!mAtlas->Add(mName, aPixels, aWidth, aHeight, texture, uvTransform)) {
+    return false;
+  }
+  vrb::Color ambient, diffuse, specular;
+  float specularExponent = 0.0f;
+  mState->GetMaterial(ambient, diffuse, specular, specularExponent);
+  mMaterial->state = mStates->Get(context, texture, ambient, diffuse, specular, specularExponent);
+  mMaterial->uvTransform = uvTransform;
+  for (vrb::GeometryWeak& weak: mMaterial->pending) {
+    vrb::GeometryPtr geometry = weak.lock();
+    // The Geometry may have been given another material since.
+    if (geometry && (geometry->GetRenderState() == mState)) {
+      mMaterial->Apply(*geometry);
+    }
+  }
+  mMaterial->pending.clear();
+  return true;
+}
+
+vrb::TextureGLPtr
+AtlasTextureHandler::CreateTexture() {
+  vrb::CreationContextPtr context = mContext.lock();
+  if (!context) {
+    return nullptr;
+  }
+  vrb::TextureGLPtr texture = vrb::TextureGL::Create(context);
+  texture->SetName(mName);
+  mState->SetTexture(texture);
+  mState->SetUVTransform(vrb::Matrix::Identity());
+  return texture;
+}
+
 }
 
 namespace vrb {
@@ -49,6 +227,8 @@ struct NodeFactoryObj::State {
   GeometryPtr currentGeometry;
   Material* currentMaterial;
   RenderStatePtr defaultRenderState;
+  TextureAtlasPtr atlas;
+  AtlasRenderStatesPtr atlasStates;
 
   State()
       : groupId(0)
@@ -64,8 +244,36 @@ struct NodeFactoryObj::State {
     currentMaterial = nullptr;
   }
   void CreateRenderState(Material& aMaterial);
+  bool CreateAtlasRenderState(CreationContextPtr& aContext, Material& aMaterial);
 };
 
+// The texture is loaded into the atlas, the default texture is drawn until then.
+bool
+NodeFactoryObj::State::CreateAtlasRenderState(CreationContextPtr& aContext, Material& aMaterial) {
+  if (!atlas || aMaterial.diffuseTextureName.empty()) {
+    return false;
+  }
+  aMaterial.atlas = std::make_shared<AtlasMaterial>();
+  TextureGLPtr texture;
+  Matrix uvTransform = Matrix::Identity();
+  if (atlas->Find(aMaterial.diffuseTextureName, texture, uvTransform)) {
+    aMaterial.atlas->state = atlasStates->Get(aContext, texture, aMaterial.ambient, aMaterial.diffuse,
+                                              aMaterial.specular, aMaterial.specularExponent);
+    aMaterial.atlas->uvTransform = uvTransform;
+    aMaterial.state = aMaterial.atlas->state;
+    return true;
+  }
+  ProgramPtr program = aContext->GetProgramFactory()->CreateProgram(aContext, FeatureTexture | FeatureUVTransform);
+  aMaterial.state = RenderState::Create(aContext);
+  aMaterial.state->SetProgram(program);
+  aMaterial.state->SetTexture(aContext->GetDefaultTexture());
+  // The handler may run before this returns and reads the material from the RenderState.
+  aMaterial.state->SetMaterial(aMaterial.ambient, aMaterial.diffuse, aMaterial.specular, aMaterial.specularExponent);
+  aContext->GetFileReader()->ReadImageFile(aMaterial.diffuseTextureName,
+      AtlasTextureHandler::Create(aContext, atlas, atlasStates, aMaterial.diffuseTextureName, aMaterial.atlas, aMaterial.state));
+  return true;
+}
+
 void
 NodeFactoryObj::State::CreateRenderState(Material& aMaterial) {
   if (aMaterial.state) {
@@ -73,7 +281,7 @@ NodeFactoryObj::State::CreateRenderState(Material& aMaterial) {
   }
 
   CreationContextPtr creation = context.lock();
-  if (creation) {
+  if (creation && !CreateAtlasRenderState(creation, aMaterial)) {
     TexturePtr texture;
     if (!aMaterial.diffuseTextureName.empty()) {
       texture = creation->LoadTexture(aMaterial.diffuseTextureName);
@@ -168,6 +376,15 @@ NodeFactoryObj::SetMaterialName(const std::string& aName) {
   }
 
   m.currentGeometry->SetRenderState(material.state);
+  Matrix uvTransform;
+  if (material.atlas && material.atlas->state) {
+    material.atlas->Apply(*m.currentGeometry);
+  } else if (material.atlas) {
+    material.atlas->pending.push_back(m.currentGeometry);
+  } else if (m.currentGeometry->GetUVTransform(uvTransform)) {
+    // Drops the UV transform of an atlased material set earlier.
+    m.currentGeometry->SetUVTransform(Matrix::Identity());
+  }
 }
 
 void
@@ -293,6 +510,12 @@ NodeFactoryObj::GetModelRoot() {
   return m.root;
 }
 
+void
+NodeFactoryObj::SetTextureAtlas(const TextureAtlasPtr& aAtlas) {
+  m.atlas = aAtlas;
+  m.atlasStates = aAtlas ? std::make_shared<AtlasRenderStates>() : nullptr;
+}
+
 NodeFactoryObj::NodeFactoryObj(State& aState, CreationContextPtr& aContext) : m(aState) {
   m.context = aContext;
 }
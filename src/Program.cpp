@@ -9,14 +9,74 @@
 #include "vrb/Program.h"
 
 #include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace vrb {
 
 struct Program::State {
   GLuint program = 0;
   uint32_t features = 0;
+  ProgramPtr multiviewVariant;
+  UniformCache uniforms;
+  // Locations of all active uniforms and attributes, reflected once after link.
+  std::unordered_map<std::string, GLint> uniformLocations;
+  std::unordered_map<std::string, GLint> attributeLocations;
+  void Reflect();
 };
 
+void
+Program::State::Reflect() {
+  uniformLocations.clear();
+  attributeLocations.clear();
+  if (!program) {
+    return;
+  }
+  GLint count = 0;
+  GLint maxLength = 0;
+  VRB_GL_CHECK(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count));
+  VRB_GL_CHECK(glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+  std::unique_ptr<char[]> name = std::make_unique<char[]>(maxLength + 1);
+  for (GLint ix = 0; ix < count; ix++) {
+    GLint size = 0;
+    GLenum type = 0;
+    GLsizei length = 0;
+    VRB_GL_CHECK(glGetActiveUniform(program, (GLuint)ix, maxLength + 1, &length, &size, &type, name.get()));
+    std::string uniform(name.get(), (size_t)length);
+    const GLint location = VRB_GL_CHECK(glGetUniformLocation(program, uniform.c_str()));
+    if (location < 0) {
+      // Members of uniform blocks have no location.
+      continue;
+    }
+    // Arrays are reported as "name[0]". Register the bare name and every element.
+    const size_t kArrayStart = uniform.length() > 3 ? uniform.rfind("[0]") : std::string::npos;
+    if ((kArrayStart != std::string::npos) && (kArrayStart == uniform.length() - 3)) {
+      const std::string base = uniform.substr(0, kArrayStart);
+      uniformLocations[base] = location;
+      for (GLint element = 1; element < size; element++) {
+        const std::string elementName = base + "[" + std::to_string(element) + "]";
+        uniformLocations[elementName] = VRB_GL_CHECK(glGetUniformLocation(program, elementName.c_str()));
+      }
+    }
+    uniformLocations[uniform] = location;
+  }
+
+  VRB_GL_CHECK(glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count));
+  VRB_GL_CHECK(glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength));
+  name = std::make_unique<char[]>(maxLength + 1);
+  for (GLint ix = 0; ix < count; ix++) {
+    GLint size = 0;
+    GLenum type = 0;
+    GLsizei length = 0;
+    VRB_GL_CHECK(glGetActiveAttrib(program, (GLuint)ix, maxLength + 1, &length, &size, &type, name.get()));
+    std::string attribute(name.get(), (size_t)length);
+    attributeLocations[attribute] = VRB_GL_CHECK(glGetAttribLocation(program, attribute.c_str()));
+  }
+}
+
 ProgramPtr
 Program::Create() {
   return std::make_shared<ConcreteClass<Program, Program::State> >();
@@ -45,6 +105,13 @@ Program::SupportsFeatures(const uint32_t aFeatures) {
 void
 Program::SetProgram(GLuint aProgram) {
   m.program = aProgram;
+  m.uniforms = UniformCache();
+  m.Reflect();
+}
+
+Program::UniformCache&
+Program::GetUniformCache() {
+  return m.uniforms;
 }
 
 GLuint
@@ -52,22 +119,57 @@ Program::GetProgram() const {
   return m.program;
 }
 
+bool
+Program::IsReady() const {
+  return m.program != 0;
+}
+
+ProgramPtr
+Program::GetMultiviewVariant() const {
+  return m.multiviewVariant;
+}
+
+void
+Program::SetMultiviewVariant(const ProgramPtr& aProgram) {
+  m.multiviewVariant = aProgram;
+}
+
 GLint
 Program::GetAttributeLocation(const char* aName) {
+  return GetAttributeLocation(std::string(aName));
+}
+
+GLint
+Program::GetAttributeLocation(const std::string& aName) {
   if (!m.program) {
     return -1;
   }
 
-  return vrb::GetAttributeLocation(m.program, aName);
+  auto found = m.attributeLocations.find(aName);
+  if (found == m.attributeLocations.end()) {
+    VRB_ERROR("Failed to find active attribute '%s'", aName.c_str());
+    return -1;
+  }
+  return found->second;
 }
 
 GLint
 Program::GetUniformLocation(const char* aName) {
+  return GetUniformLocation(std::string(aName));
+}
+
+GLint
+Program::GetUniformLocation(const std::string& aName) {
   if (!m.program) {
     return -1;
   }
 
-  return vrb::GetUniformLocation(m.program, aName);
+  auto found = m.uniformLocations.find(aName);
+  if (found == m.uniformLocations.end()) {
+    VRB_ERROR("Failed to find active uniform '%s'", aName.c_str());
+    return -1;
+  }
+  return found->second;
 }
 
 
@@ -0,0 +1,204 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/ProgramBinaryCache.h"
+#include "vrb/ConcreteClass.h"
+
+#include "vrb/DataCache.h"
+#include "vrb/Logger.h"
+#include "vrb/Mutex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t kMagic = 0x50425256; // "VRBP"
+// Bump when the file layout changes.
+const uint32_t kVersion = 1;
+const char* kFilePrefix = "/vrb_program_";
+const char* kFileSuffix = ".bin";
+
+struct BinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t driverHash;
+  uint32_t keyLength;
+  uint32_t format;
+  uint64_t binaryLength;
+};
+
+// FNV-1a, stable across runs unlike std::hash.
+uint64_t
+Hash(const std::string& aValue) {
+  uint64_t result = 0xcbf29ce484222325ULL;
+  for (const char value: aValue) {
+    result ^= (uint8_t)value;
+    result *= 0x100000001b3ULL;
+  }
+  return result;
+}
+
+bool
+WriteAll(const int aFile, const void* aData, const size_t aSize) {
+  const uint8_t* data = (const uint8_t*)aData;
+  size_t toWrite = aSize;
+  while (toWrite > 0) {
+    ssize_t written = write(aFile, data, toWrite);
+    if (written < 0) {
+      return false;
+    }
+    toWrite -= (size_t)written;
+    data += written;
+  }
+  return true;
+}
+
+bool
+ReadAll(const int aFile, void* aData, const size_t aSize) {
+  uint8_t* data = (uint8_t*)aData;
+  size_t toRead = aSize;
+  while (toRead > 0) {
+    ssize_t dataRead = read(aFile, data, toRead);
+    if (dataRead <= 0) {
+      return false;
+    }
+    toRead -= (size_t)dataRead;
+    data += dataRead;
+  }
+  return true;
+}
+
+}
+
+namespace vrb {
+
+struct ProgramBinaryCache::State {
+  Mutex lock;
+  DataCacheWeak dataCache;
+  uint64_t driverHash;
+  State() : driverHash(0) {}
+  std::string GetPath(const std::string& aKey);
+};
+
+std::string
+ProgramBinaryCache::State::GetPath(const std::string& aKey) {
+  DataCachePtr cache = dataCache.lock();
+  if (!cache) {
+    return std::string();
+  }
+  const std::string root = cache->GetCachePath();
+  if (root.empty()) {
+    return root;
+  }
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", (unsigned long long)Hash(aKey));
+  return root + kFilePrefix + name + kFileSuffix;
+}
+
+ProgramBinaryCachePtr
+ProgramBinaryCache::Create(const DataCachePtr& aDataCache) {
+  ProgramBinaryCachePtr result = std::make_shared<ConcreteClass<ProgramBinaryCache, ProgramBinaryCache::State> >();
+  result->m.dataCache = aDataCache;
+  return result;
+}
+
+void
+ProgramBinaryCache::SetDriverIdentity(const std::string& aIdentity) {
+  MutexAutoLock lock(m.lock);
+  m.driverHash = Hash(aIdentity);
+}
+
+bool
+ProgramBinaryCache::Load(const std::string& aKey, GLenum& aFormat, std::unique_ptr<uint8_t[]>& aBinary, size_t& aSize) {
+  MutexAutoLock lock(m.lock);
+  const std::string path = m.GetPath(aKey);
+  if (path.empty()) {
+    return false;
+  }
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  BinaryHeader header = {};
+  bool valid = ReadAll(file, &header, sizeof(header)) &&
+      (header.magic == kMagic) &&
+      (header.version == kVersion) &&
+      (header.driverHash == m.driverHash) &&
+      (header.keyLength == aKey.length()) &&
+      (header.binaryLength > 0);
+  // A corrupt length must not be used to size the allocation below.
+  struct stat info = {};
+  valid = valid && (fstat(file, &info) == 0) &&
+      ((uint64_t)info.st_size == (sizeof(header) + header.keyLength + header.binaryLength));
+  if (valid) {
+    std::unique_ptr<char[]> key = std::make_unique<char[]>(header.keyLength);
+    valid = ReadAll(file, key.get(), header.keyLength) && (memcmp(key.get(), aKey.data(), header.keyLength) == 0);
+  }
+  if (valid) {
+    aBinary = std::make_unique<uint8_t[]>(header.binaryLength);
+    valid = ReadAll(file, aBinary.get(), header.binaryLength);
+  }
+  close(file);
+  if (!valid) {
+    VRB_LOG("Discarding stale program binary: %s", path.c_str());
+    aBinary.reset();
+    remove(path.c_str());
+    return false;
+  }
+  aFormat = (GLenum)header.format;
+  aSize = (size_t)header.binaryLength;
+  return true;
+}
+
+bool
+ProgramBinaryCache::Store(const std::string& aKey, const GLenum aFormat, const uint8_t* aBinary, const size_t aSize) {
+  MutexAutoLock lock(m.lock);
+  const std::string path = m.GetPath(aKey);
+  if (path.empty() || !aBinary || (aSize == 0)) {
+    return false;
+  }
+  // Write to a temporary file first so a partially written binary is never loaded.
+  const std::string tmpPath = path + ".tmp";
+  int file = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0660);
+  if (file < 0) {
+    VRB_ERROR("Failed to open program binary: %s for writing", tmpPath.c_str());
+    return false;
+  }
+  BinaryHeader header = {};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.driverHash = m.driverHash;
+  header.keyLength = (uint32_t)aKey.length();
+  header.format = (uint32_t)aFormat;
+  header.binaryLength = aSize;
+  const bool written = WriteAll(file, &header, sizeof(header)) &&
+      WriteAll(file, aKey.data(), aKey.length()) &&
+      WriteAll(file, aBinary, aSize);
+  close(file);
+  if (!written || (rename(tmpPath.c_str(), path.c_str()) != 0)) {
+    VRB_ERROR("Failed writing program binary: %s", path.c_str());
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+void
+ProgramBinaryCache::Remove(const std::string& aKey) {
+  MutexAutoLock lock(m.lock);
+  const std::string path = m.GetPath(aKey);
+  if (!path.empty()) {
+    remove(path.c_str());
+  }
+}
+
+ProgramBinaryCache::ProgramBinaryCache(State& aState) : m(aState) {}
+
+} // namespace vrb
@@ -10,31 +10,148 @@
 #include "vrb/ConcreteClass.h"
 #include "vrb/CreationContext.h"
 #include "vrb/LoaderThread.h"
+#include "vrb/Logger.h"
 #include <vrb/Mutex.h>
+#include "vrb/ProgramBinaryCache.h"
 #include "vrb/ResourceGL.h"
 #include "vrb/private/ResourceGLState.h"
+#include "vrb/UniformBuffer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <vrb/Program.h>
 #include <vrb/GLError.h>
 #include <vrb/ShaderUtil.h>
 
+#include <cstring>
+
+namespace {
+
+// Preamble lines selecting a shader variant. Each feature has one literal per value, so
+// a variant is assembled from static strings without any formatting or copies.
+const char* kUseTextureDefine[] = {"#define VRB_USE_TEXTURE 0\n", "#define VRB_USE_TEXTURE 1\n"};
+const char* kUVTypeDefine[] = {"#define VRB_UV_TYPE vec2\n", "#define VRB_UV_TYPE vec3\n"};
+const char* kUVTransformDefine[] = {"#define VRB_UV_TRANSFORM 0\n", "#define VRB_UV_TRANSFORM 1\n"};
+const char* kVertexColorDefine[] = {"#define VRB_VERTEX_COLOR 0\n", "#define VRB_VERTEX_COLOR 1\n"};
+const char* kUniformBlocksDefine[] = {"#define VRB_UNIFORM_BLOCKS 0\n", "#define VRB_UNIFORM_BLOCKS 1\n"};
+const char* kMultiviewDefine[] = {"#define VRB_MULTIVIEW 0\n", "#define VRB_MULTIVIEW 1\n"};
+const char* kTextureArrayDefine[] = {"#define VRB_TEXTURE_ARRAY 0\n", "#define VRB_TEXTURE_ARRAY 1\n"};
+const char* kLowPrecisionDefine = "#define VRB_FRAGMENT_PRECISION lowp\n";
+const char* kMediumPrecisionDefine = "#define VRB_FRAGMENT_PRECISION mediump\n";
+const char* kHighPrecisionDefine = "#define VRB_FRAGMENT_PRECISION highp\n";
+#if defined(ANDROID)
+const char* kExternalImageExtension[] = {"#extension GL_OES_EGL_image_external : require\n",
+                                         "#extension GL_OES_EGL_image_external_essl3 : require\n"};
+#endif // defined(ANDROID)
+
+// Built-in programs with a feature mask below this size are found in a table that is
+// read without locking. Other programs are found in a map guarded by a mutex.
+const uint32_t kFeatureTableSize = 0x1 << 12;
+
+// Shader source passed to glShaderSource as a list of null terminated strings.
+struct ShaderSource {
+  static const GLsizei kMaxStrings = 12;
+  const char* strings[kMaxStrings];
+  GLsizei count;
+  ShaderSource() : count(0) {}
+  void Append(const char* aString) {
+    if (count >= kMaxStrings) {
+      VRB_ERROR("Too many strings in shader source");
+      return;
+    }
+    strings[count++] = aString;
+  }
+  std::string Join() const {
+    std::string result;
+    for (GLsizei ix = 0; ix < count; ix++) {
+      result += strings[ix];
+    }
+    return result;
+  }
+};
+
+// Custom fragment shaders start with "#version 100", the version comes from the header.
+const char*
+SkipVersionLine(const char* aSource) {
+  const char* result = aSource;
+  while ((*result == ' ') || (*result == '\t') || (*result == '\n') || (*result == '\r')) {
+    result++;
+  }
+  if (strncmp(result, "#version", 8) != 0) {
+    return aSource;
+  }
+  const char* end = strchr(result, '\n');
+  return end ? end + 1 : result + strlen(result);
+}
+
+// Returns the first line of aSource after its leading #extension, comment and blank lines.
+const char*
+SkipExtensionLines(const char* aSource) {
+  const char* result = aSource;
+  while (*result) {
+    const char* line = result;
+    while ((*line == ' ') || (*line == '\t')) {
+      line++;
+    }
+    const bool kSkip = (*line == '\n') || (*line == '\r') || (strncmp(line, "#extension", 10) == 0) || (strncmp(line, "//", 2) == 0);
+    if (!kSkip) {
+      break;
+    }
+    const char* end = strchr(line, '\n');
+    result = end ? end + 1 : line + strlen(line);
+  }
+  return result;
+}
+
+}
+
 namespace vrb {
 
 class ProgramBuilder;
 typedef std::shared_ptr<ProgramBuilder> ProgramBuilderPtr;
 
+// Context capabilities shared by the factory and all of its builders. They are read
+// when a builder compiles, which may happen after the builder was created.
+struct ProgramSettings {
+  std::atomic<bool> uniformBlocks;
+  std::atomic<bool> parallelCompile;
+  // Null when program binaries are not supported. Access with std::atomic_load/store.
+  ProgramBinaryCachePtr binaryCache;
+  // Builders waiting for a parallel compile to finish. The builders are owned by the
+  // ProgramFactory for its whole lifetime.
+  Mutex pendingLock;
+  std::vector<ProgramBuilder*> pending;
+  ProgramSettings() : uniformBlocks(false), parallelCompile(false) {}
+  void AddPending(ProgramBuilder* aBuilder) {
+    MutexAutoLock lock(pendingLock);
+    pending.push_back(aBuilder);
+  }
+  void RemovePending(ProgramBuilder* aBuilder) {
+    MutexAutoLock lock(pendingLock);
+    pending.erase(std::remove(pending.begin(), pending.end(), aBuilder), pending.end());
+  }
+};
+typedef std::shared_ptr<ProgramSettings> ProgramSettingsPtr;
+
 class ProgramBuilder : public ResourceGL {
 public:
-  static ProgramBuilderPtr Create(LoaderThreadWeak aLoader);
+  static ProgramBuilderPtr Create(LoaderThreadWeak aLoader, const ProgramSettingsPtr& aSettings);
 
   ProgramPtr GetProgram();
+  uint32_t GetFeatureMask() const;
+  const std::string& GetCustomFragmentShader() const;
   void SetFeatures(const uint32_t aFeatureMask, const std::string& aCustomFragShader);
   void Finalize();
+  // Finishes a parallel compile once the driver reports completion. Returns false
+  // while the program is still being compiled.
+  bool Poll();
 
   // ResourceGL Interface
   bool SupportOffRenderThreadInitialization() override;
+  Priority GetInitializationPriority() override;
   void InitializeGL() override;
   void ShutdownGL() override;
 
@@ -48,40 +165,58 @@ private:
 
 struct ProgramBuilder::State : public ResourceGL::State {
   LoaderThreadWeak loaderHandle;
+  ProgramSettingsPtr settings;
   ProgramPtr program;
   uint32_t featureMask;
   std::string customFragmentShader;
   GLuint vertexShader;
   GLuint fragmentShader;
   GLuint programHandle;
-
-  State() : program(Program::Create()), featureMask(0), vertexShader(0), fragmentShader(0), programHandle(0) {}
-  bool IsTexturingEnabled() { return (featureMask & (FeatureTexture | FeatureCubeTexture | FeatureSurfaceTexture)) != 0; }
+  bool uniformBlocks;
+  bool multiview;
+  bool pending;
+  // Sources of the variant, kept until the link result has been checked.
+  ShaderSource vertexSource;
+  ShaderSource fragmentSource;
+  // Leading #extension lines of a custom fragment shader, patched for GLSL ES 3.00.
+  std::string customFragmentExtensions;
+
+  State()
+      : program(Program::Create())
+      , featureMask(0)
+      , vertexShader(0)
+      , fragmentShader(0)
+      , programHandle(0)
+      , uniformBlocks(false)
+      , multiview(false)
+      , pending(false)
+  {}
+  bool LoadProgramBinary();
+  void StoreProgramBinary();
+  bool CheckLinkStatus();
+  void FinishProgram();
+  bool IsTexturingEnabled() { return (featureMask & (FeatureTexture | FeatureCubeTexture | FeatureSurfaceTexture | FeatureTextureArray)) != 0; }
   bool IsCubeMapTextureEnabled() { return (featureMask & FeatureCubeTexture) != 0; }
+  bool IsTextureArrayEnabled() { return (featureMask & FeatureTextureArray) != 0; }
   bool IsSurfaceTextureEnabled() { return (featureMask & FeatureSurfaceTexture) != 0;}
-  std::string GetFragmentShader(const std::string& aSource) {
-    const std::string kPrecisionMacro("VRB_FRAGMENT_PRECISION");
-    std::string result = aSource;
-    const size_t kUVStart = result.find(kPrecisionMacro);
-    if (kUVStart != std::string::npos) {
-      const char * precision;
-      if ((featureMask & FeatureHighPrecision) != 0) {
-        precision = "highp";
-      } else if ((featureMask & FeatureLowPrecision) != 0) {
-        precision = "lowp";
-      } else {
-        precision = "mediump";
-      }
-      result.replace(kUVStart, kPrecisionMacro.length(), precision);
+  const char* GetPrecisionDefine() const {
+    if ((featureMask & FeatureHighPrecision) != 0) {
+      return kHighPrecisionDefine;
+    } else if ((featureMask & FeatureLowPrecision) != 0) {
+      return kLowPrecisionDefine;
     }
-    return result;
+    return kMediumPrecisionDefine;
+  }
+  std::string GetBinaryKey() const {
+    return vertexSource.Join() + '\0' + fragmentSource.Join();
   }
 };
 
 ProgramBuilderPtr
-ProgramBuilder::Create(LoaderThreadWeak aLoader) {
+ProgramBuilder::Create(LoaderThreadWeak aLoader, const ProgramSettingsPtr& aSettings) {
   ProgramBuilderPtr result = std::make_shared<ConcreteClass<ProgramBuilder, ProgramBuilder::State> >();
   result->m.loaderHandle = aLoader;
+  result->m.settings = aSettings;
   return result;
 }
 
@@ -91,11 +226,21 @@ ProgramBuilder::GetProgram() {
   return m.program;
 }
 
+uint32_t
+ProgramBuilder::GetFeatureMask() const {
+  return m.featureMask;
+}
+
+const std::string&
+ProgramBuilder::GetCustomFragmentShader() const {
+  return m.customFragmentShader;
+}
+
 void
 ProgramBuilder::SetFeatures(const uint32_t aFeatureMask, const std::string& aCustomFragShader) {
-  m.featureMask = aFeatureMask;
+  m.featureMask = aFeatureMask & ~FeatureUniformBlocks;
   m.customFragmentShader = aCustomFragShader;
-  m.program->SetFeatures(aFeatureMask);
+  m.program->SetFeatures(m.featureMask);
 }
 
 
@@ -107,74 +252,196 @@ ProgramBuilder::Finalize() {
   m.program->SetProgram(m.programHandle);
 }
 
+bool
+ProgramBuilder::Poll() {
+  if (!m.pending) {
+    return true;
+  }
+  GLint completed = GL_FALSE;
+  VRB_GL_CHECK(glGetProgramiv(m.programHandle, GL_COMPLETION_STATUS_KHR, &completed));
+  if (completed == GL_FALSE) {
+    return false;
+  }
+  m.pending = false;
+  m.CheckLinkStatus();
+  m.FinishProgram();
+  Finalize();
+  return true;
+}
+
 bool
 ProgramBuilder::SupportOffRenderThreadInitialization() { return true; }
 
+// Nothing using the program can be drawn until it is built.
+ResourceGL::Priority
+ProgramBuilder::GetInitializationPriority() { return Priority::High; }
+
 void
 ProgramBuilder::InitializeGL() {
-  std::string vertexShaderSource = GetVertexShaderSource();
-  const std::string kTextureUVMacro("VRB_TEXTURE_UV_TYPE");
-  const size_t kUVStart = vertexShaderSource.find(kTextureUVMacro);
-  if (kUVStart != std::string::npos) {
-    vertexShaderSource.replace(kUVStart, kTextureUVMacro.length(), m.IsCubeMapTextureEnabled() ? "vec3" : "vec2");
-  }
-
-  const std::string kUVTransformMacro("VRB_UV_TRANSFORM_ENABLED");
-  const size_t kUVTransformStart = vertexShaderSource.find(kUVTransformMacro);
-  if (kUVTransformStart != std::string::npos) {
-    vertexShaderSource.replace(kUVTransformStart, kUVTransformMacro.length(), (m.featureMask & FeatureUVTransform) != 0 ? "1" : "0");
-  }
-
-  const std::string kVertexColorMacro("VRB_VERTEX_COLOR_ENABLED");
-  const size_t kVertexColorStart = vertexShaderSource.find(kVertexColorMacro);
-  if (kVertexColorStart != std::string::npos) {
-    vertexShaderSource.replace(kVertexColorStart, kVertexColorMacro.length(), (m.featureMask & FeatureVertexColor) != 0 ? "1" : "0");
+  // Custom fragment shaders are written against GLSL ES 1.00 so they keep the classic uniforms,
+  // unless a multiview or texture array variant is requested which is always GLSL ES 3.00.
+  // Multiview variants only exist while multiview is enabled, see SetMultiviewEnabled().
+  const bool kMultiview = (m.featureMask & FeatureMultiview) != 0;
+  const bool kTextureArray = m.IsTextureArrayEnabled();
+  const bool kUniformBlocks = kMultiview || kTextureArray || (m.settings->uniformBlocks && m.customFragmentShader.empty());
+  const bool kCubeMap = m.IsCubeMapTextureEnabled();
+
+  ShaderSource& vertex = m.vertexSource;
+  vertex = ShaderSource();
+  if (kUniformBlocks) {
+    vertex.Append(kMultiview ? GetVertexShaderMultiviewHeader() : GetVertexShaderES3Header());
+  } else {
+    vertex.Append(GetShaderES2Header());
   }
-
-  const std::string kTextureMacro("VRB_TEXTURE_STATE");
-  const size_t kStart = vertexShaderSource.find(kTextureMacro);
-  if (m.IsTexturingEnabled()) {
-    if(kStart != std::string::npos) {
-      vertexShaderSource.replace(kStart, kTextureMacro.length(), "1");
+  vertex.Append(kUseTextureDefine[m.IsTexturingEnabled() ? 1 : 0]);
+  vertex.Append(kUVTypeDefine[(kCubeMap || kTextureArray) ? 1 : 0]);
+  vertex.Append(kUVTransformDefine[(m.featureMask & FeatureUVTransform) != 0 ? 1 : 0]);
+  vertex.Append(kVertexColorDefine[(m.featureMask & FeatureVertexColor) != 0 ? 1 : 0]);
+  vertex.Append(kUniformBlocksDefine[kUniformBlocks ? 1 : 0]);
+  vertex.Append(kMultiviewDefine[kMultiview ? 1 : 0]);
+  vertex.Append(kTextureArrayDefine[kTextureArray ? 1 : 0]);
+  vertex.Append(GetVertexShaderSource());
+
+  ShaderSource& fragment = m.fragmentSource;
+  fragment = ShaderSource();
+  // Extension directives go straight after the #version line, before any define or
+  // declaration.
+  fragment.Append(kUniformBlocks ? GetFragmentShaderES3Header() : GetShaderES2Header());
+  const char* body = GetFragmentShaderSource();
+  if (!m.customFragmentShader.empty()) {
+    const char* custom = SkipVersionLine(m.customFragmentShader.c_str());
+    body = SkipExtensionLines(custom);
+    m.customFragmentExtensions.assign(custom, body);
+    const char* kExternalImage = "GL_OES_EGL_image_external ";
+    const size_t kExternalImageIndex = m.customFragmentExtensions.find(kExternalImage);
+    if (kUniformBlocks && (kExternalImageIndex != std::string::npos)) {
+      m.customFragmentExtensions.replace(kExternalImageIndex, strlen(kExternalImage), "GL_OES_EGL_image_external_essl3 ");
     }
-    m.vertexShader = LoadShader(GL_VERTEX_SHADER, vertexShaderSource.c_str());
-    std::string frag = m.GetFragmentShader(GetFragmentTextureShaderSource());
-    if (m.IsCubeMapTextureEnabled()) {
-      frag = m.GetFragmentShader(GetFragmentCubeMapTextureShaderSource());
+    fragment.Append(m.customFragmentExtensions.c_str());
+  } else if (m.IsTexturingEnabled()) {
+    body = kCubeMap ? GetFragmentCubeMapTextureShaderSource() : GetFragmentTextureShaderSource();
+    if (kTextureArray) {
+      body = GetFragmentTextureArrayShaderSource();
     }
 #if defined(ANDROID)
     // SurfaceTexture requires usage of fragment shader extension.
     if (m.IsSurfaceTextureEnabled()) {
-      frag = m.GetFragmentShader(GetFragmentSurfaceTextureShaderSource());
+      fragment.Append(kExternalImageExtension[kUniformBlocks ? 1 : 0]);
+      body = GetFragmentSurfaceTextureShaderSource();
     }
 #endif // defined(ANDROID)
-    if (!m.customFragmentShader.empty()) {
-      frag = m.GetFragmentShader(m.customFragmentShader);
+  }
+  if (kUniformBlocks) {
+    fragment.Append(GetFragmentShaderES3Prologue());
+  }
+  fragment.Append(m.GetPrecisionDefine());
+  fragment.Append(body);
+  m.uniformBlocks = kUniformBlocks;
+  m.multiview = kMultiview;
+
+  LoaderThreadPtr loader = m.loaderHandle.lock();
+  const bool kOnLoaderThread = loader && loader->IsOnLoaderThread();
+  if (!m.LoadProgramBinary()) {
+    // Submit both shaders and the link before querying any status, querying forces
+    // the driver to wait for the compile.
+    m.vertexShader = CompileShader(GL_VERTEX_SHADER, vertex.count, vertex.strings);
+    m.fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragment.count, fragment.strings);
+    if (m.vertexShader && m.fragmentShader) {
+      m.programHandle = LinkProgram(m.vertexShader, m.fragmentShader);
+    }
+    if (m.programHandle && !kOnLoaderThread && m.settings->parallelCompile) {
+      // Finished by Poll() from ProgramFactory::UpdatePendingPrograms().
+      m.pending = true;
+      m.settings->AddPending(this);
+      return;
     }
-    m.fragmentShader = LoadShader(GL_FRAGMENT_SHADER, frag.c_str());
+    m.CheckLinkStatus();
+  }
+  m.FinishProgram();
+
+  if (!kOnLoaderThread) {
+    Finalize();
+  }
+}
+
+bool
+ProgramBuilder::State::LoadProgramBinary() {
+  ProgramBinaryCachePtr cache = std::atomic_load(&settings->binaryCache);
+  if (!cache) {
+    return false;
+  }
+  // The final sources identify the variant, so edited shaders never match old binaries.
+  const std::string key = GetBinaryKey();
+  GLenum format = 0;
+  std::unique_ptr<uint8_t[]> binary;
+  size_t size = 0;
+  if (!cache->Load(key, format, binary, size)) {
+    return false;
+  }
+  programHandle = CreateProgramFromBinary(format, binary.get(), (GLsizei)size);
+  if (!programHandle) {
+    VRB_LOG("Program binary rejected by driver, recompiling");
+    cache->Remove(key);
+    return false;
+  }
+  return true;
+}
+
+void
+ProgramBuilder::State::StoreProgramBinary() {
+  ProgramBinaryCachePtr cache = std::atomic_load(&settings->binaryCache);
+  if (!cache) {
+    return;
+  }
+  GLenum format = 0;
+  std::unique_ptr<uint8_t[]> binary;
+  GLsizei length = 0;
+  if (GetProgramBinary(programHandle, format, binary, length)) {
+    cache->Store(GetBinaryKey(), format, binary.get(), (size_t)length);
+  }
+}
+
+bool
+ProgramBuilder::State::CheckLinkStatus() {
+  bool linked = programHandle && CheckProgramLinked(programHandle);
+  if (linked) {
+    StoreProgramBinary();
   } else {
-    if(kStart != std::string::npos) {
-      vertexShaderSource.replace(kStart, kTextureMacro.length(), "0");
+    if (vertexShader) {
+      CheckShaderCompiled(vertexShader, vertexSource.Join().c_str());
     }
-    m.vertexShader = LoadShader(GL_VERTEX_SHADER, vertexShaderSource.c_str());
-    std::string frag = m.GetFragmentShader(GetFragmentShaderSource());
-    if (!m.customFragmentShader.empty()) {
-      frag = m.GetFragmentShader(m.customFragmentShader);
+    if (fragmentShader) {
+      CheckShaderCompiled(fragmentShader, fragmentSource.Join().c_str());
+    }
+    if (programHandle) {
+      VRB_GL_CHECK(glDeleteProgram(programHandle));
+      programHandle = 0;
     }
-    m.fragmentShader = LoadShader(GL_FRAGMENT_SHADER, frag.c_str());
-  }
-  if (m.fragmentShader && m.vertexShader) {
-    m.programHandle = CreateProgram(m.vertexShader, m.fragmentShader);
   }
+  return linked;
+}
 
-  LoaderThreadPtr loader = m.loaderHandle.lock();
-  if (!loader || !loader->IsOnLoaderThread() ) {
-    Finalize();
+void
+ProgramBuilder::State::FinishProgram() {
+  vertexSource = ShaderSource();
+  fragmentSource = ShaderSource();
+  customFragmentExtensions.clear();
+  if (programHandle && uniformBlocks) {
+    BindUniformBlock(programHandle, "vrb_Camera", multiview ? VRB_MULTIVIEW_CAMERA_BLOCK_BINDING : VRB_CAMERA_BLOCK_BINDING);
+    BindUniformBlock(programHandle, "vrb_Lights", VRB_LIGHTS_BLOCK_BINDING);
+    BindUniformBlock(programHandle, "vrb_Material", VRB_MATERIAL_BLOCK_BINDING);
+    program->SetFeatures(featureMask | FeatureUniformBlocks);
+  } else {
+    program->SetFeatures(featureMask);
   }
 }
 
 void
 ProgramBuilder::ShutdownGL() {
+  if (m.pending) {
+    m.settings->RemovePending(this);
+    m.pending = false;
+  }
   if (m.programHandle) {
     VRB_GL_CHECK(glDeleteProgram(m.programHandle));
     m.programHandle = 0;
@@ -196,8 +463,59 @@ ProgramBuilder::ProgramBuilder(State& aState) : ResourceGL(aState), m(aState) {}
 
 struct ProgramFactory::State {
   Mutex lock;
-  std::unordered_map<std::string, ProgramBuilderPtr> programs;
+  // Built-in programs indexed by feature mask. Entries are only written with lock held
+  // and never change once set, so lookups do not lock.
+  std::unique_ptr<std::atomic<ProgramBuilder*>[]> builtinPrograms;
+  // Programs with a custom fragment shader or a feature mask outside of the table,
+  // keyed by a hash of both. Guarded by lock.
+  std::unordered_map<size_t, std::vector<ProgramBuilder*>> customPrograms;
+  // Owns every builder. Guarded by lock.
+  std::vector<ProgramBuilderPtr> builders;
+  std::unordered_map<GLuint, UniformBufferPtr> sharedUniformBuffers;
   LoaderThreadWeak loader;
+  ProgramSettingsPtr settings;
+  std::atomic<bool> multiview;
+  State()
+      : builtinPrograms(new std::atomic<ProgramBuilder*>[kFeatureTableSize])
+      , settings(std::make_shared<ProgramSettings>())
+      , multiview(false)
+  {
+    for (uint32_t ix = 0; ix < kFeatureTableSize; ix++) {
+      builtinPrograms[ix].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+  static bool IsBuiltin(const uint32_t aFeatureMask, const std::string& aCustomFragShader) {
+    return aCustomFragShader.empty() && (aFeatureMask < kFeatureTableSize);
+  }
+  static size_t CustomKey(const uint32_t aFeatureMask, const std::string& aCustomFragShader) {
+    return std::hash<std::string>()(aCustomFragShader) ^ ((size_t)aFeatureMask * 0x9e3779b9);
+  }
+  // Must be called with lock held.
+  ProgramBuilder* Find(const uint32_t aFeatureMask, const std::string& aCustomFragShader) {
+    if (IsBuiltin(aFeatureMask, aCustomFragShader)) {
+      return builtinPrograms[aFeatureMask].load(std::memory_order_acquire);
+    }
+    auto found = customPrograms.find(CustomKey(aFeatureMask, aCustomFragShader));
+    if (found == customPrograms.end()) {
+      return nullptr;
+    }
+    for (ProgramBuilder* builder: found->second) {
+      if ((builder->GetFeatureMask() == (aFeatureMask & ~FeatureUniformBlocks)) &&
+          (builder->GetCustomFragmentShader() == aCustomFragShader)) {
+        return builder;
+      }
+    }
+    return nullptr;
+  }
+  // Must be called with lock held.
+  void Add(const uint32_t aFeatureMask, const std::string& aCustomFragShader, const ProgramBuilderPtr& aBuilder) {
+    builders.push_back(aBuilder);
+    if (IsBuiltin(aFeatureMask, aCustomFragShader)) {
+      builtinPrograms[aFeatureMask].store(aBuilder.get(), std::memory_order_release);
+    } else {
+      customPrograms[CustomKey(aFeatureMask, aCustomFragShader)].push_back(aBuilder.get());
+    }
+  }
 };
 
 ProgramFactoryPtr
@@ -220,47 +538,119 @@ ProgramFactory::CreateProgram(CreationContextPtr& aContext, uint32_t aFeatureMas
 ProgramPtr
 ProgramFactory::CreateProgram(CreationContextPtr& aContext, const uint32_t aFeatureMask,
                               const std::string& aCustomFragShader) {
-  const std::string key = std::to_string(aFeatureMask) + aCustomFragShader;
-  ProgramBuilderPtr builder;
-  bool created = false;
-  {
+  ProgramBuilder* builder = nullptr;
+  if (State::IsBuiltin(aFeatureMask, aCustomFragShader)) {
+    builder = m.builtinPrograms[aFeatureMask].load(std::memory_order_acquire);
+  }
+  ProgramBuilderPtr created;
+  if (!builder) {
     MutexAutoLock lock(m.lock);
-
-    auto found = m.programs.find(key);
-    if (found == m.programs.end()) {
-      builder = ProgramBuilder::Create(m.loader);
-      builder->SetFeatures(aFeatureMask, aCustomFragShader);
-      m.programs[key] = builder;
-      created = true;
-    } else {
-      builder = found->second;
+    builder = m.Find(aFeatureMask, aCustomFragShader);
+    if (!builder) {
+      created = ProgramBuilder::Create(m.loader, m.settings);
+      created->SetFeatures(aFeatureMask, aCustomFragShader);
+      m.Add(aFeatureMask, aCustomFragShader, created);
+      builder = created.get();
     }
   }
 
   if (created) {
     LoaderThreadPtr loader = m.loader.lock();
     if (loader) {
-      LoadFinishedCallback finished = [builder](GroupPtr&) {
-        builder->Finalize();
+      LoadFinishedCallback finished = [created](GroupPtr&) {
+        created->Finalize();
       };
       if (loader->IsOnLoaderThread()) {
         loader->AddFinishedCallback(finished);
-        aContext->AddResourceGL(builder.get());
+        aContext->AddResourceGL(created.get());
       } else {
 
-        LoadTask task = [builder](CreationContextPtr& aContext) -> GroupPtr {
-          aContext->AddResourceGL(builder.get());
+        LoadTask task = [created](CreationContextPtr& aContext) -> GroupPtr {
+          aContext->AddResourceGL(created.get());
           return nullptr;
         };
 
         loader->RunLoadTask(nullptr, task, finished);
       }
     } else {
-      aContext->AddResourceGL(builder.get());
+      aContext->AddResourceGL(created.get());
     }
   }
 
-  return builder->GetProgram();
+  ProgramPtr result = builder->GetProgram();
+  if (m.multiview && ((aFeatureMask & FeatureMultiview) == 0) && !result->GetMultiviewVariant()) {
+    result->SetMultiviewVariant(CreateProgram(aContext, aFeatureMask | FeatureMultiview, aCustomFragShader));
+  }
+  return result;
+}
+
+void
+ProgramFactory::PreloadPrograms(CreationContextPtr& aContext, const std::vector<uint32_t>& aFeatureMasks) {
+  for (const uint32_t mask: aFeatureMasks) {
+    CreateProgram(aContext, mask);
+  }
+}
+
+void
+ProgramFactory::SetUniformBlocksSupported(const bool aSupported) {
+  m.settings->uniformBlocks = aSupported;
+}
+
+void
+ProgramFactory::SetParallelCompileSupported(const bool aSupported) {
+  m.settings->parallelCompile = aSupported;
+}
+
+int32_t
+ProgramFactory::UpdatePendingPrograms() {
+  ProgramSettings& settings = *m.settings;
+  MutexAutoLock lock(settings.pendingLock);
+  auto done = std::remove_if(settings.pending.begin(), settings.pending.end(), [](ProgramBuilder* aBuilder) {
+    return aBuilder->Poll();
+  });
+  settings.pending.erase(done, settings.pending.end());
+  return (int32_t)settings.pending.size();
+}
+
+void
+ProgramFactory::SetProgramBinaryCache(const ProgramBinaryCachePtr& aCache) {
+  std::atomic_store(&m.settings->binaryCache, aCache);
+}
+
+bool
+ProgramFactory::SetMultiviewEnabled(CreationContextPtr& aContext, const bool aEnabled) {
+  if (aEnabled && !m.settings->uniformBlocks) {
+    VRB_WARN("Unable to enable multiview programs without GLSL ES 3.00");
+    return false;
+  }
+  std::vector<ProgramBuilderPtr> builders;
+  {
+    MutexAutoLock lock(m.lock);
+    m.multiview = aEnabled;
+    if (!aEnabled) {
+      return true;
+    }
+    builders = m.builders;
+  }
+  for (ProgramBuilderPtr& builder: builders) {
+    if ((builder->GetFeatureMask() & FeatureMultiview) == 0) {
+      CreateProgram(aContext, builder->GetFeatureMask(), builder->GetCustomFragmentShader());
+    }
+  }
+  return true;
+}
+
+UniformBufferPtr
+ProgramFactory::GetSharedUniformBuffer(CreationContextPtr& aContext, const GLuint aBindingPoint, const GLsizeiptr aSize) {
+  MutexAutoLock lock(m.lock);
+  UniformBufferPtr& result = m.sharedUniformBuffers[aBindingPoint];
+  if (!result) {
+    result = UniformBuffer::Create(aContext, aSize);
+  } else if (result->GetSize() != aSize) {
+    VRB_ERROR("Shared uniform buffer for binding point %u requested with size %d, expected %d",
+              aBindingPoint, (int)aSize, (int)result->GetSize());
+  }
+  return result;
 }
 
 ProgramFactory::ProgramFactory(State& aState) : m(aState) {}
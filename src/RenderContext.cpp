@@ -19,12 +19,16 @@
 #include "vrb/DataCache.h"
 #include "vrb/GLExtensions.h"
 #include "vrb/Logger.h"
+#include "vrb/ProgramBinaryCache.h"
 #include "vrb/ProgramFactory.h"
 #include "vrb/ResourceGL.h"
 #if defined(ANDROID)
 #  include "vrb/SurfaceTextureFactory.h"
 #endif // defined(ANDROID)
 #include "vrb/TextureCache.h"
+#include "vrb/TextureGL.h"
+#include "vrb/TextureStreamer.h"
+#include "vrb/TextureUploadQueue.h"
 #include "vrb/ThreadIdentity.h"
 #include "vrb/Updatable.h"
 #if defined(ANDROID)
@@ -36,6 +40,15 @@
 
 namespace {
 const double kNanosecondsToSeconds = 1.0e9;
+
+double
+GetMonotonicTime() {
+  timespec spec = {};
+  if (clock_gettime(CLOCK_MONOTONIC, &spec) != 0) {
+    return 0.0;
+  }
+  return (double)spec.tv_sec + (spec.tv_nsec / kNanosecondsToSeconds);
+}
 }
 
 namespace vrb {
@@ -43,8 +56,11 @@ namespace vrb {
 struct RenderContext::State {
   ThreadIdentityPtr threadSelf;
   TextureCachePtr textureCache;
+  TextureStreamerPtr textureStreamer;
+  TextureUploadQueuePtr textureUploadQueue;
   ProgramFactoryPtr programFactory;
   DataCachePtr dataCache;
+  ProgramBinaryCachePtr programBinaryCache;
   CreationContextPtr creationContext;
   GLExtensionsPtr glExtensions;
 #if defined(ANDROID)
@@ -57,11 +73,15 @@ struct RenderContext::State {
 #endif // defined(ANDROID)
   UpdatableList updatables;
   ResourceGLList uninitializedResources;
+  // Uninitialized resources sorted by ResourceGL::Priority.
+  ResourceGLList pendingResources[3];
   ResourceGLList resources;
+  double initializationBudget;
   std::vector<ContextSynchronizerPtr> synchronizers;
   double timestamp;
   double frameDelta;
   State();
+  void InitializeResources();
 };
 
 RenderContext::State::State()
@@ -71,17 +91,43 @@ RenderContext::State::State()
 #endif // defined(ANDROID)
     , dataCache(DataCache::Create())
     , textureCache(TextureCache::Create())
+    , textureStreamer(TextureStreamer::Create())
+    , textureUploadQueue(TextureUploadQueue::Create())
     , programFactory(ProgramFactory::Create())
+    , initializationBudget(0.0)
     , timestamp(0.0)
     , frameDelta(0.0)
 {}
 
+void
+RenderContext::State::InitializeResources() {
+  while (ResourceGL* resource = uninitializedResources.RemoveFirst()) {
+    pendingResources[(size_t)resource->GetInitializationPriority()].Append(resource);
+  }
+  const double start = GetMonotonicTime();
+  for (ResourceGLList& list: pendingResources) {
+    while (ResourceGL* resource = list.RemoveFirst()) {
+      resource->InitializeGL();
+      resources.Append(resource);
+      if ((initializationBudget > 0.0) && ((GetMonotonicTime() - start) >= initializationBudget)) {
+        return;
+      }
+    }
+  }
+}
+
 RenderContextPtr
 RenderContext::Create() {
   RenderContextPtr result = std::make_shared<ConcreteClass<RenderContext, RenderContext::State> >();
   result->m.creationContext = CreationContext::Create(result);
   result->m.creationContext->BindToThread();
   result->m.textureCache->Init(result->m.creationContext);
+  // The default texture is shown while other textures upload, so it never queues or streams.
+  TextureGLPtr placeholder = result->m.textureCache->GetDefaultTexture();
+  placeholder->SetUploadQueue(nullptr);
+  placeholder->SetTextureStreamer(nullptr);
+  result->m.textureUploadQueue->SetPlaceholder(placeholder);
+  result->m.programBinaryCache = ProgramBinaryCache::Create(result->m.dataCache);
   result->m.glExtensions = GLExtensions::Create(result);
 #if defined(ANDROID)
   result->m.surfaceTextureFactory = SurfaceTextureFactory::Create(result->m.creationContext);
@@ -128,13 +174,51 @@ RenderContext::InitializeGL() {
   }
   m.eglContext = current;
 #endif // defined(ANDROID)
-  m.resources.InitializeGL();
   m.glExtensions->Initialize();
+  m.programFactory->SetUniformBlocksSupported(m.glExtensions->IsGLES3Supported());
+  const bool kParallelCompile = m.glExtensions->IsExtensionSupported(GLExtensions::Ext::KHR_parallel_shader_compile);
+  if (kParallelCompile && m.glExtensions->GetFunctions().glMaxShaderCompilerThreadsKHR) {
+    // Let the driver pick the number of compiler threads.
+    m.glExtensions->GetFunctions().glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+  m.programFactory->SetParallelCompileSupported(kParallelCompile);
+  GLint binaryFormats = 0;
+  if (m.glExtensions->IsGLES3Supported()) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+  }
+  if (binaryFormats > 0) {
+    std::string driver;
+    for (const GLenum name: {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+      const char* value = (const char*)glGetString(name);
+      driver += value ? value : "";
+      driver += "\n";
+    }
+    m.programBinaryCache->SetDriverIdentity(driver);
+    m.programFactory->SetProgramBinaryCache(m.programBinaryCache);
+  } else {
+    m.programFactory->SetProgramBinaryCache(nullptr);
+  }
+  m.textureStreamer->InitializeGL(m.glExtensions->IsGLES3Supported());
+  m.textureUploadQueue->InitializeGL(m.glExtensions->IsGLES3Supported());
+#if !defined(ANDROID)
+  m.fileReader->SetTranscodeTarget(ImageTranscoder::SelectTarget(*m.glExtensions));
+#endif // !defined(ANDROID)
+  m.resources.InitializeGL();
   return true;
 }
 
+bool
+RenderContext::SetMultiviewEnabled(const bool aEnabled) {
+  if (aEnabled && !m.glExtensions->IsExtensionSupported(GLExtensions::Ext::OVR_multiview2)) {
+    VRB_WARN("Unable to enable multiview rendering: OVR_multiview2 not supported");
+    return false;
+  }
+  return m.programFactory->SetMultiviewEnabled(m.creationContext, aEnabled);
+}
+
 void
 RenderContext::ShutdownGL() {
+  m.textureUploadQueue->ShutdownGL();
   m.resources.ShutdownGL();
 }
 
@@ -158,12 +242,28 @@ RenderContext::Update() {
       iter++;
     }
   }
-  if (m.uninitializedResources.Update()) {
-    m.resources.AppendAndAdoptList(m.uninitializedResources);
-  }
+  m.InitializeResources();
+  m.programFactory->UpdatePendingPrograms();
+  m.textureStreamer->Update();
+  m.textureUploadQueue->Update();
+  m.textureCache->Update();
   m.updatables.UpdateResource(*this);
 }
 
+void
+RenderContext::SetResourceInitializationBudget(const double aSeconds) {
+  m.initializationBudget = aSeconds;
+}
+
+uint32_t
+RenderContext::GetPendingResourceCount() const {
+  uint32_t result = m.uninitializedResources.GetCount();
+  for (const ResourceGLList& list: m.pendingResources) {
+    result += list.GetCount();
+  }
+  return result;
+}
+
 double
 RenderContext::GetTimestamp() {
   return m.timestamp;
@@ -189,6 +289,16 @@ RenderContext::GetTextureCache() {
   return m.textureCache;
 }
 
+TextureStreamerPtr&
+RenderContext::GetTextureStreamer() {
+  return m.textureStreamer;
+}
+
+TextureUploadQueuePtr&
+RenderContext::GetTextureUploadQueue() {
+  return m.textureUploadQueue;
+}
+
 ProgramFactoryPtr&
 RenderContext::GetProgramFactory() {
   return m.programFactory;
@@ -11,33 +11,87 @@
 #include "vrb/ConcreteClass.h"
 #include "vrb/Logger.h"
 #include "vrb/GLError.h"
+#include "vrb/LightSet.h"
 #include "vrb/Matrix.h"
 #include "vrb/Program.h"
 #include "vrb/ShaderUtil.h"
 #include "vrb/Texture.h"
+#include "vrb/UniformBuffer.h"
 #include "vrb/Vector.h"
 
 #include "vrb/gl.h"
+#include <atomic>
+#include <cstring>
 #include <string>
 #include <vector>
+#include <vrb/CreationContext.h>
 #include <vrb/ProgramFactory.h>
 
+namespace {
+
+std::atomic<uint32_t> sLightUploadCount(0);
+std::atomic<uint32_t> sUniformUploadCount(0);
+std::atomic<uint32_t> sUniformSkipCount(0);
+std::atomic<uint32_t> sUniformVersion(0);
+
+// Returns a process wide unique uniform version, never zero.
+uint32_t
+NextUniformVersion() {
+  uint32_t result = ++sUniformVersion;
+  if (result == 0) {
+    result = ++sUniformVersion;
+  }
+  return result;
+}
+
+// std140 layouts of the uniform blocks declared in BasicShaders.
+struct CameraBlock {
+  float perspective[16];
+  float view[16];
+};
+
+struct MultiviewCameraBlock {
+  float perspective[2][16];
+  float view[2][16];
+};
+
+// Names of the u_lights array members, built once.
+struct LightNames {
+  std::string direction[VRB_MAX_LIGHTS];
+  std::string ambient[VRB_MAX_LIGHTS];
+  std::string diffuse[VRB_MAX_LIGHTS];
+  std::string specular[VRB_MAX_LIGHTS];
+  LightNames() {
+    for (int ix = 0; ix < VRB_MAX_LIGHTS; ix++) {
+      const std::string structName = "u_lights[" + std::to_string(ix) + "].";
+      direction[ix] = structName + "direction";
+      ambient[ix] = structName + "ambient";
+      diffuse[ix] = structName + "diffuse";
+      specular[ix] = structName + "specular";
+    }
+  }
+};
+
+const LightNames&
+GetLightNames() {
+  static const LightNames sNames;
+  return sNames;
+}
+
+struct MaterialBlock {
+  float ambient[4];
+  float diffuse[4];
+  float specular[4];
+  float specularExponent;
+  float padding[3];
+  float tintColor[4];
+};
+
+}
+
 namespace vrb {
 
 struct RenderState::State : public ResourceGL::State {
-  struct Light {
-    const Vector direction;
-    const Color ambient;
-    const Color diffuse;
-    const Color specular;
-
-    Light(const Vector& aDirection, const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular)
-        : direction(aDirection)
-        , ambient(aAmbient)
-        , diffuse(aDiffuse)
-        , specular(aSpecular)
-    {}
-  };
   struct ULight {
     GLint direction;
     GLint ambient;
@@ -50,125 +104,289 @@ struct RenderState::State : public ResourceGL::State {
         , specular(0)
     {}
   };
+  // Uniform and attribute locations of one linked program.
+  struct ProgramBinding {
+    ProgramPtr program;
+    bool updateProgram;
+    bool uniformBlocks;
+    bool uvTransformEnabled;
+    bool textureArrayEnabled;
+    GLint uPerspective;
+    GLint uView;
+    GLint uModel;
+    GLint uUVTransform;
+    GLint uTextureLayer;
+    GLint uLightCount;
+    ULight uLights[VRB_MAX_LIGHTS];
+    GLint uMatterialAmbient;
+    GLint uMatterialDiffuse;
+    GLint uMatterialSpecular;
+    GLint uMatterialSpecularExponent;
+    GLint uTexture0;
+    GLint uTintColor;
+    GLint aPosition;
+    GLint aNormal;
+    GLint aUV;
+    GLint aColor;
+
+    ProgramBinding()
+        : updateProgram(true)
+        , uniformBlocks(false)
+        , uvTransformEnabled(false)
+        , textureArrayEnabled(false)
+        , uPerspective(-1)
+        , uView(-1)
+        , uModel(-1)
+        , uUVTransform(-1)
+        , uTextureLayer(-1)
+        , uLightCount(-1)
+        , uMatterialAmbient(-1)
+        , uMatterialDiffuse(-1)
+        , uMatterialSpecular(-1)
+        , uMatterialSpecularExponent(-1)
+        , uTexture0(-1)
+        , uTintColor(-1)
+        , aPosition(-1)
+        , aNormal(-1)
+        , aUV(-1)
+        , aColor(-1)
+    {}
+  };
 
-  ProgramPtr program;
-  bool updateProgram;
-  GLint uPerspective;
-  GLint uView;
-  GLint uModel;
-  GLint uUVTransform;
-  GLint uLightCount;
-  ULight uLights[VRB_MAX_LIGHTS];
-  GLint uMatterialAmbient;
-  GLint uMatterialDiffuse;
-  GLint uMatterialSpecular;
-  GLint uMatterialSpecularExponent;
-  GLint uTexture0;
-  GLint uTintColor;
-  GLint aPosition;
-  GLint aNormal;
-  GLint aUV;
-  GLint aColor;
-  std::vector<Light> lights;
+  ProgramBinding single;
+  ProgramBinding multiview;
+  ProgramBinding* active;
+  LightSet lights;
   Color ambient;
   Color diffuse;
   Color specular;
   float specularExponent;
   TexturePtr texture;
   Color tintColor;
-  uint32_t lightId;
   bool lightsEnabled;
-  bool uvTransformEnabled;
   vrb::Matrix uvTransform;
+  int32_t textureLayer;
   std::string customFragmentShader;
+  UniformBufferPtr cameraBlock;
+  UniformBufferPtr multiviewCameraBlock;
+  UniformBufferPtr lightsBlock;
+  UniformBufferPtr materialBlock;
+  // Bumped whenever the matching uniform group changes. The material block holds both
+  // the material and the tint color so it has a version of its own.
+  uint32_t materialVersion;
+  uint32_t tintVersion;
+  uint32_t uvTransformVersion;
+  uint32_t textureLayerVersion;
+  uint32_t materialBlockVersion;
 
   State()
-      : program(0)
-      , updateProgram(true)
-      , uPerspective(-1)
-      , uView(-1)
-      , uModel(-1)
-      , uUVTransform(-1)
-      , uLightCount(-1)
-      , uMatterialAmbient(-1)
-      , uMatterialDiffuse(-1)
-      , uMatterialSpecular(-1)
-      , uMatterialSpecularExponent(-1)
-      , uTexture0(-1)
-      , uTintColor(-1)
-      , aPosition(-1)
-      , aNormal(-1)
-      , aUV(-1)
-      , aColor(-1)
+      : active(&single)
       , specularExponent(0.0f)
       , ambient(0.5f, 0.5f, 0.5f, 1.0f) // default to gray
       , diffuse(1.0f, 1.0f, 1.0f, 1.0f) // default to white
       , tintColor(1.0f, 1.0f, 1.0f, 1.0f)
-      , lightId(0)
       , lightsEnabled(true)
-      , uvTransformEnabled(false)
       , uvTransform(Matrix::Identity())
-  {}
+      , textureLayer(0)
+  {
+    lights.id = LightSet::NextId();
+    materialVersion = NextUniformVersion();
+    tintVersion = NextUniformVersion();
+    uvTransformVersion = NextUniformVersion();
+    textureLayerVersion = NextUniformVersion();
+    materialBlockVersion = NextUniformVersion();
+  }
 
-  void InitializeProgram();
+  bool EnableProgram(ProgramBinding& aBinding);
+  void InitializeProgram(ProgramBinding& aBinding);
+  bool NeedsUpload(uint32_t& aUploaded, const uint32_t aVersion);
+  void UpdateMatrix(const GLint aLocation, const Matrix& aMatrix, bool& aUploaded, float* aUploadedData);
+  void UpdateUniformBlocks();
+  void UpdateLightUniforms(ProgramBinding& aBinding);
+  void UpdateUniforms(const Matrix& aModel);
 };
 
+bool
+RenderState::State::EnableProgram(ProgramBinding& aBinding) {
+  if (!aBinding.program || !aBinding.program->IsReady()) { return false; }
+  if (!aBinding.program->Enable()) { return false; }
+  if (aBinding.updateProgram) {
+    InitializeProgram(aBinding);
+  }
+  active = &aBinding;
+  return true;
+}
+
 void
-RenderState::State::InitializeProgram() {
+RenderState::State::InitializeProgram(ProgramBinding& aBinding) {
+  ProgramPtr& program = aBinding.program;
   if (!program || program->GetProgram() == 0) {
     return;
   }
   const bool kEnableTexturing = texture != nullptr;
-  uvTransformEnabled = program->SupportsFeatures(FeatureUVTransform);
-
-  uPerspective = program->GetUniformLocation("u_perspective");
-  uView = program->GetUniformLocation("u_view");
-  uModel = program->GetUniformLocation("u_model");
-  uLightCount = program->GetUniformLocation("u_lightCount");
-  if (uvTransformEnabled) {
-    uUVTransform = program->GetUniformLocation("u_uv_transform");
-  }
-  const std::string structNameOpen("u_lights[");
-  const std::string structNameClose("].");
-  const std::string directionName("direction");
-  const std::string ambientName("ambient");
-  const std::string diffuseName("diffuse");
-  const std::string specularName("specular");
-  for (int ix = 0; ix < VRB_MAX_LIGHTS; ix++) {
-    const std::string structName = structNameOpen + std::to_string(ix) + structNameClose;
-    const std::string direction = structName + directionName;
-    const std::string ambient = structName + ambientName;
-    const std::string diffuse = structName + diffuseName;
-    const std::string specular = structName + specularName;
-    uLights[ix].direction = program->GetUniformLocation(direction);
-    uLights[ix].ambient = program->GetUniformLocation(ambient);
-    uLights[ix].diffuse = program->GetUniformLocation(diffuse);
-    uLights[ix].specular = program->GetUniformLocation(specular);
+  aBinding.uvTransformEnabled = program->SupportsFeatures(FeatureUVTransform);
+  aBinding.textureArrayEnabled = program->SupportsFeatures(FeatureTextureArray);
+  aBinding.uniformBlocks = program->SupportsFeatures(FeatureUniformBlocks);
+
+  aBinding.uModel = program->GetUniformLocation("u_model");
+  if (aBinding.uvTransformEnabled) {
+    aBinding.uUVTransform = program->GetUniformLocation("u_uv_transform");
   }
-  const std::string materialName("u_material.");
-  const std::string specularExponentName("specularExponent");
-  const std::string ambient = materialName + ambientName;
-  const std::string diffuse = materialName + diffuseName;
-  const std::string specular = materialName + specularName;
-  const std::string specularExponent = materialName + specularExponentName;
-  uMatterialAmbient = program->GetUniformLocation(ambient);
-  uMatterialDiffuse = program->GetUniformLocation(diffuse);
-  uMatterialSpecular = program->GetUniformLocation(specular);
-  uMatterialSpecularExponent = program->GetUniformLocation(specularExponent);
-  if (kEnableTexturing) {
-    const std::string texture0("u_texture0");
-    uTexture0 = program->GetUniformLocation(texture0);
+  if (aBinding.textureArrayEnabled) {
+    aBinding.uTextureLayer = program->GetUniformLocation("u_textureLayer");
   }
-  uTintColor = program->GetUniformLocation("u_tintColor");
-  aPosition = program->GetAttributeLocation("a_position");
-  aNormal = program->GetAttributeLocation("a_normal");
   if (kEnableTexturing) {
-    aUV = program->GetAttributeLocation("a_uv");
+    aBinding.uTexture0 = program->GetUniformLocation("u_texture0");
+    aBinding.aUV = program->GetAttributeLocation("a_uv");
   }
+  aBinding.aPosition = program->GetAttributeLocation("a_position");
+  aBinding.aNormal = program->GetAttributeLocation("a_normal");
   if (program->SupportsFeatures(FeatureVertexColor)) {
-    aColor = program->GetAttributeLocation("a_color");
+    aBinding.aColor = program->GetAttributeLocation("a_color");
+  }
+  if (aBinding.uniformBlocks) {
+    aBinding.updateProgram = false;
+    return;
+  }
+
+  aBinding.uPerspective = program->GetUniformLocation("u_perspective");
+  aBinding.uView = program->GetUniformLocation("u_view");
+  aBinding.uLightCount = program->GetUniformLocation("u_lightCount");
+  const LightNames& lightNames = GetLightNames();
+  for (int ix = 0; ix < VRB_MAX_LIGHTS; ix++) {
+    aBinding.uLights[ix].direction = program->GetUniformLocation(lightNames.direction[ix]);
+    aBinding.uLights[ix].ambient = program->GetUniformLocation(lightNames.ambient[ix]);
+    aBinding.uLights[ix].diffuse = program->GetUniformLocation(lightNames.diffuse[ix]);
+    aBinding.uLights[ix].specular = program->GetUniformLocation(lightNames.specular[ix]);
+  }
+  aBinding.uMatterialAmbient = program->GetUniformLocation("u_material.ambient");
+  aBinding.uMatterialDiffuse = program->GetUniformLocation("u_material.diffuse");
+  aBinding.uMatterialSpecular = program->GetUniformLocation("u_material.specular");
+  aBinding.uMatterialSpecularExponent = program->GetUniformLocation("u_material.specularExponent");
+  aBinding.uTintColor = program->GetUniformLocation("u_tintColor");
+  aBinding.updateProgram = false;
+}
+
+bool
+RenderState::State::NeedsUpload(uint32_t& aUploaded, const uint32_t aVersion) {
+  if (aUploaded == aVersion) {
+    sUniformSkipCount++;
+    return false;
+  }
+  aUploaded = aVersion;
+  sUniformUploadCount++;
+  return true;
+}
+
+void
+RenderState::State::UpdateMatrix(const GLint aLocation, const Matrix& aMatrix, bool& aUploaded, float* aUploadedData) {
+  // Matrices are passed in for every draw instead of being stored in the RenderState,
+  // so they are compared by value against the last upload to the program.
+  if (aUploaded && (memcmp(aUploadedData, aMatrix.Data(), sizeof(float) * 16) == 0)) {
+    sUniformSkipCount++;
+    return;
+  }
+  memcpy(aUploadedData, aMatrix.Data(), sizeof(float) * 16);
+  aUploaded = true;
+  VRB_GL_CHECK(glUniformMatrix4fv(aLocation, 1, GL_FALSE, aMatrix.Data()));
+  sUniformUploadCount++;
+}
+
+void
+RenderState::State::UpdateUniformBlocks() {
+  if (lightsEnabled) {
+    if (lightsBlock->Update(&lights.data, lights.id)) {
+      sLightUploadCount++;
+      sUniformUploadCount++;
+    } else {
+      sUniformSkipCount++;
+    }
+  } else {
+    static const LightSet sNoLights;
+    if (lightsBlock->Update(&sNoLights.data, 0)) {
+      sUniformUploadCount++;
+    } else {
+      sUniformSkipCount++;
+    }
+  }
+
+  if (materialBlock->GetVersion() == materialBlockVersion) {
+    sUniformSkipCount++;
+  } else {
+    MaterialBlock material;
+    memset(&material, 0, sizeof(material));
+    memcpy(material.ambient, ambient.Data(), sizeof(material.ambient));
+    memcpy(material.diffuse, diffuse.Data(), sizeof(material.diffuse));
+    memcpy(material.specular, specular.Data(), sizeof(material.specular));
+    material.specularExponent = specularExponent;
+    memcpy(material.tintColor, tintColor.Data(), sizeof(material.tintColor));
+    materialBlock->Update(&material, materialBlockVersion);
+    sUniformUploadCount++;
+  }
+
+  lightsBlock->Bind(VRB_LIGHTS_BLOCK_BINDING);
+  materialBlock->Bind(VRB_MATERIAL_BLOCK_BINDING);
+}
+
+void
+RenderState::State::UpdateLightUniforms(ProgramBinding& aBinding) {
+  // Light uniforms live in the program object, so they only need to be written when
+  // a different light set was last uploaded to this program. Id zero means no lights.
+  const uint32_t id = lightsEnabled ? lights.id : 0;
+  Program::UniformCache& uploaded = aBinding.program->GetUniformCache();
+  if ((id != 0) && (uploaded.lightSet == id)) {
+    sUniformSkipCount++;
+    return;
+  }
+  const int32_t lightCount = lightsEnabled ? lights.data.count : 0;
+  for (int32_t ix = 0; ix < lightCount; ix++) {
+    const LightSet::Light& light = lights.data.lights[ix];
+    VRB_GL_CHECK(glUniform3fv(aBinding.uLights[ix].direction, 1, light.direction));
+    VRB_GL_CHECK(glUniform4fv(aBinding.uLights[ix].ambient, 1, light.ambient));
+    VRB_GL_CHECK(glUniform4fv(aBinding.uLights[ix].diffuse, 1, light.diffuse));
+    VRB_GL_CHECK(glUniform4fv(aBinding.uLights[ix].specular, 1, light.specular));
+  }
+  VRB_GL_CHECK(glUniform1i(aBinding.uLightCount, lightCount));
+  uploaded.lightSet = id;
+  sLightUploadCount++;
+  sUniformUploadCount++;
+}
+
+void
+RenderState::State::UpdateUniforms(const Matrix& aModel) {
+  ProgramBinding& binding = *active;
+  Program::UniformCache& uploaded = binding.program->GetUniformCache();
+  if (binding.uniformBlocks) {
+    UpdateUniformBlocks();
+  } else {
+    UpdateLightUniforms(binding);
+
+    if (NeedsUpload(uploaded.material, materialVersion)) {
+      VRB_GL_CHECK(glUniform4fv(binding.uMatterialAmbient, 1, ambient.Data()));
+      VRB_GL_CHECK(glUniform4fv(binding.uMatterialDiffuse, 1, diffuse.Data()));
+      VRB_GL_CHECK(glUniform4fv(binding.uMatterialSpecular, 1, specular.Data()));
+      VRB_GL_CHECK(glUniform1f(binding.uMatterialSpecularExponent, specularExponent));
+    }
+    if (NeedsUpload(uploaded.tint, tintVersion)) {
+      VRB_GL_CHECK(glUniform4f(binding.uTintColor, tintColor.Red(), tintColor.Green(), tintColor.Blue(), tintColor.Alpha()));
+    }
+  }
+
+  if (texture) {
+    VRB_GL_CHECK(glActiveTexture(GL_TEXTURE0));
+    texture->Bind();
+    if (!uploaded.texture) {
+      VRB_GL_CHECK(glUniform1i(binding.uTexture0, 0));
+      uploaded.texture = true;
+    }
+  }
+  UpdateMatrix(binding.uModel, aModel, uploaded.model, uploaded.modelData);
+  if (binding.uvTransformEnabled && NeedsUpload(uploaded.uvTransform, uvTransformVersion)) {
+    VRB_GL_CHECK(glUniformMatrix4fv(binding.uUVTransform, 1, GL_FALSE, uvTransform.Data()));
+  }
+  if (binding.textureArrayEnabled && NeedsUpload(uploaded.textureLayer, textureLayerVersion)) {
+    VRB_GL_CHECK(glUniform1f(binding.uTextureLayer, (float)textureLayer));
   }
-  updateProgram = false;
 }
 
 RenderStatePtr
@@ -178,44 +396,67 @@ RenderState::Create(CreationContextPtr& aContext) {
 
 void
 RenderState::SetProgram(ProgramPtr& aProgram) {
-  m.program = aProgram;
-  m.updateProgram = true;
+  m.single.program = aProgram;
+  m.single.updateProgram = true;
+  m.multiview.program = nullptr;
+  m.multiview.updateProgram = true;
 }
 
 GLint
 RenderState::AttributePosition() const {
-  return m.aPosition;
+  return m.active->aPosition;
 }
 
 GLint
 RenderState::AttributeNormal() const {
-  return m.aNormal;
+  return m.active->aNormal;
 }
 
 GLint
 RenderState::AttributeUV() const {
-  return m.aUV;
+  return m.active->aUV;
 }
 
 GLint
 RenderState::AttributeColor() const {
-  return m.aColor;
+  return m.active->aColor;
 }
 
 uint32_t
 RenderState::GetLightId() const {
-  return m.lightId;
+  return m.lights.id;
+}
+
+void
+RenderState::SetLightSet(const LightSet& aLightSet) {
+  m.lights = aLightSet;
 }
 
 void
-RenderState::ResetLights(const uint32_t aId) {
-  m.lightId = aId;
-  m.lights.clear();
+RenderState::ResetLights() {
+  m.lights.Clear();
+  m.lights.id = LightSet::NextId();
 }
 
 void
 RenderState::AddLight(const Vector& aDirection, const Color& aAmbient, const Color& aDiffuse, const Color& aSpecular) {
-  m.lights.push_back(State::Light(aDirection, aAmbient, aDiffuse, aSpecular));
+  m.lights.Add(aDirection, aAmbient, aDiffuse, aSpecular);
+  m.lights.id = LightSet::NextId();
+}
+
+uint32_t
+RenderState::GetLightUploadCount() {
+  return sLightUploadCount.load();
+}
+
+uint32_t
+RenderState::GetUniformUploadCount() {
+  return sUniformUploadCount.load();
+}
+
+uint32_t
+RenderState::GetUniformSkipCount() {
+  return sUniformSkipCount.load();
 }
 
 void
@@ -224,17 +465,23 @@ RenderState::SetMaterial(const Color& aAmbient, const Color& aDiffuse, const Col
   m.diffuse = aDiffuse;
   m.specular = aSpecular;
   m.specularExponent = aSpecularExponent;
+  m.materialVersion = NextUniformVersion();
+  m.materialBlockVersion = NextUniformVersion();
 }
 
 
 void
 RenderState::SetAmbient(const Color& aColor) {
   m.ambient = aColor;
+  m.materialVersion = NextUniformVersion();
+  m.materialBlockVersion = NextUniformVersion();
 }
 
 void
 RenderState::SetDiffuse(const Color& aColor) {
   m.diffuse = aColor;
+  m.materialVersion = NextUniformVersion();
+  m.materialBlockVersion = NextUniformVersion();
 }
 
 void
@@ -250,7 +497,8 @@ RenderState::UVLength() const {
   if (!m.texture) {
     return 0;
   }
-  return m.texture->GetTarget() == GL_TEXTURE_CUBE_MAP ? 3 : 2;
+  const GLenum kTarget = m.texture->GetTarget();
+  return (kTarget == GL_TEXTURE_CUBE_MAP) || (kTarget == GL_TEXTURE_2D_ARRAY) ? 3 : 2;
 }
 
 TexturePtr
@@ -276,45 +524,62 @@ RenderState::GetTintColor() const {
 void
 RenderState::SetTintColor(const Color& aColor) {
   m.tintColor = aColor;
+  m.tintVersion = NextUniformVersion();
+  m.materialBlockVersion = NextUniformVersion();
 }
 
 bool
 RenderState::Enable(const Matrix& aPerspective, const Matrix& aView, const Matrix& aModel) {
-  if (!m.program) { return false; }
-  if (!m.program->Enable()) { return false; }
-  if (m.updateProgram) {
-    m.InitializeProgram();
+  if (!m.EnableProgram(m.single)) {
+    return false;
   }
-
-  int lightCount = 0;
-  if (m.lightsEnabled) {
-    for (State::Light& light: m.lights) {
-      VRB_GL_CHECK(glUniform3f(m.uLights[lightCount].direction, light.direction.x(), light.direction.y(), light.direction.z()));
-      VRB_GL_CHECK(glUniform4fv(m.uLights[lightCount].ambient, 1, light.ambient.Data()));
-      VRB_GL_CHECK(glUniform4fv(m.uLights[lightCount].diffuse, 1, light.diffuse.Data()));
-      VRB_GL_CHECK(glUniform4fv(m.uLights[lightCount].specular, 1, light.specular.Data()));
-      lightCount++;
+  if (m.single.uniformBlocks) {
+    CameraBlock camera;
+    memcpy(camera.perspective, aPerspective.Data(), sizeof(camera.perspective));
+    memcpy(camera.view, aView.Data(), sizeof(camera.view));
+    if (m.cameraBlock->Update(&camera)) {
+      sUniformUploadCount++;
+    } else {
+      sUniformSkipCount++;
     }
+    m.cameraBlock->Bind(VRB_CAMERA_BLOCK_BINDING);
+  } else {
+    Program::UniformCache& uploaded = m.single.program->GetUniformCache();
+    m.UpdateMatrix(m.single.uPerspective, aPerspective, uploaded.perspective, uploaded.perspectiveData);
+    m.UpdateMatrix(m.single.uView, aView, uploaded.view, uploaded.viewData);
   }
-  VRB_GL_CHECK(glUniform1i(m.uLightCount, lightCount));
-
-  VRB_GL_CHECK(glUniform4fv(m.uMatterialAmbient, 1, m.ambient.Data()));
-  VRB_GL_CHECK(glUniform4fv(m.uMatterialDiffuse, 1, m.diffuse.Data()));
-  VRB_GL_CHECK(glUniform4fv(m.uMatterialSpecular, 1, m.specular.Data()));
-  VRB_GL_CHECK(glUniform1f(m.uMatterialSpecularExponent, m.specularExponent));
+  m.UpdateUniforms(aModel);
+  return true;
+}
 
-  if (m.texture) {
-    VRB_GL_CHECK(glActiveTexture(GL_TEXTURE0));
-    m.texture->Bind();
-    VRB_GL_CHECK(glUniform1i(m.uTexture0, 0));
+bool
+RenderState::Enable(const Matrix& aLeftPerspective, const Matrix& aLeftView,
+                    const Matrix& aRightPerspective, const Matrix& aRightView, const Matrix& aModel) {
+  if (!m.single.program) {
+    return false;
+  }
+  if (!m.multiview.program) {
+    m.multiview.program = m.single.program->GetMultiviewVariant();
+    if (!m.multiview.program) {
+      VRB_WARN("RenderState has no multiview program. Was multiview enabled on the ProgramFactory?");
+      return false;
+    }
   }
-  VRB_GL_CHECK(glUniform4f(m.uTintColor, m.tintColor.Red(), m.tintColor.Green(), m.tintColor.Blue(), m.tintColor.Alpha()));
-  VRB_GL_CHECK(glUniformMatrix4fv(m.uPerspective, 1, GL_FALSE, aPerspective.Data()));
-  VRB_GL_CHECK(glUniformMatrix4fv(m.uView, 1, GL_FALSE, aView.Data()));
-  VRB_GL_CHECK(glUniformMatrix4fv(m.uModel, 1, GL_FALSE, aModel.Data()));
-  if (m.uvTransformEnabled) {
-    VRB_GL_CHECK(glUniformMatrix4fv(m.uUVTransform, 1, GL_FALSE, m.uvTransform.Data()));
+  if (!m.EnableProgram(m.multiview)) {
+    return false;
   }
+  MultiviewCameraBlock camera;
+  memcpy(camera.perspective[0], aLeftPerspective.Data(), sizeof(camera.perspective[0]));
+  memcpy(camera.perspective[1], aRightPerspective.Data(), sizeof(camera.perspective[1]));
+  memcpy(camera.view[0], aLeftView.Data(), sizeof(camera.view[0]));
+  memcpy(camera.view[1], aRightView.Data(), sizeof(camera.view[1]));
+  if (m.multiviewCameraBlock->Update(&camera)) {
+    sUniformUploadCount++;
+  } else {
+    sUniformSkipCount++;
+  }
+  m.multiviewCameraBlock->Bind(VRB_MULTIVIEW_CAMERA_BLOCK_BINDING);
+  m.UpdateUniforms(aModel);
   return true;
 }
 
@@ -333,10 +598,33 @@ RenderState::SetLightsEnabled(bool aEnabled) {
 
 void
 RenderState::SetUVTransform(const vrb::Matrix& aMatrix) {
+  // Drawables with their own UV transform set it before every draw, an unchanged
+  // transform keeps its version so the upload is skipped.
+  if (memcmp(m.uvTransform.Data(), aMatrix.Data(), sizeof(float) * 16) == 0) {
+    return;
+  }
   m.uvTransform = aMatrix;
+  m.uvTransformVersion = NextUniformVersion();
 }
 
-RenderState::RenderState(State& aState, CreationContextPtr& aContext) : ResourceGL(aState, aContext), m(aState) {}
+void
+RenderState::SetTextureLayer(const int32_t aLayer) {
+  m.textureLayer = aLayer;
+  m.textureLayerVersion = NextUniformVersion();
+}
+
+int32_t
+RenderState::GetTextureLayer() const {
+  return m.textureLayer;
+}
+
+RenderState::RenderState(State& aState, CreationContextPtr& aContext) : ResourceGL(aState, aContext), m(aState) {
+  ProgramFactoryPtr factory = aContext->GetProgramFactory();
+  m.cameraBlock = factory->GetSharedUniformBuffer(aContext, VRB_CAMERA_BLOCK_BINDING, sizeof(CameraBlock));
+  m.multiviewCameraBlock = factory->GetSharedUniformBuffer(aContext, VRB_MULTIVIEW_CAMERA_BLOCK_BINDING, sizeof(MultiviewCameraBlock));
+  m.lightsBlock = factory->GetSharedUniformBuffer(aContext, VRB_LIGHTS_BLOCK_BINDING, sizeof(LightSet::Data));
+  m.materialBlock = UniformBuffer::Create(aContext, sizeof(MaterialBlock));
+}
 
 void
 RenderState::InitializeGL() {
@@ -344,7 +632,8 @@ RenderState::InitializeGL() {
 
 void
 RenderState::ShutdownGL() {
-  m.updateProgram = true;
+  m.single.updateProgram = true;
+  m.multiview.updateProgram = true;
 }
 
 } // namespace vrb
@@ -41,51 +41,118 @@ GetUniformLocation(GLuint aProgram, const std::string& aName) {
 
 GLuint
 LoadShader(GLenum aType, const char* aSrc) {
+  GLuint shader = CompileShader(aType, aSrc);
+  if (shader) {
+    CheckShaderCompiled(shader, aSrc);
+  }
+  return shader;
+}
+
+GLuint
+CompileShader(GLenum aType, const char* aSrc) {
+  return CompileShader(aType, 1, &aSrc);
+}
+
+GLuint
+CompileShader(GLenum aType, GLsizei aCount, const char* const* aStrings) {
   GLuint shader = VRB_GL_CHECK(glCreateShader(aType));
 
   if (shader == 0) {
     VRB_ERROR("FAILED to create shader of type: %s", (aType == GL_VERTEX_SHADER ? "vertex shader" : "fragment shader"));
+    return 0;
   }
 
-  VRB_GL_CHECK(glShaderSource(shader, 1, &aSrc, nullptr));
+  VRB_GL_CHECK(glShaderSource(shader, aCount, aStrings, nullptr));
   VRB_GL_CHECK(glCompileShader(shader));
+  return shader;
+}
+
+bool
+CheckShaderCompiled(GLuint aShader, const char* aSrc) {
   GLint compiled = 0;
-  VRB_GL_CHECK(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+  VRB_GL_CHECK(glGetShaderiv(aShader, GL_COMPILE_STATUS, &compiled));
 
   if (!compiled) {
     GLint length = 0;
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    glGetShaderiv(aShader, GL_INFO_LOG_LENGTH, &length);
     if (length > 1) {
       std::unique_ptr<char[]> log = std::make_unique<char[]>(length);
-      VRB_GL_CHECK(glGetShaderInfoLog(shader, length, nullptr, log.get()));
+      VRB_GL_CHECK(glGetShaderInfoLog(aShader, length, nullptr, log.get()));
       VRB_ERROR("Failed to compile shader:\n%s", log.get());
       VRB_ERROR("From source:\n%s", aSrc);
     }
   }
-
-  return shader;
+  return compiled != 0;
 }
 
 GLuint
 CreateProgram(GLuint aVertexShader, GLuint aFragmentShader) {
+  GLuint program = LinkProgram(aVertexShader, aFragmentShader);
+  if (!CheckProgramLinked(program)) {
+    VRB_GL_CHECK(glDeleteProgram(program));
+    program = 0;
+  }
+  return program;
+}
+
+GLuint
+LinkProgram(GLuint aVertexShader, GLuint aFragmentShader) {
   GLuint program = VRB_GL_CHECK(glCreateProgram());
   VRB_GL_CHECK(glAttachShader(program, aVertexShader));
   VRB_GL_CHECK(glAttachShader(program, aFragmentShader));
   VRB_GL_CHECK(glLinkProgram(program));
+  return program;
+}
+
+bool
+CheckProgramLinked(GLuint aProgram) {
   GLint linked = 0;
-  VRB_GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+  VRB_GL_CHECK(glGetProgramiv(aProgram, GL_LINK_STATUS, &linked));
   if (!linked) {
     GLint length = 0;
-    VRB_GL_CHECK(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length));
+    VRB_GL_CHECK(glGetProgramiv(aProgram, GL_INFO_LOG_LENGTH, &length));
     if (length > 1) {
       std::unique_ptr<char[]> log = std::make_unique<char[]>(length);
-      VRB_GL_CHECK(glGetProgramInfoLog(program, length, nullptr, log.get()));
+      VRB_GL_CHECK(glGetProgramInfoLog(aProgram, length, nullptr, log.get()));
       VRB_ERROR("Failed to link program:\n%s", log.get());
     }
+  }
+  return linked != 0;
+}
+
+GLuint
+CreateProgramFromBinary(GLenum aFormat, const void* aBinary, GLsizei aLength) {
+  GLuint program = VRB_GL_CHECK(glCreateProgram());
+  VRB_GL_CHECK(glProgramBinary(program, aFormat, aBinary, aLength));
+  GLint linked = 0;
+  VRB_GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+  if (!linked) {
     VRB_GL_CHECK(glDeleteProgram(program));
     program = 0;
   }
   return program;
 }
 
+bool
+GetProgramBinary(GLuint aProgram, GLenum& aFormat, std::unique_ptr<uint8_t[]>& aBinary, GLsizei& aLength) {
+  GLint length = 0;
+  VRB_GL_CHECK(glGetProgramiv(aProgram, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) {
+    return false;
+  }
+  aBinary = std::make_unique<uint8_t[]>(length);
+  aLength = 0;
+  VRB_GL_CHECK(glGetProgramBinary(aProgram, length, &aLength, &aFormat, aBinary.get()));
+  return aLength > 0;
+}
+
+void
+BindUniformBlock(GLuint aProgram, const char* aBlockName, GLuint aBindingPoint) {
+  const GLuint index = VRB_GL_CHECK(glGetUniformBlockIndex(aProgram, aBlockName));
+  if (index == GL_INVALID_INDEX) {
+    return;
+  }
+  VRB_GL_CHECK(glUniformBlockBinding(aProgram, index, aBindingPoint));
+}
+
 } // namespace vrb
@@ -15,7 +15,7 @@ namespace vrb {
 void
 Texture::Bind() {
   AboutToBind();
-  VRB_GL_CHECK(glBindTexture(m.target, m.texture));
+  VRB_GL_CHECK(glBindTexture(m.target, GetBindHandle()));
 }
 
 void
@@ -38,6 +38,11 @@ Texture::GetHandle() const {
   return m.texture;
 }
 
+GLuint
+Texture::GetBindHandle() const {
+  return m.texture;
+}
+
 void
 Texture::SetName(const std::string& aName) {
   m.name = aName;
@@ -52,6 +57,12 @@ Texture::SetTextureParameter(GLenum aName, GLint aParam) {
   VRB_GL_CHECK(glBindTexture(m.target, 0));
 }
 
+GLint
+Texture::GetTextureParameter(GLenum aName) const {
+  auto param = m.intMap.find(aName);
+  return param != m.intMap.end() ? param->second : 0;
+}
+
 Texture::Texture(State& aState, CreationContextPtr& aContext) : m(aState) {}
 Texture::~Texture() {}
 
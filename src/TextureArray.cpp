@@ -0,0 +1,303 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/TextureArray.h"
+#include "vrb/private/TextureState.h"
+#include "vrb/ConcreteClass.h"
+
+#include "vrb/CreationContext.h"
+#include "vrb/DataBuffer.h"
+#include "vrb/DataCache.h"
+#include "vrb/FileReader.h"
+#include "vrb/GLError.h"
+#include "vrb/Logger.h"
+#include "vrb/private/ResourceGLState.h"
+
+#include "vrb/gl.h"
+#include <vector>
+
+namespace {
+
+struct ArrayLayer {
+  vrb::DataBufferPtr data;
+  uint32_t dataCacheHandle;
+  ArrayLayer() : dataCacheHandle(0) {}
+};
+
+class ArrayTextureHandler;
+typedef std::shared_ptr<ArrayTextureHandler> ArrayTextureHandlerPtr;
+
+class ArrayTextureHandler : public vrb::FileHandler {
+public:
+  static ArrayTextureHandlerPtr Create(const vrb::TextureArrayPtr& aTexture, const int32_t aLayer);
+  void BindFileHandle(const std::string& aFileName, const int aFileHandle) override {}
+  void LoadFailed(const int aFileHandle, const std::string& aReason) override;
+  void ProcessRawFileChunk(const int aFileHandle, const char* aBuffer, const size_t aSize) override {}
+  void FinishRawFile(const int aFileHandle) override {}
+  void ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) override;
+  ArrayTextureHandler() : mLayer(0) {}
+  ~ArrayTextureHandler() {}
+protected:
+  vrb::TextureArrayPtr mTexture;
+  int32_t mLayer;
+private:
+  VRB_NO_DEFAULTS(ArrayTextureHandler)
+};
+
+ArrayTextureHandlerPtr
+ArrayTextureHandler::Create(const vrb::TextureArrayPtr& aTexture, const int32_t aLayer) {
+  ArrayTextureHandlerPtr result = std::make_shared<ArrayTextureHandler>();
+  result->mTexture = aTexture;
+  result->mLayer = aLayer;
+  return result;
+}
+
+void
+ArrayTextureHandler::LoadFailed(const int aFileHandle, const std::string& aReason) {
+  VRB_ERROR("Failed to load layer %d of texture array: %s", mLayer, aReason.c_str());
+}
+
+void
+ArrayTextureHandler::ProcessImageFile(const int aFileHandle, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) {
+  if (mTexture) {
+    mTexture->SetImageData(mLayer, aImage, aImageLength, aWidth, aHeight, aFormat);
+  }
+}
+
+bool
+IsMipmapFilter(const GLint aFilter) {
+  return (aFilter != GL_NEAREST) && (aFilter != GL_LINEAR);
+}
+
+}
+
+namespace vrb {
+
+struct TextureArray::State : public Texture::State, public ResourceGL::State {
+  bool dirty;
+  DataCachePtr dataCache;
+  GLsizei width;
+  GLsizei height;
+  GLenum format;
+  bool compressed;
+  size_t layerSize;
+  std::vector<ArrayLayer> layers;
+
+  State()
+      : dirty(false)
+      , width(0)
+      , height(0)
+      , format(GL_RGBA)
+      , compressed(false)
+      , layerSize(0)
+  {}
+  bool LoadLayers();
+  void ReleaseLayers();
+  void CreateTexture();
+  void DestroyTexture();
+};
+
+// Returns false until every layer has image data.
+bool
+TextureArray::State::LoadLayers() {
+  if (layers.empty()) {
+    return false;
+  }
+  for (ArrayLayer& layer: layers) {
+    if (!layer.data && dataCache && (layer.dataCacheHandle > 0)) {
+      layer.data = dataCache->LoadBuffer(layer.dataCacheHandle);
+    }
+    if (!layer.data || (layer.data->GetSize() < layerSize)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+TextureArray::State::ReleaseLayers() {
+  if (!dataCache) {
+    return;
+  }
+  for (ArrayLayer& layer: layers) {
+    if (layer.dataCacheHandle == 0) {
+      layer.dataCacheHandle = dataCache->CacheData(layer.data);
+    }
+    if (layer.dataCacheHandle > 0) {
+      layer.data = nullptr;
+    }
+  }
+}
+
+void
+TextureArray::State::CreateTexture() {
+  if (!dirty || !LoadLayers()) {
+    return;
+  }
+  // Compressed layers use immutable storage, so the texture is recreated when it changes.
+  if (texture > 0) {
+    VRB_GL_CHECK(glDeleteTextures(1, &texture));
+  }
+  VRB_GL_CHECK(glGenTextures(1, &texture));
+  VRB_GL_CHECK(glBindTexture(target, texture));
+  const GLsizei kCount = (GLsizei)layers.size();
+  if (compressed) {
+    VRB_GL_CHECK(glTexStorage3D(target, 1, format, width, height, kCount));
+  } else {
+    VRB_GL_CHECK(glTexImage3D(target, 0, format, width, height, kCount, 0, format, GL_UNSIGNED_BYTE, nullptr));
+    // Rows are tightly packed, GL_RGB rows are not always a multiple of four bytes.
+    VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  }
+  for (GLsizei ix = 0; ix < kCount; ix++) {
+    const void* pixels = layers[ix].data->GetData();
+    if (compressed) {
+      VRB_GL_CHECK(glCompressedTexSubImage3D(target, 0, 0, 0, ix, width, height, 1, format, (GLsizei)layerSize, pixels));
+    } else {
+      VRB_GL_CHECK(glTexSubImage3D(target, 0, 0, 0, ix, width, height, 1, format, GL_UNSIGNED_BYTE, pixels));
+    }
+  }
+  if (!compressed) {
+    VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  }
+  for (auto param = intMap.begin(); param != intMap.end(); param++) {
+    VRB_GL_CHECK(glTexParameteri(target, param->first, param->second));
+  }
+  if (!compressed && IsMipmapFilter(intMap[GL_TEXTURE_MIN_FILTER])) {
+    VRB_GL_CHECK(glGenerateMipmap(target));
+  }
+  VRB_GL_CHECK(glBindTexture(target, 0));
+  ReleaseLayers();
+  dirty = false;
+}
+
+void
+TextureArray::State::DestroyTexture() {
+  if (texture > 0) {
+    VRB_GL_CHECK(glDeleteTextures(1, &texture));
+    texture = 0;
+  }
+  dirty = true;
+}
+
+TextureArrayPtr
+TextureArray::Create(CreationContextPtr& aContext) {
+  return std::make_shared<ConcreteClass<TextureArray, TextureArray::State> >(aContext);
+}
+
+void
+TextureArray::Load(CreationContextPtr& aContext, const TextureArrayPtr& aTexture, const std::vector<std::string>& aFiles) {
+  FileReaderPtr reader = aContext->GetFileReader();
+  if (!reader) {
+    VRB_ERROR("FileReaderPtr not found while loading a TextureArray");
+    return;
+  }
+  aTexture->SetLayerCount((int32_t)aFiles.size());
+  for (size_t ix = 0; ix < aFiles.size(); ix++) {
+    reader->ReadImageFile(aFiles[ix], ArrayTextureHandler::Create(aTexture, (int32_t)ix));
+  }
+}
+
+void
+TextureArray::SetLayerCount(const int32_t aCount) {
+  if (aCount < 0) {
+    return;
+  }
+  while ((int32_t)m.layers.size() > aCount) {
+    if (m.dataCache && (m.layers.back().dataCacheHandle > 0)) {
+      m.dataCache->RemoveData(m.layers.back().dataCacheHandle);
+    }
+    m.layers.pop_back();
+  }
+  m.layers.resize((size_t)aCount);
+  m.dirty = true;
+}
+
+int32_t
+TextureArray::GetLayerCount() const {
+  return (int32_t)m.layers.size();
+}
+
+void
+TextureArray::SetImageData(const int32_t aLayer, std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImageLength, const int aWidth, const int aHeight, const GLenum aFormat) {
+  if ((aWidth <= 0) || (aHeight <= 0) || !aImage) {
+    return;
+  }
+  if ((aLayer < 0) || (aLayer >= (int32_t)m.layers.size())) {
+    VRB_ERROR("TextureArray layer %d out of range, layer count is %d", aLayer, (int)m.layers.size());
+    return;
+  }
+  if (m.width == 0) {
+    m.width = aWidth;
+    m.height = aHeight;
+    m.format = aFormat;
+    m.compressed = (aFormat != GL_RG8) && (aFormat != GL_RGB) && (aFormat != GL_RGBA);
+    m.layerSize = (size_t)aImageLength;
+  } else if ((m.width != aWidth) || (m.height != aHeight) || (m.format != aFormat) || (m.layerSize != aImageLength)) {
+    VRB_ERROR("TextureArray layer %d is %dx%d format 0x%X, expected %dx%d format 0x%X",
+              aLayer, aWidth, aHeight, aFormat, m.width, m.height, m.format);
+    return;
+  }
+  ArrayLayer& layer = m.layers[aLayer];
+  if (m.dataCache && (layer.dataCacheHandle > 0)) {
+    m.dataCache->RemoveData(layer.dataCacheHandle);
+  }
+  layer.dataCacheHandle = 0;
+  layer.data = DataBuffer::Create(aImage, (size_t)aImageLength);
+  m.dirty = true;
+}
+
+GLsizei
+TextureArray::GetWidth() const {
+  return m.width;
+}
+
+GLsizei
+TextureArray::GetHeight() const {
+  return m.height;
+}
+
+TextureArray::TextureArray(State& aState, CreationContextPtr& aContext) : Texture(aState, aContext), ResourceGL(aState, aContext), m(aState) {
+  m.dataCache = aContext->GetDataCache();
+  m.target = GL_TEXTURE_2D_ARRAY;
+}
+
+TextureArray::~TextureArray() {
+  if (!m.dataCache) {
+    return;
+  }
+  for (ArrayLayer& layer: m.layers) {
+    if (layer.dataCacheHandle > 0) {
+      m.dataCache->RemoveData(layer.dataCacheHandle);
+      layer.dataCacheHandle = 0;
+    }
+  }
+}
+
+void
+TextureArray::AboutToBind() {
+  m.CreateTexture();
+}
+
+bool
+TextureArray::SupportOffRenderThreadInitialization() {
+  return true;
+}
+
+ResourceGL::Priority
+TextureArray::GetInitializationPriority() {
+  return Priority::Low;
+}
+
+void
+TextureArray::InitializeGL() {
+  m.CreateTexture();
+}
+
+void
+TextureArray::ShutdownGL() {
+  m.DestroyTexture();
+}
+
+} // namespace vrb
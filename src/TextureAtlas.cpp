@@ -0,0 +1,254 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/TextureAtlas.h"
+#include "vrb/private/UpdatableState.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/CreationContext.h"
+#include "vrb/DataBuffer.h"
+#include "vrb/FileReader.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/Mutex.h"
+#include "vrb/TextureGL.h"
+#include "vrb/Vector.h"
+
+#include "vrb/gl.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const int32_t kBytesPerPixel = 4;
+// Texels repeated around each image so linear filtering never reads a neighbor.
+const int32_t kGutter = 1;
+
+struct Shelf {
+  int32_t y;
+  int32_t height;
+  int32_t x;
+};
+
+// Rows [begin, end) of a page changed since its last upload.
+struct RowRange {
+  int32_t begin;
+  int32_t end;
+};
+
+struct Page {
+  vrb::TextureGLPtr texture;
+  // Shared with the texture, which retains it. Images are written through pixels, so
+  // the texture uploads changed rows from it without a copy.
+  vrb::DataBufferPtr image;
+  uint8_t* pixels;
+  std::vector<Shelf> shelves;
+  int32_t nextY;
+  std::vector<RowRange> dirtyRows;
+  Page() : pixels(nullptr), nextY(0) {}
+};
+
+struct Region {
+  size_t page;
+  vrb::Matrix uvTransform;
+};
+
+}
+
+namespace vrb {
+
+struct TextureAtlas::State : public Updatable::State {
+  CreationContextWeak context;
+  int32_t pageSize;
+  int32_t maxImageSize;
+  Mutex lock;
+  std::vector<Page> pages;
+  std::unordered_map<std::string, Region> regions;
+
+  State() : pageSize(1024), maxImageSize(256) {}
+  bool Place(Page& aPage, const int32_t aWidth, const int32_t aHeight, int32_t& aX, int32_t& aY);
+  Page* CreatePage();
+  void Copy(Page& aPage, const uint8_t* aPixels, const int32_t aWidth, const int32_t aHeight, const int32_t aX, const int32_t aY);
+};
+
+// Best fit shelf packing: use the lowest shelf the image fits on, or start a new one.
+bool
+TextureAtlas::State::Place(Page& aPage, const int32_t aWidth, const int32_t aHeight, int32_t& aX, int32_t& aY) {
+  Shelf* best = nullptr;
+  for (Shelf& shelf: aPage.shelves) {
+    if ((shelf.height < aHeight) || ((shelf.x + aWidth) > pageSize)) {
+      continue;
+    }
+    if (!best || (shelf.height < best->height)) {
+      best = &shelf;
+    }
+  }
+  // Avoid wasting a tall shelf on a short image when there is room for a new shelf.
+  if ((!best || (best->height > (aHeight * 2))) && ((aPage.nextY + aHeight) <= pageSize)) {
+    aPage.shelves.push_back({aPage.nextY, aHeight, 0});
+    aPage.nextY += aHeight;
+    best = &aPage.shelves.back();
+  }
+  if (!best) {
+    return false;
+  }
+  aX = best->x;
+  aY = best->y;
+  best->x += aWidth;
+  return true;
+}
+
+Page*
+TextureAtlas::State::CreatePage() {
+  CreationContextPtr creation = context.lock();
+  if (!creation) {
+    VRB_ERROR("TextureAtlas unable to create a page without a CreationContext");
+    return nullptr;
+  }
+  pages.emplace_back();
+  Page& page = pages.back();
+  const size_t kSize = (size_t)pageSize * pageSize * kBytesPerPixel;
+  std::unique_ptr<uint8_t[]> pixels = std::make_unique<uint8_t[]>(kSize);
+  page.pixels = pixels.get();
+  page.image = DataBuffer::Create(pixels, kSize);
+  page.texture = TextureGL::Create(creation);
+  page.texture->SetName("TextureAtlas page " + std::to_string(pages.size()));
+  page.texture->SetTextureParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  page.texture->SetTextureParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  page.texture->SetTextureParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  page.texture->SetTextureParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // Pages are updated as images are added. Upload them directly so materials already
+  // using a page do not fall back to the placeholder texture meanwhile.
+  page.texture->SetUploadQueue(nullptr);
+  page.texture->SetRetainImageData(true);
+  ImageLayout layout;
+  layout.levels.push_back({GL_TEXTURE_2D, 0, pageSize, pageSize, 0, kSize});
+  page.texture->SetImageLevels(page.image, layout);
+  return &page;
+}
+
+// Copies the image to (aX, aY) inside of its gutter and fills the gutter with the
+// closest edge texels.
+void
+TextureAtlas::State::Copy(Page& aPage, const uint8_t* aPixels, const int32_t aWidth, const int32_t aHeight, const int32_t aX, const int32_t aY) {
+  const size_t kSourceStride = (size_t)aWidth * kBytesPerPixel;
+  const size_t kPageStride = (size_t)pageSize * kBytesPerPixel;
+  for (int32_t row = -kGutter; row < (aHeight + kGutter); row++) {
+    const int32_t sourceRow = std::max(0, std::min(aHeight - 1, row));
+    const uint8_t* source = aPixels + (sourceRow * kSourceStride);
+    uint8_t* dest = aPage.pixels + ((aY + row) * kPageStride) + ((size_t)aX * kBytesPerPixel);
+    memcpy(dest, source, kSourceStride);
+    for (int32_t column = 1; column <= kGutter; column++) {
+      memcpy(dest - (column * kBytesPerPixel), source, kBytesPerPixel);
+      memcpy(dest + kSourceStride + ((column - 1) * kBytesPerPixel), source + kSourceStride - kBytesPerPixel, kBytesPerPixel);
+    }
+  }
+  aPage.dirtyRows.push_back({aY - kGutter, aY + aHeight + kGutter});
+}
+
+TextureAtlasPtr
+TextureAtlas::Create(CreationContextPtr& aContext, const int32_t aPageSize, const int32_t aMaxImageSize) {
+  TextureAtlasPtr result = std::make_shared<ConcreteClass<TextureAtlas, TextureAtlas::State> >(aContext);
+  result->m.pageSize = aPageSize;
+  result->m.maxImageSize = std::min(aMaxImageSize, aPageSize - (2 * kGutter));
+  return result;
+}
+
+int32_t
+TextureAtlas::GetMaxImageSize() const {
+  return m.maxImageSize;
+}
+
+int32_t
+TextureAtlas::GetPageCount() const {
+  MutexAutoLock lock(m.lock);
+  return (int32_t)m.pages.size();
+}
+
+bool
+TextureAtlas::Find(const std::string& aName, TextureGLPtr& aTexture, Matrix& aUVTransform) {
+  MutexAutoLock lock(m.lock);
+  auto region = m.regions.find(aName);
+  if (region == m.regions.end()) {
+    return false;
+  }
+  aTexture = m.pages[region->second.page].texture;
+  aUVTransform = region->second.uvTransform;
+  return true;
+}
+
+bool
+TextureAtlas::Add(const std::string& aName, const uint8_t* aPixels, const int32_t aWidth, const int32_t aHeight,
+                  TextureGLPtr& aTexture, Matrix& aUVTransform) {
+  if (!aPixels || (aWidth <= 0) || (aHeight <= 0) || (aWidth > m.maxImageSize) || (aHeight > m.maxImageSize)) {
+    return false;
+  }
+  if (Find(aName, aTexture, aUVTransform)) {
+    return true;
+  }
+  MutexAutoLock lock(m.lock);
+  const int32_t kWidth = aWidth + (2 * kGutter);
+  const int32_t kHeight = aHeight + (2 * kGutter);
+  int32_t x = 0;
+  int32_t y = 0;
+  size_t index = 0;
+  while ((index < m.pages.size()) && !m.Place(m.pages[index], kWidth, kHeight, x, y)) {
+    index++;
+  }
+  if (index == m.pages.size()) {
+    Page* page = m.CreatePage();
+    if (!page || !m.Place(*page, kWidth, kHeight, x, y)) {
+      return false;
+    }
+  }
+  Page& page = m.pages[index];
+  m.Copy(page, aPixels, aWidth, aHeight, x + kGutter, y + kGutter);
+
+  const float kSize = (float)m.pageSize;
+  Region region;
+  region.page = index;
+  region.uvTransform = Matrix::Identity()
+      .ScaleInPlace(Vector((float)aWidth / kSize, (float)aHeight / kSize, 1.0f))
+      .TranslateInPlace(Vector((float)(x + kGutter) / kSize, (float)(y + kGutter) / kSize, 0.0f));
+  m.regions[aName] = region;
+  aTexture = page.texture;
+  aUVTransform = region.uvTransform;
+  return true;
+}
+
+void
+TextureAtlas::UpdateResource(RenderContext& aContext) {
+  MutexAutoLock lock(m.lock);
+  for (Page& page: m.pages) {
+    if (page.dirtyRows.empty()) {
+      continue;
+    }
+    // Merge overlapping ranges, images on the same shelf share their rows.
+    std::sort(page.dirtyRows.begin(), page.dirtyRows.end(), [](const RowRange& aFirst, const RowRange& aSecond) {
+      return aFirst.begin < aSecond.begin;
+    });
+    RowRange range = page.dirtyRows.front();
+    for (const RowRange& rows: page.dirtyRows) {
+      if (rows.begin > range.end) {
+        page.texture->UpdateImageRows(range.begin, range.end - range.begin);
+        range = rows;
+      } else {
+        range.end = std::max(range.end, rows.end);
+      }
+    }
+    page.texture->UpdateImageRows(range.begin, range.end - range.begin);
+    page.dirtyRows.clear();
+  }
+}
+
+TextureAtlas::TextureAtlas(State& aState, CreationContextPtr& aContext) : Updatable(aState, aContext), m(aState) {
+  m.context = aContext;
+}
+
+TextureAtlas::~TextureAtlas() {}
+
+} // namespace vrb
@@ -14,8 +14,10 @@
 #include "vrb/Texture.h"
 #include "vrb/TextureGL.h"
 
+#include <algorithm>
 #include <cstring>
 #include <unordered_map>
+#include <vector>
 
 namespace vrb {
 
@@ -23,8 +25,36 @@ struct TextureCache::State {
   Mutex lock;
   TextureGLPtr defaultTexture;
   std::unordered_map<std::string, TextureGLPtr> cache;
-
+  size_t gpuBudget;
+  size_t cpuBudget;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  std::vector<TextureGL*> candidates;
+
+  State() : gpuBudget(0), cpuBudget(0), hits(0), misses(0), evictions(0) {}
+  // Must be called with lock held.
+  Stats CollectStats() const;
 };
+
+TextureCache::Stats
+TextureCache::State::CollectStats() const {
+  Stats result;
+  result.textures = (uint32_t)cache.size();
+  result.hits = hits;
+  result.misses = misses;
+  result.evictions = evictions;
+  for (const auto& entry: cache) {
+    const size_t gpuBytes = entry.second->GetGPUByteSize();
+    if (gpuBytes > 0) {
+      result.residentTextures++;
+    }
+    result.gpuBytes += gpuBytes;
+    result.cpuBytes += entry.second->GetCPUByteSize();
+  }
+  return result;
+}
+
 TextureCachePtr
 TextureCache::Create() {
   return std::make_shared<ConcreteClass<TextureCache, TextureCache::State> >();
@@ -43,6 +73,7 @@ TextureCache::Init(CreationContextPtr& aContext) {
 
 void
 TextureCache::Shutdown() {
+  MutexAutoLock lock(m.lock);
   m.defaultTexture = nullptr;
   m.cache.clear();
 }
@@ -54,8 +85,10 @@ TextureCache::FindTexture(const std::string& aTextureName) {
 
   std::unordered_map<std::string, TextureGLPtr>::iterator it = m.cache.find(aTextureName);
   if (it != m.cache.end()) {
+    m.hits++;
     return it->second;
   }
+  m.misses++;
 
   return result;
 }
@@ -71,6 +104,62 @@ TextureCache::GetDefaultTexture() {
   return m.defaultTexture;
 }
 
+void
+TextureCache::SetMemoryBudget(const size_t aGPUBytes, const size_t aCPUBytes) {
+  MutexAutoLock lock(m.lock);
+  m.gpuBudget = aGPUBytes;
+  m.cpuBudget = aCPUBytes;
+}
+
+void
+TextureCache::Update() {
+  MutexAutoLock lock(m.lock);
+  if ((m.gpuBudget == 0) && (m.cpuBudget == 0)) {
+    return;
+  }
+  Stats stats = m.CollectStats();
+  const bool kOverGPU = (m.gpuBudget > 0) && (stats.gpuBytes > m.gpuBudget);
+  const bool kOverCPU = (m.cpuBudget > 0) && (stats.cpuBytes > m.cpuBudget);
+  if (!kOverGPU && !kOverCPU) {
+    return;
+  }
+
+  // Only the cache holds a reference to textures that no RenderState or pending
+  // load uses anymore. Textures the loader thread may still be initializing, or that
+  // wait in the upload queue, are left alone.
+  m.candidates.clear();
+  for (auto& entry: m.cache) {
+    TextureGLPtr& texture = entry.second;
+    if ((texture.use_count() == 1) && texture->IsInitialized() && !texture->IsUploading() &&
+        ((texture->GetGPUByteSize() > 0) || (texture->GetCPUByteSize() > 0))) {
+      m.candidates.push_back(texture.get());
+    }
+  }
+  std::sort(m.candidates.begin(), m.candidates.end(), [](const TextureGL* aFirst, const TextureGL* aSecond) {
+    return (int32_t)(aFirst->GetBindSerial() - aSecond->GetBindSerial()) < 0;
+  });
+
+  for (TextureGL* texture: m.candidates) {
+    if (((m.gpuBudget == 0) || (stats.gpuBytes <= m.gpuBudget)) &&
+        ((m.cpuBudget == 0) || (stats.cpuBytes <= m.cpuBudget))) {
+      break;
+    }
+    stats.gpuBytes -= texture->GetGPUByteSize();
+    stats.cpuBytes -= texture->GetCPUByteSize();
+    texture->Evict();
+    stats.gpuBytes += texture->GetGPUByteSize();
+    stats.cpuBytes += texture->GetCPUByteSize();
+    m.evictions++;
+  }
+  m.candidates.clear();
+}
+
+TextureCache::Stats
+TextureCache::GetStats() {
+  MutexAutoLock lock(m.lock);
+  return m.CollectStats();
+}
+
 TextureCache::TextureCache(State& aState) : m(aState) {}
 
 TextureCache::~TextureCache() {}
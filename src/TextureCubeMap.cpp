@@ -134,8 +134,10 @@ TextureCubeMap::State::CreateTexture() {
     VRB_GL_CHECK(glGenTextures(1, &texture));
   }
   VRB_GL_CHECK(glBindTexture(target, texture));
+  // Rows are tightly packed, GL_RGB rows are not always a multiple of four bytes.
+  VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   for (CubeMapFace& face: faces) {
-    const bool isRGB = face.format == GL_RG8 || face.format == GL_RGBA;
+    const bool isRGB = face.format == GL_RG8 || face.format == GL_RGB || face.format == GL_RGBA;
     if (externalTexture && isRGB) {
       VRB_GL_CHECK(glTexSubImage2D(
           face.target,
@@ -186,6 +188,7 @@ TextureCubeMap::State::CreateTexture() {
       face.data = nullptr;
     }
   }
+  VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
 
   for (auto param = intMap.begin(); param != intMap.end(); param++) {
     VRB_GL_CHECK(glTexParameteri(target, param->first, param->second));
@@ -8,17 +8,27 @@
 
 #include "vrb/ConcreteClass.h"
 #include "vrb/CreationContext.h"
+#include "vrb/DataBuffer.h"
 #include "vrb/DataCache.h"
 #include "vrb/GLError.h"
 #include "vrb/Logger.h"
+#include "vrb/TextureStreamer.h"
+#include "vrb/TextureUploadQueue.h"
 #include "vrb/private/ResourceGLState.h"
 
 #include "vrb/gl.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <limits>
 #include <vector>
 
 namespace {
 
+// Resident level of a texture without any uploaded level.
+const GLint kNotResident = std::numeric_limits<GLint>::max();
+
+// One level of one face. The pixels live in the texture's shared image buffer.
 struct MipMap {
   GLenum target;
   GLint level;
@@ -28,9 +38,9 @@ struct MipMap {
   GLint border;
   GLenum format;
   GLenum type;
+  bool compressed;
+  size_t offset;
   GLsizei dataSize;
-  std::unique_ptr<uint8_t[]> data;
-  uint32_t dataCacheHandle;
 
   MipMap()
       : target(GL_TEXTURE_2D)
@@ -41,127 +51,308 @@ struct MipMap {
       , border(0)
       , format(GL_RGB)
       , type(GL_UNSIGNED_BYTE)
+      , compressed(false)
+      , offset(0)
       , dataSize(0)
-      , dataCacheHandle(0)
   {}
-
-  MipMap(MipMap&& aSource)
-      : target(GL_TEXTURE_2D)
-      , level(0)
-      , internalFormat(GL_RGB)
-      , width(0)
-      , height(0)
-      , border(0)
-      , format(GL_RGB)
-      , type(GL_UNSIGNED_BYTE)
-      , dataSize(0)
-      , dataCacheHandle(0)
-  {
-    *this = std::move(aSource);
-  }
-
-  ~MipMap() {
-  }
-
-  MipMap& operator=(MipMap&& aSource) {
-    target = aSource.target;
-    level = aSource.level;
-    internalFormat = aSource.internalFormat;
-    width = aSource.width;
-    height = aSource.height;
-    border = aSource.border;
-    format = aSource.format;
-    type = aSource.type;
-    dataSize = aSource.dataSize;
-    dataCacheHandle = aSource.dataCacheHandle;
-    data = std::move(aSource.data);
-    return *this;
-  }
-
-private:
-  MipMap(const MipMap&) = delete;
-  MipMap& operator=(const MipMap&) = delete;
 };
 
 }
 
 namespace vrb {
 
+static std::atomic<uint32_t> sBindSerial(0);
+
 struct TextureGL::State : public Texture::State, public ResourceGL::State {
+  TextureGLWeak self;
   bool dirty;
   DataCachePtr dataCache;
+  // Image data waiting to be uploaded. It is released after the upload and later
+  // reloaded from either its source file or the DataCache.
+  DataBufferPtr data;
+  std::string sourcePath;
+  size_t dataSize;
+  uint32_t dataCacheHandle;
   std::vector<MipMap> mipMaps;
+  uint32_t bindSerial;
+  TextureUploadQueuePtr uploadQueue;
+  // True while the texture waits in the upload queue.
+  bool queued;
+  // True until the fence following the last queued upload has signaled.
+  bool uploading;
+  // Set once InitializeGL() returns, which may happen on the loader thread.
+  std::atomic<bool> initialized;
+  // Indices in mipMaps of the levels to upload, in upload order.
+  std::vector<size_t> uploads;
+  size_t nextUpload;
+  TextureStreamerPtr streamer;
+  // Finest level kept on the GPU while streaming, -1 when every level is uploaded.
+  GLint streamLevel;
+  // Finest level uploaded to the texture.
+  GLint residentLevel;
+  // Finest level of the uploads listed by PlanUploads(), the stream level may have
+  // changed since.
+  GLint plannedLevel;
+  // True once GL_TEXTURE_BASE_LEVEL has been changed from its default.
+  bool baseLevelSet;
+  bool retainData;
+  // Texture with the finer levels that were dropped, bound until the texture rebuilt
+  // from the coarse levels is complete.
+  GLuint retiredTexture;
 
-  State() : dirty(false) {}
+  State()
+      : dirty(false)
+      , dataSize(0)
+      , dataCacheHandle(0)
+      , bindSerial(0)
+      , queued(false)
+      , uploading(false)
+      , initialized(false)
+      , nextUpload(0)
+      , streamLevel(-1)
+      , residentLevel(kNotResident)
+      , plannedLevel(0)
+      , baseLevelSet(false)
+      , retainData(false)
+      , retiredTexture(0)
+  {}
+  void SetData(const DataBufferPtr& aData);
+  DataBufferPtr LoadData();
+  void ReleaseData();
+  GLint LevelCount() const;
+  void PlanUploads();
+  void UploadLevel(const MipMap& aMipMap, const uint8_t* aPixels);
+  void ApplyParameters();
+  void FinishUploads();
   void CreateTexture();
   void DestroyTexture();
+  void RetireTexture();
+  void DeleteRetiredTexture();
+  void ApplyStreamLevel();
 };
 
 void
-TextureGL::State::CreateTexture() {
-  if (!dirty) {
+TextureGL::State::SetData(const DataBufferPtr& aData) {
+  if (dataCache && (dataCacheHandle > 0)) {
+    dataCache->RemoveData(dataCacheHandle);
+  }
+  dataCacheHandle = 0;
+  data = aData;
+  sourcePath = aData->GetFilePath();
+  dataSize = aData->GetSize();
+  dirty = true;
+  // The new image replaces every level, streaming starts over with it.
+  streamLevel = -1;
+  residentLevel = kNotResident;
+}
+
+DataBufferPtr
+TextureGL::State::LoadData() {
+  if (data) {
+    return data;
+  }
+  DataBufferPtr result;
+  if (!sourcePath.empty()) {
+    result = DataBuffer::CreateFromFile(sourcePath);
+  } else if (dataCache && (dataCacheHandle > 0)) {
+    result = dataCache->LoadBuffer(dataCacheHandle);
+  }
+  if (result && (result->GetSize() != dataSize)) {
+    VRB_ERROR("TextureGL: reloaded image data size changed from %u to %u", (uint32_t)dataSize, (uint32_t)result->GetSize());
+    return nullptr;
+  }
+  return result;
+}
+
+void
+TextureGL::State::ReleaseData() {
+  if (!data || retainData) {
     return;
   }
-  VRB_GL_CHECK(glGenTextures(1, &texture));
-  VRB_GL_CHECK(glBindTexture(target, texture));
-  for (MipMap& mipMap: mipMaps) {
-    if (dataCache && (mipMap.dataCacheHandle > 0)) {
-      dataCache->LoadData(mipMap.dataCacheHandle, mipMap.data);
+  // File backed data is mapped again from its source, so it never needs caching.
+  if (!sourcePath.empty()) {
+    data = nullptr;
+  } else if (dataCache) {
+    if (dataCacheHandle == 0) {
+      dataCacheHandle = dataCache->CacheData(data);
     }
-    if (!mipMap.data) {
-      continue;
+    if (dataCacheHandle > 0) {
+      data = nullptr;
     }
+  }
+}
 
-    if (mipMap.format == GL_RG8 || mipMap.format == GL_RGBA) {
-      VRB_GL_CHECK(glTexImage2D(
-          mipMap.target,
-          mipMap.level,
-          mipMap.internalFormat,
-          mipMap.width,
-          mipMap.height,
-          mipMap.border,
-          mipMap.format,
-          mipMap.type,
-          (void*)mipMap.data.get()));
-    } else {
-      VRB_GL_CHECK(glCompressedTexImage2D(
-          mipMap.target,
-          mipMap.level,
-          mipMap.internalFormat,
-          mipMap.width,
-          mipMap.height,
-          mipMap.border,
-          mipMap.dataSize,
-          (void*)mipMap.data.get()));
-    }
+GLint
+TextureGL::State::LevelCount() const {
+  GLint result = 0;
+  for (const MipMap& mipMap: mipMaps) {
+    result = std::max(result, mipMap.level + 1);
+  }
+  return result;
+}
 
-    if (dataCache) {
-      if (mipMap.dataCacheHandle == 0) {
-        mipMap.dataCacheHandle = dataCache->CacheData(mipMap.data, (size_t)mipMap.dataSize);
-      } else {
-        mipMap.data = nullptr;
-      }
+// Lists the levels between the stream level and the resident level. Streamed
+// textures upload the coarsest level first.
+void
+TextureGL::State::PlanUploads() {
+  if ((streamLevel < 0) && streamer && streamer->IsEnabled() && (LevelCount() > 1)) {
+    TextureGLPtr texture = self.lock();
+    if (texture) {
+      streamLevel = streamer->GetCoarseLevel(mipMaps.front().width, mipMaps.front().height, LevelCount());
+      streamer->Add(texture);
+    }
+  }
+  uploads.clear();
+  const GLint kFinest = std::max(streamLevel, 0);
+  plannedLevel = kFinest;
+  for (size_t ix = 0; ix < mipMaps.size(); ix++) {
+    if ((mipMaps[ix].level >= kFinest) && (mipMaps[ix].level < residentLevel)) {
+      uploads.push_back(ix);
     }
   }
+  if (streamLevel >= 0) {
+    std::stable_sort(uploads.begin(), uploads.end(), [this](const size_t aFirst, const size_t aSecond) {
+      return mipMaps[aFirst].level > mipMaps[aSecond].level;
+    });
+  }
+}
 
+void
+TextureGL::State::UploadLevel(const MipMap& aMipMap, const uint8_t* aPixels) {
+  if (!aMipMap.compressed) {
+    // Rows are tightly packed, GL_RGB rows are not always a multiple of four bytes.
+    VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    VRB_GL_CHECK(glTexImage2D(
+        aMipMap.target,
+        aMipMap.level,
+        aMipMap.internalFormat,
+        aMipMap.width,
+        aMipMap.height,
+        aMipMap.border,
+        aMipMap.format,
+        aMipMap.type,
+        (void*)aPixels));
+    VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  } else {
+    VRB_GL_CHECK(glCompressedTexImage2D(
+        aMipMap.target,
+        aMipMap.level,
+        aMipMap.internalFormat,
+        aMipMap.width,
+        aMipMap.height,
+        aMipMap.border,
+        aMipMap.dataSize,
+        (void*)aPixels));
+  }
+}
+
+void
+TextureGL::State::ApplyParameters() {
   for (auto param = intMap.begin(); param != intMap.end(); param++) {
     VRB_GL_CHECK(glTexParameteri(target, param->first, param->second));
   }
+}
+
+// Called with the texture bound once the planned levels are uploaded.
+void
+TextureGL::State::FinishUploads() {
+  DeleteRetiredTexture();
+  residentLevel = std::min(residentLevel, plannedLevel);
+  ApplyParameters();
+  if ((streamLevel >= 0) || baseLevelSet) {
+    VRB_GL_CHECK(glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, residentLevel));
+    baseLevelSet = true;
+  }
+}
+
+void
+TextureGL::State::CreateTexture() {
+  if (!dirty) {
+    return;
+  }
+  if (uploadQueue && uploadQueue->IsEnabled()) {
+    TextureGLPtr texture = self.lock();
+    if (!queued && texture) {
+      queued = true;
+      uploading = true;
+      PlanUploads();
+      nextUpload = 0;
+      uploadQueue->Enqueue(texture);
+    }
+    return;
+  }
+  if (texture == 0) {
+    VRB_GL_CHECK(glGenTextures(1, &texture));
+  }
+  VRB_GL_CHECK(glBindTexture(target, texture));
+  PlanUploads();
+  DataBufferPtr buffer = LoadData();
+  if (buffer) {
+    for (const size_t index: uploads) {
+      UploadLevel(mipMaps[index], buffer->GetData() + mipMaps[index].offset);
+    }
+    FinishUploads();
+  } else {
+    ApplyParameters();
+  }
+  ReleaseData();
   dirty = false;
+  ApplyStreamLevel();
 }
 
 void
 TextureGL::State::DestroyTexture() {
+  DeleteRetiredTexture();
   if (texture > 0) {
     VRB_GL_CHECK(glDeleteTextures(1, &texture));
     texture = 0;
   }
+  residentLevel = kNotResident;
+  baseLevelSet = false;
   dirty = true;
+  // Queued uploads are dropped, the texture is queued again when it is next bound.
+  queued = false;
+  uploading = false;
+}
+
+// Like DestroyTexture() but the texture stays bound until its replacement is complete.
+void
+TextureGL::State::RetireTexture() {
+  GLuint current = texture;
+  texture = 0;
+  DestroyTexture();
+  retiredTexture = current;
+}
+
+void
+TextureGL::State::DeleteRetiredTexture() {
+  if (retiredTexture > 0) {
+    VRB_GL_CHECK(glDeleteTextures(1, &retiredTexture));
+    retiredTexture = 0;
+  }
+}
+
+// Uploads the missing levels down to the stream level, or recreates the texture
+// without the levels finer than it.
+void
+TextureGL::State::ApplyStreamLevel() {
+  if ((streamLevel < 0) || (texture == 0) || (residentLevel == kNotResident)) {
+    return;
+  }
+  if (streamLevel > residentLevel) {
+    // Levels can not be removed from a texture, so it is created again from the
+    // remaining coarse levels. The old texture is drawn until then, not the placeholder.
+    RetireTexture();
+  } else if (streamLevel < residentLevel) {
+    dirty = true;
+  }
 }
 
 TextureGLPtr
 TextureGL::Create(CreationContextPtr& aContext) {
-  return std::make_shared<ConcreteClass<TextureGL, TextureGL::State> >(aContext);
+  TextureGLPtr result = std::make_shared<ConcreteClass<TextureGL, TextureGL::State> >(aContext);
+  result->m.self = result;
+  return result;
 }
 
 void
@@ -178,26 +369,102 @@ TextureGL::SetImageData(std::unique_ptr<uint8_t[]>& aImage, const uint64_t aImag
   mipMap.width = aWidth;
   mipMap.height = aHeight;
   mipMap.dataSize = (GLsizei) aImageLength;
-  mipMap.data = std::move(aImage);
   mipMap.internalFormat = aFormat;
   mipMap.format = aFormat;
+  mipMap.compressed = (aFormat != GL_RG8) && (aFormat != GL_RGB) && (aFormat != GL_RGBA);
+  m.target = GL_TEXTURE_2D;
   m.mipMaps.clear();
-  m.mipMaps.push_back(std::move(mipMap));
-  m.dirty = true;
+  m.mipMaps.push_back(mipMap);
+  m.SetData(DataBuffer::Create(aImage, (size_t)aImageLength));
+}
+
+void
+TextureGL::SetImageLevels(const DataBufferPtr& aImage, const ImageLayout& aLayout) {
+  if (!aImage || aLayout.levels.empty()) {
+    return;
+  }
+
+  std::vector<MipMap> mipMaps;
+  GLint maxLevel = 0;
+  for (const ImageLayout::Level& level: aLayout.levels) {
+    if ((level.width <= 0) || (level.height <= 0) || (level.size > aImage->GetSize()) ||
+        (level.offset > (aImage->GetSize() - level.size))) {
+      VRB_ERROR("TextureGL: invalid image level %d, %dx%d", level.level, level.width, level.height);
+      return;
+    }
+    MipMap mipMap;
+    mipMap.target = level.target;
+    mipMap.level = level.level;
+    mipMap.width = level.width;
+    mipMap.height = level.height;
+    mipMap.internalFormat = aLayout.internalFormat;
+    mipMap.format = aLayout.format;
+    mipMap.type = aLayout.type;
+    mipMap.compressed = aLayout.compressed;
+    mipMap.offset = level.offset;
+    mipMap.dataSize = (GLsizei) level.size;
+    mipMaps.push_back(mipMap);
+    maxLevel = std::max(maxLevel, level.level);
+  }
+
+  // A truncated mip chain is only complete when the last level is set explicitly.
+  const MipMap& base = mipMaps.front();
+  GLint fullLevels = 1;
+  for (GLsizei size = std::max(base.width, base.height); size > 1; size >>= 1) {
+    fullLevels++;
+  }
+  if ((maxLevel > 0) && ((maxLevel + 1) < fullLevels)) {
+    m.intMap[GL_TEXTURE_MAX_LEVEL] = maxLevel;
+  } else {
+    m.intMap.erase(GL_TEXTURE_MAX_LEVEL);
+  }
+  m.target = aLayout.target;
+  m.mipMaps = std::move(mipMaps);
+  m.SetData(aImage);
+}
+
+void
+TextureGL::SetRetainImageData(const bool aRetain) {
+  m.retainData = aRetain;
+}
+
+void
+TextureGL::UpdateImageRows(const GLint aY, const GLsizei aHeight) {
+  if (m.dirty || (m.texture == 0) || !m.data || m.mipMaps.empty()) {
+    return;
+  }
+  const MipMap& base = m.mipMaps.front();
+  if (base.compressed || (base.target != GL_TEXTURE_2D) || (base.level != 0)) {
+    VRB_ERROR("TextureGL: %s rows can only be updated in uncompressed 2D textures", m.name.c_str());
+    return;
+  }
+  const GLint kBegin = std::max(aY, 0);
+  const GLint kEnd = std::min(aY + aHeight, base.height);
+  if (kBegin >= kEnd) {
+    return;
+  }
+  // Whole rows are contiguous in the image, GLES 2 has no GL_UNPACK_ROW_LENGTH.
+  const size_t kStride = (size_t)base.dataSize / (size_t)base.height;
+  VRB_GL_CHECK(glBindTexture(m.target, m.texture));
+  VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  VRB_GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, kBegin, base.width, kEnd - kBegin, base.format, base.type,
+                               m.data->GetData() + base.offset + ((size_t)kBegin * kStride)));
+  VRB_GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  VRB_GL_CHECK(glBindTexture(m.target, 0));
 }
 
 TextureGL::TextureGL(State& aState, CreationContextPtr& aContext) : Texture(aState, aContext), ResourceGL (aState, aContext), m(aState) {
   m.dataCache = aContext->GetDataCache();
+  m.uploadQueue = aContext->GetTextureUploadQueue();
+  m.streamer = aContext->GetTextureStreamer();
 }
 TextureGL::~TextureGL() {
   if (!m.dataCache) {
     return;
   }
-  for (MipMap& mipMap: m.mipMaps) {
-    if (mipMap.dataCacheHandle > 0) {
-      m.dataCache->RemoveData(mipMap.dataCacheHandle);
-      mipMap.dataCacheHandle = 0;
-    }
+  if (m.dataCacheHandle > 0) {
+    m.dataCache->RemoveData(m.dataCacheHandle);
+    m.dataCacheHandle = 0;
   }
 }
 
@@ -217,23 +484,177 @@ TextureGL::GetHeight() const {
   return 0;
 }
 
+size_t
+TextureGL::GetGPUByteSize() const {
+  if (m.texture == 0) {
+    return 0;
+  }
+  return GetLevelsByteSize(m.residentLevel);
+}
+
+size_t
+TextureGL::GetCPUByteSize() const {
+  return m.data ? m.data->GetSize() : 0;
+}
+
+uint32_t
+TextureGL::GetBindSerial() const {
+  return m.bindSerial;
+}
+
+void
+TextureGL::SetUploadQueue(const TextureUploadQueuePtr& aQueue) {
+  m.uploadQueue = aQueue;
+}
+
+bool
+TextureGL::IsUploading() const {
+  return m.uploading;
+}
+
+bool
+TextureGL::IsInitialized() const {
+  return m.initialized;
+}
+
+void
+TextureGL::SetTextureStreamer(const TextureStreamerPtr& aStreamer) {
+  m.streamer = aStreamer;
+}
+
+GLint
+TextureGL::GetLevelCount() const {
+  return m.LevelCount();
+}
+
+GLint
+TextureGL::GetStreamLevel() const {
+  return m.streamLevel;
+}
+
+GLint
+TextureGL::GetResidentLevel() const {
+  return std::min(m.residentLevel, m.LevelCount());
+}
+
+size_t
+TextureGL::GetLevelsByteSize(const GLint aLevel) const {
+  size_t result = 0;
+  for (const MipMap& mipMap: m.mipMaps) {
+    if (mipMap.level >= aLevel) {
+      result += (size_t)mipMap.dataSize;
+    }
+  }
+  return result;
+}
+
+void
+TextureGL::SetStreamLevel(const GLint aLevel) {
+  if (m.streamLevel < 0) {
+    return;
+  }
+  const GLint kLevel = std::max(0, std::min(aLevel, m.LevelCount() - 1));
+  if (kLevel == m.streamLevel) {
+    return;
+  }
+  m.streamLevel = kLevel;
+  // A queued upload keeps the levels it planned, the new level is applied once it is done.
+  if (!m.queued) {
+    m.ApplyStreamLevel();
+  }
+}
+
+bool
+TextureGL::UploadQueued(TextureUploadQueue& aQueue, size_t& aBudget) {
+  if (!m.queued) {
+    return true;
+  }
+  if (m.texture == 0) {
+    VRB_GL_CHECK(glGenTextures(1, &m.texture));
+  }
+  VRB_GL_CHECK(glBindTexture(m.target, m.texture));
+  // Keep the data around until every level has been staged.
+  m.data = m.LoadData();
+  if (m.data) {
+    while ((m.nextUpload < m.uploads.size()) && (aBudget > 0)) {
+      const MipMap& mipMap = m.mipMaps[m.uploads[m.nextUpload]];
+      const uint8_t* pixels = m.data->GetData() + mipMap.offset;
+      m.UploadLevel(mipMap, aQueue.Stage(pixels, (size_t)mipMap.dataSize) ? nullptr : pixels);
+      aBudget -= std::min(aBudget, (size_t)mipMap.dataSize);
+      m.nextUpload++;
+    }
+    if (m.nextUpload < m.uploads.size()) {
+      VRB_GL_CHECK(glBindTexture(m.target, 0));
+      return false;
+    }
+    m.FinishUploads();
+  } else {
+    m.ApplyParameters();
+  }
+  m.ReleaseData();
+  VRB_GL_CHECK(glBindTexture(m.target, 0));
+  m.dirty = false;
+  m.queued = false;
+  m.ApplyStreamLevel();
+  return true;
+}
+
+void
+TextureGL::FinishUpload() {
+  if (!m.queued) {
+    m.uploading = false;
+  }
+}
+
+void
+TextureGL::Evict() {
+  m.DestroyTexture();
+  m.ReleaseData();
+}
+
 void
 TextureGL::AboutToBind() {
+  m.bindSerial = ++sBindSerial;
   m.CreateTexture();
 }
 
+GLuint
+TextureGL::GetBindHandle() const {
+  // Streamed textures keep sampling their coarse levels while finer levels upload.
+  if (!m.uploading || (m.residentLevel != kNotResident)) {
+    return m.texture;
+  }
+  if (m.retiredTexture > 0) {
+    return m.retiredTexture;
+  }
+  TextureGLPtr placeholder = m.uploadQueue ? m.uploadQueue->GetPlaceholder() : nullptr;
+  if (!placeholder || (placeholder.get() == this) || (placeholder->m.target != m.target)) {
+    return 0;
+  }
+  placeholder->m.CreateTexture();
+  return placeholder->m.texture;
+}
+
 bool
 TextureGL::SupportOffRenderThreadInitialization() {
   return true;
 }
 
+// The placeholder texture is drawn until the texture is created.
+ResourceGL::Priority
+TextureGL::GetInitializationPriority() {
+  return Priority::Low;
+}
+
 void
 TextureGL::InitializeGL() {
   m.CreateTexture();
+  m.initialized = true;
 }
 
 void
 TextureGL::ShutdownGL() {
+  m.initialized = false;
   m.DestroyTexture();
 }
 
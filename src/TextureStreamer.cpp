@@ -0,0 +1,276 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/TextureStreamer.h"
+#include "vrb/ConcreteClass.h"
+
+#include "vrb/Logger.h"
+#include "vrb/Mutex.h"
+#include "vrb/TextureGL.h"
+
+#include "vrb/gl.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const GLsizei kDefaultCoarseSize = 64;
+// Frames a texture is kept at its requested level after it was last drawn.
+const uint32_t kReleaseFrames = 60;
+
+struct Entry {
+  vrb::TextureGLWeak texture;
+  // Largest size requested since the last Update.
+  float pixels;
+  // Size used for the last frame the texture was drawn.
+  float lastPixels;
+  uint32_t lastFrame;
+  Entry() : pixels(0.0f), lastPixels(0.0f), lastFrame(0) {}
+};
+
+struct Plan {
+  vrb::TextureGLPtr texture;
+  float pixels;
+  GLint level;
+  GLint coarse;
+};
+
+}
+
+namespace vrb {
+
+struct TextureStreamer::State {
+  Mutex lock;
+  std::atomic<bool> supported;
+  std::atomic<bool> enabled;
+  std::atomic<int32_t> sizeSources;
+  size_t budget;
+  GLsizei coarseSize;
+  int32_t viewportHeight;
+  float levelBias;
+  uint32_t frame;
+  size_t residentSize;
+  // Guarded by lock, textures are added from any thread.
+  std::unordered_map<const Texture*, Entry> entries;
+  std::vector<Plan> plans;
+
+  State()
+      : supported(false)
+      , enabled(false)
+      , sizeSources(0)
+      , budget(0)
+      , coarseSize(kDefaultCoarseSize)
+      , viewportHeight(1024)
+      , levelBias(0.0f)
+      , frame(0)
+      , residentSize(0)
+  {}
+  GLint SelectLevel(const TextureGL& aTexture, const float aPixels, const GLint aCoarse) const;
+};
+
+// Picks the level whose size is closest to, but not smaller than, the size on screen.
+GLint
+TextureStreamer::State::SelectLevel(const TextureGL& aTexture, const float aPixels, const GLint aCoarse) const {
+  if (aPixels <= 0.0f) {
+    return aCoarse;
+  }
+  const float size = (float)std::max(aTexture.GetWidth(), aTexture.GetHeight());
+  const float level = std::floor(std::log2(size / aPixels) + levelBias);
+  if (level <= 0.0f) {
+    return 0;
+  }
+  return std::min((GLint)level, aCoarse);
+}
+
+TextureStreamerPtr
+TextureStreamer::Create() {
+  return std::make_shared<ConcreteClass<TextureStreamer, TextureStreamer::State> >();
+}
+
+void
+TextureStreamer::InitializeGL(const bool aSupported) {
+  m.supported = aSupported;
+}
+
+void
+TextureStreamer::SetEnabled(const bool aEnabled) {
+  m.enabled = aEnabled;
+  if (aEnabled && (m.sizeSources == 0)) {
+    VRB_WARN("TextureStreamer stays off until a CompiledScene reports sizes, see CompiledScene::SetTextureStreamer()");
+  }
+}
+
+bool
+TextureStreamer::IsEnabled() const {
+  // Without reported sizes every texture would be pinned to its coarse levels.
+  return m.enabled && m.supported && (m.sizeSources > 0);
+}
+
+void
+TextureStreamer::SetBudget(const size_t aBytes) {
+  m.budget = aBytes;
+}
+
+void
+TextureStreamer::SetCoarseSize(const GLsizei aPixels) {
+  m.coarseSize = std::max(aPixels, 1);
+}
+
+void
+TextureStreamer::SetViewportHeight(const int32_t aPixels) {
+  m.viewportHeight = aPixels;
+}
+
+int32_t
+TextureStreamer::GetViewportHeight() const {
+  return m.viewportHeight;
+}
+
+void
+TextureStreamer::SetLevelBias(const float aBias) {
+  m.levelBias = aBias;
+}
+
+GLint
+TextureStreamer::GetCoarseLevel(const GLsizei aWidth, const GLsizei aHeight, const GLint aLevelCount) const {
+  GLint result = 0;
+  GLsizei size = std::max(aWidth, aHeight);
+  while ((size > m.coarseSize) && ((result + 1) < aLevelCount)) {
+    size >>= 1;
+    result++;
+  }
+  return result;
+}
+
+void
+TextureStreamer::RequestSize(const Texture* aTexture, const float aPixels) {
+  if (!aTexture) {
+    return;
+  }
+  MutexAutoLock lock(m.lock);
+  auto entry = m.entries.find(aTexture);
+  if (entry == m.entries.end()) {
+    return;
+  }
+  entry->second.pixels = std::max(entry->second.pixels, aPixels);
+  entry->second.lastFrame = m.frame;
+}
+
+int32_t
+TextureStreamer::GetTextureCount() const {
+  MutexAutoLock lock(m.lock);
+  return (int32_t)m.entries.size();
+}
+
+size_t
+TextureStreamer::GetResidentByteSize() const {
+  return m.residentSize;
+}
+
+void
+TextureStreamer::Update() {
+  m.plans.clear();
+  if (!IsEnabled()) {
+    // Streamed textures get all of their levels back while streaming is off.
+    MutexAutoLock lock(m.lock);
+    for (auto iter = m.entries.begin(); iter != m.entries.end(); iter++) {
+      TextureGLPtr texture = iter->second.texture.lock();
+      if (texture && (texture->GetStreamLevel() > 0)) {
+        texture->SetStreamLevel(0);
+      }
+    }
+    return;
+  }
+  {
+    MutexAutoLock lock(m.lock);
+    for (auto iter = m.entries.begin(); iter != m.entries.end();) {
+      Entry& entry = iter->second;
+      Plan plan;
+      plan.texture = entry.texture.lock();
+      if (!plan.texture) {
+        iter = m.entries.erase(iter);
+        continue;
+      }
+      if (entry.lastFrame == m.frame) {
+        entry.lastPixels = entry.pixels;
+      } else if ((m.frame - entry.lastFrame) > kReleaseFrames) {
+        entry.lastPixels = 0.0f;
+      }
+      entry.pixels = 0.0f;
+      plan.pixels = entry.lastPixels;
+      m.plans.push_back(plan);
+      iter++;
+    }
+    m.frame++;
+  }
+
+  size_t total = 0;
+  for (Plan& plan: m.plans) {
+    TextureGL& texture = *plan.texture;
+    plan.coarse = GetCoarseLevel(texture.GetWidth(), texture.GetHeight(), texture.GetLevelCount());
+    plan.level = m.SelectLevel(texture, plan.pixels, plan.coarse);
+    // Keep one finer level than needed while the texture is drawn, so levels are not
+    // dropped and reloaded over and over when its size is close to a level boundary.
+    const GLint current = texture.GetStreamLevel();
+    if ((current >= 0) && (plan.level == (current + 1)) && (plan.pixels > 0.0f)) {
+      plan.level = current;
+    }
+    total += texture.GetLevelsByteSize(plan.coarse);
+  }
+
+  std::sort(m.plans.begin(), m.plans.end(), [](const Plan& aFirst, const Plan& aSecond) {
+    return aFirst.pixels > aSecond.pixels;
+  });
+  for (Plan& plan: m.plans) {
+    TextureGL& texture = *plan.texture;
+    const size_t kCoarseSize = texture.GetLevelsByteSize(plan.coarse);
+    if (m.budget > 0) {
+      while ((plan.level < plan.coarse) && ((total + texture.GetLevelsByteSize(plan.level) - kCoarseSize) > m.budget)) {
+        plan.level++;
+      }
+    }
+    total += texture.GetLevelsByteSize(plan.level) - kCoarseSize;
+    // Levels change again once the current upload is done.
+    if ((plan.level != texture.GetStreamLevel()) && !texture.IsUploading()) {
+      texture.SetStreamLevel(plan.level);
+    }
+  }
+
+  m.residentSize = 0;
+  for (Plan& plan: m.plans) {
+    m.residentSize += plan.texture->GetGPUByteSize();
+  }
+  m.plans.clear();
+}
+
+void
+TextureStreamer::Add(const TextureGLPtr& aTexture) {
+  if (!aTexture) {
+    return;
+  }
+  MutexAutoLock lock(m.lock);
+  Entry& entry = m.entries[aTexture.get()];
+  entry = Entry();
+  entry.texture = aTexture;
+  entry.lastFrame = m.frame;
+}
+
+void
+TextureStreamer::AddSizeSource() {
+  m.sizeSources++;
+}
+
+void
+TextureStreamer::RemoveSizeSource() {
+  m.sizeSources--;
+}
+
+TextureStreamer::TextureStreamer(State& aState) : m(aState) {}
+TextureStreamer::~TextureStreamer() {}
+
+} // namespace vrb
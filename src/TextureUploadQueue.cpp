@@ -0,0 +1,255 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/TextureUploadQueue.h"
+#include "vrb/ConcreteClass.h"
+
+#include "vrb/GLError.h"
+#include "vrb/Logger.h"
+#include "vrb/Mutex.h"
+#include "vrb/TextureGL.h"
+
+#include "vrb/gl.h"
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace {
+
+const size_t kDefaultFrameBudget = 4 * 1024 * 1024;
+const size_t kStagingGranularity = 64 * 1024;
+const size_t kMaxFreeStagingBuffers = 4;
+
+struct StagingBuffer {
+  GLuint buffer;
+  size_t capacity;
+  StagingBuffer() : buffer(0), capacity(0) {}
+};
+
+// Staging buffers and textures whose uploads were issued in the same frame. They are
+// released once the fence inserted after the uploads has signaled.
+struct Batch {
+  GLsync fence;
+  std::vector<StagingBuffer> buffers;
+  std::vector<vrb::TextureGLWeak> textures;
+  Batch() : fence(nullptr) {}
+};
+
+}
+
+namespace vrb {
+
+struct TextureUploadQueue::State {
+  Mutex lock;
+  std::atomic<bool> enabled;
+  size_t frameBudget;
+  TextureGLWeak placeholder;
+  // Guarded by lock, textures may be queued from any thread.
+  std::deque<TextureGLWeak> queued;
+  // Only used on the render thread.
+  std::deque<TextureGLWeak> active;
+  std::vector<StagingBuffer> freeBuffers;
+  std::deque<Batch> inFlight;
+  Batch current;
+
+  State() : enabled(false), frameBudget(kDefaultFrameBudget) {}
+  void Retire();
+  void Release();
+};
+
+void
+TextureUploadQueue::State::Retire() {
+  while (!inFlight.empty()) {
+    Batch& batch = inFlight.front();
+    if (batch.fence) {
+      const GLenum status = glClientWaitSync(batch.fence, 0, 0);
+      if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED)) {
+        // Fences signal in order, later batches are not done either.
+        return;
+      }
+      VRB_GL_CHECK(glDeleteSync(batch.fence));
+    }
+    for (StagingBuffer& buffer: batch.buffers) {
+      if (freeBuffers.size() < kMaxFreeStagingBuffers) {
+        freeBuffers.push_back(buffer);
+      } else {
+        VRB_GL_CHECK(glDeleteBuffers(1, &buffer.buffer));
+      }
+    }
+    for (TextureGLWeak& weak: batch.textures) {
+      TextureGLPtr texture = weak.lock();
+      if (texture) {
+        texture->FinishUpload();
+      }
+    }
+    inFlight.pop_front();
+  }
+}
+
+void
+TextureUploadQueue::State::Release() {
+  inFlight.push_back(std::move(current));
+  current = Batch();
+  for (Batch& batch: inFlight) {
+    if (batch.fence) {
+      VRB_GL_CHECK(glDeleteSync(batch.fence));
+    }
+    for (StagingBuffer& buffer: batch.buffers) {
+      VRB_GL_CHECK(glDeleteBuffers(1, &buffer.buffer));
+    }
+  }
+  inFlight.clear();
+  for (StagingBuffer& buffer: freeBuffers) {
+    VRB_GL_CHECK(glDeleteBuffers(1, &buffer.buffer));
+  }
+  freeBuffers.clear();
+}
+
+TextureUploadQueuePtr
+TextureUploadQueue::Create() {
+  return std::make_shared<ConcreteClass<TextureUploadQueue, TextureUploadQueue::State> >();
+}
+
+void
+TextureUploadQueue::InitializeGL(const bool aSupported) {
+  m.enabled = aSupported;
+}
+
+void
+TextureUploadQueue::ShutdownGL() {
+  m.Release();
+  m.active.clear();
+  MutexAutoLock lock(m.lock);
+  m.queued.clear();
+}
+
+bool
+TextureUploadQueue::IsEnabled() const {
+  return m.enabled;
+}
+
+void
+TextureUploadQueue::SetFrameBudget(const size_t aBytes) {
+  m.frameBudget = aBytes;
+}
+
+void
+TextureUploadQueue::SetPlaceholder(const TextureGLPtr& aTexture) {
+  MutexAutoLock lock(m.lock);
+  m.placeholder = aTexture;
+}
+
+TextureGLPtr
+TextureUploadQueue::GetPlaceholder() {
+  MutexAutoLock lock(m.lock);
+  return m.placeholder.lock();
+}
+
+uint32_t
+TextureUploadQueue::GetPendingCount() {
+  size_t result = m.active.size();
+  for (const Batch& batch: m.inFlight) {
+    result += batch.textures.size();
+  }
+  MutexAutoLock lock(m.lock);
+  return (uint32_t)(result + m.queued.size());
+}
+
+void
+TextureUploadQueue::Enqueue(const TextureGLPtr& aTexture) {
+  MutexAutoLock lock(m.lock);
+  m.queued.push_back(aTexture);
+}
+
+void
+TextureUploadQueue::Update() {
+  if (!m.enabled) {
+    return;
+  }
+  m.Retire();
+  {
+    MutexAutoLock lock(m.lock);
+    while (!m.queued.empty()) {
+      m.active.push_back(std::move(m.queued.front()));
+      m.queued.pop_front();
+    }
+  }
+  if (m.active.empty()) {
+    return;
+  }
+
+  size_t budget = m.frameBudget > 0 ? m.frameBudget : kDefaultFrameBudget;
+  while (!m.active.empty() && (budget > 0)) {
+    TextureGLPtr texture = m.active.front().lock();
+    if (!texture) {
+      m.active.pop_front();
+      continue;
+    }
+    if (texture->UploadQueued(*this, budget)) {
+      m.current.textures.push_back(texture);
+      m.active.pop_front();
+    }
+  }
+  VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+  if (m.current.buffers.empty() && m.current.textures.empty()) {
+    return;
+  }
+  VRB_GL_CHECK(m.current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+  m.inFlight.push_back(std::move(m.current));
+  m.current = Batch();
+}
+
+bool
+TextureUploadQueue::Stage(const uint8_t* aData, const size_t aSize) {
+  if (!m.enabled || !aData || (aSize == 0)) {
+    VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    return false;
+  }
+  // Use the smallest free buffer that fits.
+  auto found = m.freeBuffers.end();
+  for (auto it = m.freeBuffers.begin(); it != m.freeBuffers.end(); it++) {
+    if ((it->capacity >= aSize) && ((found == m.freeBuffers.end()) || (it->capacity < found->capacity))) {
+      found = it;
+    }
+  }
+  StagingBuffer staging;
+  if (found != m.freeBuffers.end()) {
+    staging = *found;
+    m.freeBuffers.erase(found);
+    VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer));
+  } else {
+    staging.capacity = ((aSize + kStagingGranularity - 1) / kStagingGranularity) * kStagingGranularity;
+    VRB_GL_CHECK(glGenBuffers(1, &staging.buffer));
+    VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer));
+    VRB_GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)staging.capacity, nullptr, GL_STREAM_DRAW));
+  }
+  // The fence of the buffer's previous batch has signaled, so no synchronization is needed.
+  void* mapped = nullptr;
+  VRB_GL_CHECK(mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)aSize,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+  if (!mapped) {
+    VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    VRB_GL_CHECK(glDeleteBuffers(1, &staging.buffer));
+    return false;
+  }
+  memcpy(mapped, aData, aSize);
+  GLboolean unmapped = GL_FALSE;
+  VRB_GL_CHECK(unmapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+  if (!unmapped) {
+    VRB_WARN("TextureUploadQueue: staging buffer contents lost");
+    VRB_GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    VRB_GL_CHECK(glDeleteBuffers(1, &staging.buffer));
+    return false;
+  }
+  m.current.buffers.push_back(staging);
+  return true;
+}
+
+TextureUploadQueue::TextureUploadQueue(State& aState) : m(aState) {}
+TextureUploadQueue::~TextureUploadQueue() {}
+
+} // namespace vrb
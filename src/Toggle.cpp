@@ -35,11 +35,20 @@ Toggle::RemoveNode(Node& aNode) {
 void
 Toggle::ToggleAll(const bool aEnabled) {
   if (aEnabled) {
-    m.toggledOff.clear();
+    if (!m.toggledOff.empty()) {
+      GraphChanged();
+      m.toggledOff.clear();
+    }
     return;
   }
+  const size_t kCount = m.toggledOff.size();
   for (const NodePtr& node: m.children) {
-    m.toggledOff.insert(node.get());
+    if (node) {
+      m.toggledOff.insert(node.get());
+    }
+  }
+  if (m.toggledOff.size() != kCount) {
+    GraphChanged();
   }
 }
 
@@ -53,15 +62,15 @@ Toggle::ToggleChild(const Node& aNode, const bool aEnabled) {
   if (!m.Contains(aNode)) {
     return;
   }
-  if (aEnabled) {
-    m.toggledOff.erase(&aNode);
-    return;
+  const bool kChanged = aEnabled ? (m.toggledOff.erase(&aNode) > 0) : m.toggledOff.insert(&aNode).second;
+  if (kChanged) {
+    GraphChanged();
   }
-
-  m.toggledOff.insert(&aNode);
 }
 
-Toggle::Toggle(State& aState, CreationContextPtr& aContext) : Group(aState, aContext), m(aState) {}
+Toggle::Toggle(State& aState, CreationContextPtr& aContext) : Group(aState, aContext), m(aState) {
+  m.kind |= KindToggle;
+}
 Toggle::~Toggle() {}
 
 } // namespace vrb
@@ -29,22 +29,20 @@ Transform::Cull(CullVisitor& aVisitor, DrawableList& aDrawables) {
 
 const Matrix
 Transform::GetWorldTransform() const {
-  Matrix result = m.transform;
-  std::vector<GroupPtr> parents;
-  GetParents(parents);
-  while (parents.size() > 0) {
-    if (parents.size() > 1) {
-      VRB_WARN("Calculating world transform where node has more than one parent");
-    }
-    GroupPtr parent = parents[0];
-    TransformPtr transform = std::dynamic_pointer_cast<Transform>(parent);
-    if (transform) {
-      result.PreMultiplyInPlace(transform->GetTransform());
+  if (!m.worldDirty) {
+    return m.worldTransform;
+  }
+  m.worldTransform = m.transform;
+  GroupPtr parent = GetFirstParent(*this);
+  while (parent) {
+    if (parent->IsKind(KindTransform)) {
+      m.worldTransform.PreMultiplyInPlace(static_cast<Transform*>(parent.get())->GetWorldTransform());
+      break;
     }
-    parents.clear();
-    parent->GetParents(parents);
+    parent = GetFirstParent(*parent);
   }
-  return result;
+  m.worldDirty = false;
+  return m.worldTransform;
 }
 
 const Matrix&
@@ -55,9 +53,23 @@ Transform::GetTransform() const {
 void
 Transform::SetTransform(const Matrix& aTransform) {
   m.transform = aTransform;
+  BoundsChanged();
+  InvalidateWorldTransform();
 }
 
-Transform::Transform(State& aState, CreationContextPtr& aContext) : Group(aState, aContext), m(aState) {}
+void
+Transform::InvalidateWorldTransform() {
+  // Descendants of a dirty Transform are already dirty.
+  if (m.worldDirty) {
+    return;
+  }
+  m.worldDirty = true;
+  Group::InvalidateWorldTransform();
+}
+
+Transform::Transform(State& aState, CreationContextPtr& aContext) : Group(aState, aContext), m(aState) {
+  m.kind |= KindTransform;
+}
 Transform::~Transform() {}
 
 }
@@ -0,0 +1,94 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vrb/UniformBuffer.h"
+#include "vrb/private/ResourceGLState.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/GLError.h"
+
+#include <cstring>
+#include <memory>
+
+namespace vrb {
+
+struct UniformBuffer::State : public ResourceGL::State {
+  GLuint buffer;
+  GLsizeiptr size;
+  std::unique_ptr<uint8_t[]> shadow;
+  uint32_t version;
+  State() : buffer(0), size(0), version(0) {}
+};
+
+UniformBufferPtr
+UniformBuffer::Create(CreationContextPtr& aContext, const GLsizeiptr aSize) {
+  UniformBufferPtr result = std::make_shared<ConcreteClass<UniformBuffer, UniformBuffer::State> >(aContext);
+  result->m.size = aSize;
+  result->m.shadow = std::make_unique<uint8_t[]>(aSize);
+  return result;
+}
+
+GLsizeiptr
+UniformBuffer::GetSize() const {
+  return m.size;
+}
+
+bool
+UniformBuffer::Update(const void* aData) {
+  return Update(aData, 0);
+}
+
+bool
+UniformBuffer::Update(const void* aData, const uint32_t aVersion) {
+  if (m.buffer && (aVersion != 0) && (aVersion == m.version)) {
+    return false;
+  }
+  m.version = aVersion;
+  if (m.buffer && (memcmp(m.shadow.get(), aData, m.size) == 0)) {
+    return false;
+  }
+  if (!m.buffer) {
+    VRB_GL_CHECK(glGenBuffers(1, &m.buffer));
+    VRB_GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, m.buffer));
+    VRB_GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, m.size, aData, GL_DYNAMIC_DRAW));
+  } else {
+    VRB_GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, m.buffer));
+    VRB_GL_CHECK(glBufferSubData(GL_UNIFORM_BUFFER, 0, m.size, aData));
+  }
+  VRB_GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+  memcpy(m.shadow.get(), aData, m.size);
+  return true;
+}
+
+uint32_t
+UniformBuffer::GetVersion() const {
+  return m.buffer ? m.version : 0;
+}
+
+void
+UniformBuffer::Bind(const GLuint aBindingPoint) {
+  if (m.buffer) {
+    VRB_GL_CHECK(glBindBufferBase(GL_UNIFORM_BUFFER, aBindingPoint, m.buffer));
+  }
+}
+
+UniformBuffer::UniformBuffer(State& aState, CreationContextPtr& aContext) : ResourceGL(aState, aContext), m(aState) {}
+UniformBuffer::~UniformBuffer() {}
+
+void
+UniformBuffer::InitializeGL() {
+  // The buffer is created on the first Update.
+}
+
+void
+UniformBuffer::ShutdownGL() {
+  if (m.buffer) {
+    VRB_GL_CHECK(glDeleteBuffers(1, &m.buffer));
+    m.buffer = 0;
+    m.version = 0;
+  }
+}
+
+} // namespace vrb
@@ -9,8 +9,13 @@
 #include "vrb/Color.h"
 #include "vrb/Vector.h"
 
+#include <atomic>
 #include <vector>
 
+namespace {
+std::atomic<uint32_t> sPositionGeneration(0);
+}
+
 namespace vrb {
 
 const int DEFAULT_UV_LENGTH = 2;
@@ -27,6 +32,7 @@ struct VertexArray::State {
   std::vector<NormalState> normals;
   std::vector<Vector> uvs;
   std::vector<Color> colors;
+  uint32_t positionVersion = ++sPositionGeneration;
 };
 
 VertexArrayPtr
@@ -122,6 +128,7 @@ VertexArray::SetVertex(const int aIndex, const Vector& aPoint) {
     m.vertices.resize(aIndex + 1);
   }
   m.vertices[aIndex] = aPoint;
+  m.positionVersion = ++sPositionGeneration;
 }
 
 void
@@ -151,6 +158,7 @@ VertexArray::SetColor(const int aIndex, const Color& aColor) {
 int
 VertexArray::AppendVertex(const Vector& aPoint) {
   m.vertices.push_back(aPoint);
+  m.positionVersion = ++sPositionGeneration;
   return m.vertices.size() - 1;
 }
 
@@ -184,6 +192,16 @@ VertexArray::AppendColor(const Color& aColor) {
   return m.colors.size() - 1;
 }
 
+uint32_t
+VertexArray::GetPositionVersion() const {
+  return m.positionVersion;
+}
+
+uint32_t
+VertexArray::GetPositionGeneration() {
+  return sPositionGeneration.load();
+}
+
 VertexArray::VertexArray(State& aState, CreationContextPtr& aContext) : m(aState) {}
 
 }